@@ -104,6 +104,7 @@
 #define TIOCGPTPEER	_IO('T', 0x41) /* Safely open the slave */
 #define TIOCGISO7816	_IOR('T', 0x42, struct serial_iso7816)
 #define TIOCSISO7816	_IOWR('T', 0x43, struct serial_iso7816)
+#define TIOCSEROOB	_IOW('T', 0x48, int) /* Switch serial port to oob mode */
 
 #define TIOCSERCONFIG	0x5453
 #define TIOCSERGWILD	0x5454
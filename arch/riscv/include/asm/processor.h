@@ -34,6 +34,7 @@ struct thread_struct {
 	unsigned long sp;	/* Kernel mode stack */
 	unsigned long s[12];	/* s[0]: frame pointer */
 	struct __riscv_d_ext_state fstate;
+	int fstate_cpu;		/* CPU whose FP registers match fstate */
 	unsigned long bad_cause;
 };
 
@@ -6,6 +6,7 @@
 #ifndef _ASM_RISCV_SWITCH_TO_H
 #define _ASM_RISCV_SWITCH_TO_H
 
+#include <linux/percpu.h>
 #include <linux/sched/task_stack.h>
 #include <asm/processor.h>
 #include <asm/ptrace.h>
@@ -15,15 +16,39 @@
 extern void __fstate_save(struct task_struct *save_to);
 extern void __fstate_restore(struct task_struct *restore_from);
 
+/* Last task whose FP state was loaded into or saved from this CPU. */
+DECLARE_PER_CPU(struct task_struct *, fstate_last);
+
 static inline void __fstate_clean(struct pt_regs *regs)
 {
 	regs->status = (regs->status & ~SR_FS) | SR_FS_CLEAN;
 }
 
+/*
+ * The FP registers of the current CPU and the saved FP state of
+ * @task are identical.
+ */
+static inline void __fstate_bind(struct task_struct *task)
+{
+	__this_cpu_write(fstate_last, task);
+	task->thread.fstate_cpu = smp_processor_id();
+}
+
+/*
+ * The saved FP state of @task was changed behind its back, it must
+ * be reloaded before @task resumes.
+ */
+static inline void fstate_forget(struct task_struct *task)
+{
+	task->thread.fstate_cpu = -1;
+}
+
 static inline void fstate_off(struct task_struct *task,
 			      struct pt_regs *regs)
 {
 	regs->status = (regs->status & ~SR_FS) | SR_FS_OFF;
+	clear_tsk_thread_flag(task, TIF_FPU_LAZY);
+	fstate_forget(task);
 }
 
 static inline void fstate_save(struct task_struct *task,
@@ -32,6 +57,7 @@ static inline void fstate_save(struct task_struct *task,
 	if ((regs->status & SR_FS) == SR_FS_DIRTY) {
 		__fstate_save(task);
 		__fstate_clean(regs);
+		__fstate_bind(task);
 	}
 }
 
@@ -41,9 +67,35 @@ static inline void fstate_restore(struct task_struct *task,
 	if ((regs->status & SR_FS) != SR_FS_OFF) {
 		__fstate_restore(task);
 		__fstate_clean(regs);
+		__fstate_bind(task);
 	}
 }
 
+/*
+ * Lazy restore: instead of reloading the FP registers of @task when
+ * it is switched in, turn its FP unit off so that its first FP
+ * instruction traps to fstate_restore_lazy(). Tasks which do not use
+ * the FPU until they are switched out again, such as integer-only
+ * control threads preempting each other, never pay for a reload. If
+ * the FP registers of this CPU still hold the state of @task, there
+ * is nothing to reload at all.
+ */
+static inline void fstate_defer(struct task_struct *task,
+				struct pt_regs *regs)
+{
+	if ((regs->status & SR_FS) == SR_FS_OFF)
+		return;
+
+	if (__this_cpu_read(fstate_last) == task &&
+	    task->thread.fstate_cpu == smp_processor_id())
+		return;
+
+	regs->status = (regs->status & ~SR_FS) | SR_FS_OFF;
+	set_tsk_thread_flag(task, TIF_FPU_LAZY);
+}
+
+bool fstate_restore_lazy(struct pt_regs *regs);
+
 static inline void __switch_to_aux(struct task_struct *prev,
 				   struct task_struct *next)
 {
@@ -52,7 +104,7 @@ static inline void __switch_to_aux(struct task_struct *prev,
 	regs = task_pt_regs(prev);
 	if (unlikely(regs->status & SR_SD))
 		fstate_save(prev, regs);
-	fstate_restore(next, task_pt_regs(next));
+	fstate_defer(next, task_pt_regs(next));
 }
 
 extern bool has_fpu;
@@ -60,6 +112,8 @@ extern bool has_fpu;
 #define has_fpu false
 #define fstate_save(task, regs) do { } while (0)
 #define fstate_restore(task, regs) do { } while (0)
+#define fstate_forget(task) do { } while (0)
+#define fstate_restore_lazy(regs) false
 #define __switch_to_aux(__prev, __next) do { } while (0)
 #endif
 
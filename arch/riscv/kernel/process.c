@@ -99,6 +99,35 @@ void start_thread(struct pt_regs *regs, unsigned long pc,
 	regs->sp = sp;
 }
 
+#ifdef CONFIG_FPU
+DEFINE_PER_CPU(struct task_struct *, fstate_last);
+
+/*
+ * Called on illegal instruction traps from user mode, which is what
+ * the first FP instruction of a task causes after fstate_defer() has
+ * turned its FP unit off. Returns true if the FP state of the current
+ * task was reloaded, in which case the faulting instruction should
+ * be restarted.
+ */
+bool fstate_restore_lazy(struct pt_regs *regs)
+{
+	bool ret = false;
+
+	preempt_disable();
+
+	if (test_and_clear_thread_flag(TIF_FPU_LAZY)) {
+		__fstate_restore(current);
+		__fstate_clean(regs);
+		__fstate_bind(current);
+		ret = true;
+	}
+
+	preempt_enable();
+
+	return ret;
+}
+#endif
+
 void flush_thread(void)
 {
 #ifdef CONFIG_FPU
@@ -116,6 +145,7 @@ int arch_dup_task_struct(struct task_struct *dst, struct task_struct *src)
 {
 	fstate_save(src, task_pt_regs(src));
 	*dst = *src;
+	fstate_forget(dst);
 	return 0;
 }
 
@@ -81,6 +81,8 @@ static int riscv_fpr_set(struct task_struct *target,
 					 sizeof(fstate->fcsr));
 	}
 
+	fstate_forget(target);
+
 	return ret;
 }
 #endif
@@ -33,6 +33,7 @@
 #include <asm/sbi.h>
 #include <asm/smp.h>
 #include <asm/alternative.h>
+#include <asm/switch_to.h>
 
 #include "head.h"
 
@@ -161,6 +162,11 @@ asmlinkage __visible void smp_callin(void)
 
 	riscv_clear_ipi();
 
+#ifdef CONFIG_FPU
+	/* Whatever FP state this CPU held did not survive going offline. */
+	per_cpu(fstate_last, curr_cpuid) = NULL;
+#endif
+
 	/* All kernel threads share the same mm context.  */
 	mmgrab(mm);
 	current->active_mm = mm;
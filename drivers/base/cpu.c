@@ -293,6 +293,52 @@ static ssize_t print_cpus_nohz_full(struct device *dev,
 static DEVICE_ATTR(nohz_full, 0444, print_cpus_nohz_full, NULL);
 #endif
 
+#if defined(CONFIG_CPU_ISOLATION) && defined(CONFIG_DOVETAIL)
+static ssize_t print_cpus_oob(struct device *dev,
+			      struct device_attribute *attr, char *buf)
+{
+	return sysfs_emit(buf, "%*pbl\n", cpumask_pr_args(oob_cpu_partition()));
+}
+
+static ssize_t store_cpus_oob(struct device *dev,
+			      struct device_attribute *attr,
+			      const char *buf, size_t count)
+{
+	cpumask_var_t oob;
+	int ret;
+
+	if (!alloc_cpumask_var(&oob, GFP_KERNEL))
+		return -ENOMEM;
+
+	ret = cpulist_parse(buf, oob);
+	if (!ret)
+		ret = oob_cpu_partition_set(oob);
+
+	free_cpumask_var(oob);
+
+	return ret ? ret : count;
+}
+static DEVICE_ATTR(oob, 0644, print_cpus_oob, store_cpus_oob);
+
+static ssize_t print_oob_intrusions(struct device *dev,
+				    struct device_attribute *attr, char *buf)
+{
+	struct oob_cpu_intrusions oi;
+	int cpu, len = 0;
+
+	for_each_cpu(cpu, oob_cpu_partition()) {
+		oob_cpu_intrusions(cpu, &oi);
+		len += sysfs_emit_at(buf, len,
+				     "%d irqs=%u kthreads=%u tick=%d timers=%d rcu=%d unbound_wq=%d\n",
+				     cpu, oi.irqs, oi.kthreads, oi.tick,
+				     oi.timers, oi.rcu, oi.unbound_wq);
+	}
+
+	return len;
+}
+static DEVICE_ATTR(oob_intrusions, 0444, print_oob_intrusions, NULL);
+#endif
+
 static void cpu_device_release(struct device *dev)
 {
 	/*
@@ -469,6 +515,10 @@ static struct attribute *cpu_root_attrs[] = {
 #ifdef CONFIG_NO_HZ_FULL
 	&dev_attr_nohz_full.attr,
 #endif
+#if defined(CONFIG_CPU_ISOLATION) && defined(CONFIG_DOVETAIL)
+	&dev_attr_oob.attr,
+	&dev_attr_oob_intrusions.attr,
+#endif
 #ifdef CONFIG_GENERIC_CPU_AUTOPROBE
 	&dev_attr_modalias.attr,
 #endif
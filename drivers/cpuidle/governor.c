@@ -10,6 +10,7 @@
 
 #include <linux/cpu.h>
 #include <linux/cpuidle.h>
+#include <linux/irq_pipeline.h>
 #include <linux/mutex.h>
 #include <linux/module.h>
 #include <linux/pm_qos.h>
@@ -118,3 +119,36 @@ s64 cpuidle_governor_latency_req(unsigned int cpu)
 
 	return (s64)device_req * NSEC_PER_USEC;
 }
+
+#ifdef CONFIG_IRQ_PIPELINE
+/**
+ * cpuidle_governor_oob_req - Apply the constraints of the out-of-band stage
+ * @dev: Target cpuidle device
+ * @latency_req: Exit latency constraint in ns, lowered if need be
+ * @sleep_length_ns: Expected sleep length in ns, capped if need be
+ *
+ * The next out-of-band timer on @dev->cpu wakes it up like any in-band
+ * timer would, which bounds the sleep length. On top of this, the exit
+ * latency of the idle state delays the handling of that timer, so it
+ * must not exceed what the companion core can absorb. Applying both
+ * constraints leads the governor to pick the deepest state which still
+ * meets the out-of-band wake-up deadline.
+ */
+void cpuidle_governor_oob_req(struct cpuidle_device *dev,
+			      s64 *latency_req, s64 *sleep_length_ns)
+{
+	ktime_t expiry;
+	s64 slack_ns, delta;
+
+	expiry = irq_cpuidle_oob_deadline(dev, &slack_ns);
+	if (expiry == KTIME_MAX)
+		return;
+
+	delta = max_t(s64, ktime_to_ns(ktime_sub(expiry, ktime_get())), 0);
+	if (delta < *sleep_length_ns)
+		*sleep_length_ns = delta;
+
+	if (slack_ns < *latency_req)
+		*latency_req = max_t(s64, slack_ns, 0);
+}
+#endif
@@ -285,6 +285,8 @@ static int menu_select(struct cpuidle_driver *drv, struct cpuidle_device *dev,
 		delta = 0;
 		delta_tick = 0;
 	}
+	/* The next oob timer may come first. */
+	cpuidle_governor_oob_req(dev, &latency_req, &delta);
 	data->next_timer_ns = delta;
 
 	nr_iowaiters = nr_iowait_cpu(dev->cpu);
@@ -253,6 +253,8 @@ static int teo_select(struct cpuidle_driver *drv, struct cpuidle_device *dev,
 	cpu_data->time_span_ns = local_clock();
 
 	duration_ns = tick_nohz_get_sleep_length(&delta_tick);
+	/* The next oob timer may come first. */
+	cpuidle_governor_oob_req(dev, &latency_req, &duration_ns);
 	cpu_data->sleep_length_ns = duration_ns;
 
 	hits = 0;
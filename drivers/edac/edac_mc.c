@@ -256,6 +256,10 @@ static void mci_release(struct device *dev)
 		}
 		kfree(mci->csrows);
 	}
+
+	if (mci->scrub)
+		edac_scrub_free(mci);
+
 	kfree(mci);
 }
 
@@ -734,6 +738,9 @@ int edac_mc_add_mc_with_groups(struct mem_ctl_info *mci,
 		mci->op_state = OP_RUNNING_INTERRUPT;
 	}
 
+	if (mci->scrub)
+		edac_scrub_start(mci);
+
 	/* Report action taken */
 	edac_mc_printk(mci, KERN_INFO,
 		"Giving out device to module %s controller %s: DEV %s (%s)\n",
@@ -780,6 +787,9 @@ struct mem_ctl_info *edac_mc_del_mc(struct device *dev)
 	if (mci->edac_check)
 		edac_stop_work(&mci->work);
 
+	if (mci->scrub)
+		edac_scrub_stop(mci);
+
 	/* remove from sysfs */
 	edac_remove_sysfs_mci_device(mci);
 
@@ -936,6 +946,13 @@ static void edac_ce_error(struct edac_raw_error_desc *e)
 			e->page_frame_number;
 
 		edac_mc_scrub_block(remapped_page, e->offset_in_page, e->grain);
+	} else if (mci->scrub && e->page_frame_number) {
+		/* The software patrol only reads, have it fix the page. */
+		remapped_page = mci->ctl_page_to_phys ?
+			mci->ctl_page_to_phys(mci, e->page_frame_number) :
+			e->page_frame_number;
+
+		edac_scrub_queue_ce(mci, remapped_page);
 	}
 }
 
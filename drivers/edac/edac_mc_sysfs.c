@@ -891,6 +891,9 @@ static const struct attribute_group mci_attr_grp = {
 
 static const struct attribute_group *mci_attr_groups[] = {
 	&mci_attr_grp,
+#ifdef CONFIG_EDAC_SCRUB
+	&edac_scrub_attr_grp,
+#endif
 	NULL
 };
 
@@ -61,6 +61,23 @@ extern void edac_mc_reset_delay_period(unsigned long value);
 
 extern void *edac_align_ptr(void **p, unsigned size, int n_elems);
 
+/*
+ * EDAC software scrubber functions
+ */
+#ifdef CONFIG_EDAC_SCRUB
+void edac_scrub_start(struct mem_ctl_info *mci);
+void edac_scrub_stop(struct mem_ctl_info *mci);
+void edac_scrub_free(struct mem_ctl_info *mci);
+void edac_scrub_queue_ce(struct mem_ctl_info *mci, unsigned long pfn);
+extern const struct attribute_group edac_scrub_attr_grp;
+#else
+static inline void edac_scrub_start(struct mem_ctl_info *mci)		{ }
+static inline void edac_scrub_stop(struct mem_ctl_info *mci)		{ }
+static inline void edac_scrub_free(struct mem_ctl_info *mci)		{ }
+static inline void edac_scrub_queue_ce(struct mem_ctl_info *mci,
+				       unsigned long pfn)		{ }
+#endif
+
 /*
  * EDAC debugfs functions
  */
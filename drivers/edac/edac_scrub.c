@@ -0,0 +1,423 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * EDAC software memory scrubber
+ *
+ * Patrols the page ranges described by the csrows of a memory
+ * controller, a chunk at a time from an unbound workqueue, at a rate
+ * set through the sdram_scrub_rate attribute of the controller. The
+ * patrol only reads memory, so that the ECC logic gets a chance to
+ * detect errors in lines nobody uses. A page is rewritten only once a
+ * correctable error is reported on it, which stores the corrected
+ * contents back to memory upon eviction of the dirtied lines.
+ *
+ * Reserved pages, device memory and pages removed from the direct map
+ * are skipped altogether.
+ *
+ * Chunks are deferred while any CPU has runnable oob threads, so that
+ * the patrol does not compete with the real-time side for the memory
+ * bus.
+ */
+
+#include <linux/atomic.h>
+#include <linux/cpumask.h>
+#include <linux/dovetail.h>
+#include <linux/highmem.h>
+#include <linux/jiffies.h>
+#include <linux/sched.h>
+#include <linux/sched/clock.h>
+#include <linux/set_memory.h>
+#include <linux/slab.h>
+
+#ifdef CONFIG_EDAC_ATOMIC_SCRUB
+#include <asm/edac.h>
+#endif
+
+#include "edac_module.h"
+#include "edac_scrub.h"
+
+/* Upper bound of a chunk, whatever the scrub rate. */
+#define EDAC_SCRUB_MAX_CHUNK_PAGES	(SZ_1M >> PAGE_SHIFT)
+
+/* Deferral of a chunk when the oob stage is busy. */
+#define EDAC_SCRUB_BACKOFF_MSEC		10
+
+static struct page *edac_scrub_pfn_to_page(unsigned long pfn)
+{
+	struct page *pg;
+
+	if (!pfn_valid(pfn))
+		return NULL;
+
+	pg = pfn_to_page(pfn);
+
+	/* Kernel image, memmap, firmware and device-owned memory. */
+	if (PageReserved(pg) || is_zone_device_page(pg))
+		return NULL;
+
+	if (!kernel_page_present(pg))
+		return NULL;
+
+	return pg;
+}
+
+static void edac_scrub_page(struct page *pg, bool rewrite)
+{
+	unsigned long flags = 0, off;
+	void *virt_addr;
+
+	if (PageHighMem(pg))
+		local_irq_save(flags);
+
+	virt_addr = kmap_atomic(pg);
+
+	if (!rewrite) {
+		for (off = 0; off < PAGE_SIZE; off += L1_CACHE_BYTES)
+			READ_ONCE(*(unsigned long *)(virt_addr + off));
+	} else {
+#ifdef CONFIG_EDAC_ATOMIC_SCRUB
+		edac_atomic_scrub(virt_addr, PAGE_SIZE);
+#else
+		/*
+		 * Atomically rewriting one word per line dirties the
+		 * whole line, which is eventually written back with its
+		 * corrected contents.
+		 */
+		for (off = 0; off < PAGE_SIZE; off += L1_CACHE_BYTES)
+			atomic_long_add(0, (atomic_long_t *)(virt_addr + off));
+#endif
+	}
+
+	kunmap_atomic(virt_addr);
+
+	if (PageHighMem(pg))
+		local_irq_restore(flags);
+}
+
+static bool edac_scrub_row_populated(struct csrow_info *csrow)
+{
+	int i;
+
+	if (csrow->last_page < csrow->first_page)
+		return false;
+
+	for (i = 0; i < csrow->nr_channels; i++)
+		if (csrow->channels[i]->dimm->nr_pages)
+			return true;
+
+	return false;
+}
+
+static bool edac_scrub_oob_busy(void)
+{
+	int cpu;
+
+	if (!IS_ENABLED(CONFIG_DOVETAIL))
+		return false;
+
+	for_each_online_cpu(cpu)
+		if (oob_cpu_busy(cpu))
+			return true;
+
+	return false;
+}
+
+/*
+ * Scrub up to @nr_pages from the current position, moving to the next
+ * populated csrow as needed. Returns the number of pages scrubbed.
+ */
+static unsigned long edac_scrub_pages(struct edac_scrub *scrub,
+				      unsigned long nr_pages)
+{
+	struct mem_ctl_info *mci = scrub->mci;
+	unsigned long done = 0;
+	struct csrow_info *csrow;
+	unsigned int skipped = 0;
+	struct page *pg;
+
+	while (done < nr_pages) {
+		csrow = mci->csrows[scrub->row];
+
+		if (!edac_scrub_row_populated(csrow) ||
+		    scrub->pfn > csrow->last_page) {
+			if (++scrub->row >= mci->nr_csrows) {
+				scrub->row = 0;
+				scrub->passes++;
+			}
+			scrub->pfn = mci->csrows[scrub->row]->first_page;
+			/* Nothing to scrub, edac_scrub_init() should have said so. */
+			if (++skipped > mci->nr_csrows)
+				break;
+			continue;
+		}
+
+		skipped = 0;
+
+		if (scrub->pfn < csrow->first_page)
+			scrub->pfn = csrow->first_page;
+
+		pg = edac_scrub_pfn_to_page(scrub->pfn);
+		if (pg)
+			edac_scrub_page(pg, false);
+
+		scrub->pfn++;
+		done++;
+
+		cond_resched();
+	}
+
+	return done;
+}
+
+/* Rewrite the pages correctable errors were reported on. */
+static void edac_scrub_ce_work(struct work_struct *work)
+{
+	struct edac_scrub *scrub = container_of(work, struct edac_scrub,
+						ce_work);
+	unsigned long pfns[EDAC_SCRUB_CE_PFNS];
+	unsigned int i, nr;
+	struct page *pg;
+
+	spin_lock_irq(&scrub->ce_lock);
+	nr = scrub->nr_ce;
+	memcpy(pfns, scrub->ce_pfns, nr * sizeof(pfns[0]));
+	scrub->nr_ce = 0;
+	spin_unlock_irq(&scrub->ce_lock);
+
+	for (i = 0; i < nr; i++) {
+		pg = edac_scrub_pfn_to_page(pfns[i]);
+		if (!pg)
+			continue;
+
+		edac_scrub_page(pg, true);
+		scrub->rewrites++;
+	}
+}
+
+/* Called by edac_mc_handle_error() for correctable errors. */
+void edac_scrub_queue_ce(struct mem_ctl_info *mci, unsigned long pfn)
+{
+	struct edac_scrub *scrub = mci->scrub;
+	unsigned long flags;
+	unsigned int i;
+
+	if (!READ_ONCE(scrub->started))
+		return;
+
+	spin_lock_irqsave(&scrub->ce_lock, flags);
+
+	for (i = 0; i < scrub->nr_ce; i++)
+		if (scrub->ce_pfns[i] == pfn)
+			goto out;
+
+	/* Dropped pages are reported again on the next patrol. */
+	if (scrub->nr_ce < EDAC_SCRUB_CE_PFNS)
+		scrub->ce_pfns[scrub->nr_ce++] = pfn;
+out:
+	spin_unlock_irqrestore(&scrub->ce_lock, flags);
+
+	queue_work(scrub->wq, &scrub->ce_work);
+}
+
+static void edac_scrub_work(struct work_struct *work)
+{
+	struct edac_scrub *scrub = container_of(to_delayed_work(work),
+						struct edac_scrub, work);
+	unsigned long nr_pages, done, delay;
+	u32 bandwidth;
+	u64 start;
+
+	bandwidth = READ_ONCE(scrub->bandwidth);
+	if (!bandwidth)
+		return;
+
+	if (edac_scrub_oob_busy()) {
+		scrub->throttled++;
+		queue_delayed_work(scrub->wq, &scrub->work,
+				   msecs_to_jiffies(EDAC_SCRUB_BACKOFF_MSEC));
+		return;
+	}
+
+	/* Scrub what the rate allows per tick, in whole pages. */
+	nr_pages = DIV_ROUND_UP(bandwidth, HZ) >> PAGE_SHIFT;
+	nr_pages = clamp_t(unsigned long, nr_pages, 1,
+			   EDAC_SCRUB_MAX_CHUNK_PAGES);
+
+	start = local_clock();
+	done = edac_scrub_pages(scrub, nr_pages);
+	scrub->cpu_ns += local_clock() - start;
+	scrub->bytes += (u64)done << PAGE_SHIFT;
+
+	delay = DIV_ROUND_UP_ULL((u64)nr_pages * PAGE_SIZE * HZ, bandwidth);
+	queue_delayed_work(scrub->wq, &scrub->work, max(delay, 1UL));
+}
+
+static int edac_scrub_set_rate(struct mem_ctl_info *mci, u32 bandwidth)
+{
+	struct edac_scrub *scrub = mci->scrub;
+
+	mutex_lock(&scrub->lock);
+
+	WRITE_ONCE(scrub->bandwidth, bandwidth);
+	if (scrub->started && bandwidth)
+		mod_delayed_work(scrub->wq, &scrub->work, 0);
+
+	mutex_unlock(&scrub->lock);
+
+	return bandwidth;
+}
+
+static int edac_scrub_get_rate(struct mem_ctl_info *mci)
+{
+	return READ_ONCE(mci->scrub->bandwidth);
+}
+
+int edac_scrub_init(struct mem_ctl_info *mci, u32 bandwidth)
+{
+	struct edac_scrub *scrub;
+	unsigned int row;
+
+	for (row = 0; row < mci->nr_csrows; row++)
+		if (edac_scrub_row_populated(mci->csrows[row]))
+			break;
+
+	if (row >= mci->nr_csrows)
+		return -EINVAL;
+
+	scrub = kzalloc(sizeof(*scrub), GFP_KERNEL);
+	if (!scrub)
+		return -ENOMEM;
+
+	scrub->wq = alloc_workqueue("edac-scrub%d",
+				    WQ_UNBOUND | WQ_FREEZABLE, 1, mci->mc_idx);
+	if (!scrub->wq) {
+		kfree(scrub);
+		return -ENOMEM;
+	}
+
+	scrub->mci = mci;
+	mutex_init(&scrub->lock);
+	INIT_DELAYED_WORK(&scrub->work, edac_scrub_work);
+	spin_lock_init(&scrub->ce_lock);
+	INIT_WORK(&scrub->ce_work, edac_scrub_ce_work);
+	scrub->bandwidth = bandwidth;
+	scrub->row = row;
+	scrub->pfn = mci->csrows[row]->first_page;
+
+	mci->scrub = scrub;
+	mci->scrub_cap |= SCRUB_FLAG_SW_PROG | SCRUB_FLAG_SW_TUN;
+	mci->scrub_mode = SCRUB_SW_TUNABLE;
+	mci->set_sdram_scrub_rate = edac_scrub_set_rate;
+	mci->get_sdram_scrub_rate = edac_scrub_get_rate;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(edac_scrub_init);
+
+/* Called by edac_mc_add_mc() once the controller is online. */
+void edac_scrub_start(struct mem_ctl_info *mci)
+{
+	struct edac_scrub *scrub = mci->scrub;
+
+	mutex_lock(&scrub->lock);
+
+	WRITE_ONCE(scrub->started, true);
+	if (scrub->bandwidth)
+		queue_delayed_work(scrub->wq, &scrub->work, 0);
+
+	mutex_unlock(&scrub->lock);
+}
+
+/* Called by edac_mc_del_mc(). */
+void edac_scrub_stop(struct mem_ctl_info *mci)
+{
+	struct edac_scrub *scrub = mci->scrub;
+
+	mutex_lock(&scrub->lock);
+	WRITE_ONCE(scrub->started, false);
+	mutex_unlock(&scrub->lock);
+
+	cancel_delayed_work_sync(&scrub->work);
+	cancel_work_sync(&scrub->ce_work);
+}
+
+/* Called when the controller is released. */
+void edac_scrub_free(struct mem_ctl_info *mci)
+{
+	struct edac_scrub *scrub = mci->scrub;
+
+	destroy_workqueue(scrub->wq);
+	kfree(scrub);
+	mci->scrub = NULL;
+}
+
+#define to_mci(k) container_of(k, struct mem_ctl_info, dev)
+
+static ssize_t scrub_passes_show(struct device *dev,
+				 struct device_attribute *mattr, char *data)
+{
+	struct mem_ctl_info *mci = to_mci(dev);
+
+	return sprintf(data, "%llu\n", READ_ONCE(mci->scrub->passes));
+}
+
+static ssize_t scrub_bytes_show(struct device *dev,
+				struct device_attribute *mattr, char *data)
+{
+	struct mem_ctl_info *mci = to_mci(dev);
+
+	return sprintf(data, "%llu\n", READ_ONCE(mci->scrub->bytes));
+}
+
+static ssize_t scrub_throttled_show(struct device *dev,
+				    struct device_attribute *mattr, char *data)
+{
+	struct mem_ctl_info *mci = to_mci(dev);
+
+	return sprintf(data, "%llu\n", READ_ONCE(mci->scrub->throttled));
+}
+
+static ssize_t scrub_rewrites_show(struct device *dev,
+				   struct device_attribute *mattr, char *data)
+{
+	struct mem_ctl_info *mci = to_mci(dev);
+
+	return sprintf(data, "%llu\n", READ_ONCE(mci->scrub->rewrites));
+}
+
+static ssize_t scrub_cpu_time_us_show(struct device *dev,
+				      struct device_attribute *mattr,
+				      char *data)
+{
+	struct mem_ctl_info *mci = to_mci(dev);
+
+	return sprintf(data, "%llu\n",
+		       div_u64(READ_ONCE(mci->scrub->cpu_ns), NSEC_PER_USEC));
+}
+
+static DEVICE_ATTR_RO(scrub_passes);
+static DEVICE_ATTR_RO(scrub_bytes);
+static DEVICE_ATTR_RO(scrub_throttled);
+static DEVICE_ATTR_RO(scrub_rewrites);
+static DEVICE_ATTR_RO(scrub_cpu_time_us);
+
+static struct attribute *edac_scrub_attrs[] = {
+	&dev_attr_scrub_passes.attr,
+	&dev_attr_scrub_bytes.attr,
+	&dev_attr_scrub_throttled.attr,
+	&dev_attr_scrub_rewrites.attr,
+	&dev_attr_scrub_cpu_time_us.attr,
+	NULL
+};
+
+static umode_t edac_scrub_attr_is_visible(struct kobject *kobj,
+					  struct attribute *attr, int idx)
+{
+	struct mem_ctl_info *mci = to_mci(kobj_to_dev(kobj));
+
+	return mci->scrub ? attr->mode : 0;
+}
+
+const struct attribute_group edac_scrub_attr_grp = {
+	.attrs	= edac_scrub_attrs,
+	.is_visible = edac_scrub_attr_is_visible,
+};
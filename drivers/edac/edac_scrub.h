@@ -0,0 +1,92 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Defines, structures, APIs for the EDAC software memory scrubber
+ *
+ * The scrubber patrols the csrows of a memory controller in the
+ * background, reading every cache line so that the ECC logic detects
+ * single-bit upsets before they accumulate into uncorrectable errors.
+ * Pages correctable errors are reported on are rewritten with their
+ * corrected contents. Each csrow describes a scrubbed region by its
+ * [first_page, last_page] range.
+ */
+
+#ifndef _EDAC_SCRUB_H_
+#define _EDAC_SCRUB_H_
+
+#include <linux/edac.h>
+#include <linux/mutex.h>
+#include <linux/spinlock.h>
+#include <linux/types.h>
+#include <linux/workqueue.h>
+
+/* Pages waiting for a rewrite, further reports are dropped. */
+#define EDAC_SCRUB_CE_PFNS	16
+
+/**
+ * struct edac_scrub - software scrubber state of a memory controller
+ * @mci:	the memory controller being scrubbed
+ * @wq:		workqueue running the patrol
+ * @work:	patrol work, scrubbing one chunk per run
+ * @lock:	serializes @bandwidth updates and start/stop requests
+ * @bandwidth:	scrub rate in bytes/sec, 0 if disabled
+ * @started:	set while the memory controller is online
+ * @row:	csrow the patrol resumes from
+ * @pfn:	page frame the patrol resumes from
+ * @ce_work:	rewrites the pages listed in @ce_pfns
+ * @ce_lock:	protects @ce_pfns and @nr_ce
+ * @ce_pfns:	page frames correctable errors were reported on
+ * @nr_ce:	number of entries in @ce_pfns
+ * @passes:	number of complete patrols over all csrows
+ * @bytes:	number of bytes scrubbed
+ * @throttled:	number of chunks deferred due to oob activity
+ * @rewrites:	number of pages rewritten after a correctable error
+ * @cpu_ns:	time spent scrubbing, in nanoseconds
+ */
+struct edac_scrub {
+	struct mem_ctl_info *mci;
+	struct workqueue_struct *wq;
+	struct delayed_work work;
+	struct mutex lock;
+	u32 bandwidth;
+	bool started;
+
+	unsigned int row;
+	unsigned long pfn;
+
+	struct work_struct ce_work;
+	spinlock_t ce_lock;
+	unsigned long ce_pfns[EDAC_SCRUB_CE_PFNS];
+	unsigned int nr_ce;
+
+	u64 passes;
+	u64 bytes;
+	u64 throttled;
+	u64 rewrites;
+	u64 cpu_ns;
+};
+
+#ifdef CONFIG_EDAC_SCRUB
+
+/**
+ * edac_scrub_init() - enable software scrubbing of a memory controller
+ * @mci:	memory controller, with the page ranges of its csrows set
+ * @bandwidth:	initial scrub rate in bytes/sec, 0 to start disabled
+ *
+ * Must be called before edac_mc_add_mc(). Scrubbing runs while the
+ * controller is registered, its rate may be changed through the
+ * sdram_scrub_rate sysfs attribute.
+ *
+ * Returns 0 on success, a negative error code otherwise.
+ */
+int edac_scrub_init(struct mem_ctl_info *mci, u32 bandwidth);
+
+#else
+
+static inline int edac_scrub_init(struct mem_ctl_info *mci, u32 bandwidth)
+{
+	return -EOPNOTSUPP;
+}
+
+#endif /* CONFIG_EDAC_SCRUB */
+
+#endif /* _EDAC_SCRUB_H_ */
@@ -8,8 +8,10 @@
  *
  */
 #include <linux/edac.h>
+#include <linux/ioport.h>
 #include <linux/platform_device.h>
 #include "edac_module.h"
+#include "edac_scrub.h"
 #include <soc/sifive/sifive_l2_cache.h>
 
 #define DRVNAME "sifive_edac"
@@ -17,8 +19,137 @@
 struct sifive_edac_priv {
 	struct notifier_block notifier;
 	struct edac_device_ctl_info *dci;
+	struct mem_ctl_info *mci;
 };
 
+#ifdef CONFIG_EDAC_SCRUB
+
+static unsigned int scrub_rate = SZ_1M;
+module_param(scrub_rate, uint, 0444);
+MODULE_PARM_DESC(scrub_rate, "Initial DRAM scrub rate in bytes/sec, 0 to disable");
+
+struct ram_region_iter {
+	struct mem_ctl_info *mci;
+	unsigned int row;
+};
+
+static int count_ram_region(struct resource *res, void *arg)
+{
+	unsigned int *nr_regions = arg;
+
+	(*nr_regions)++;
+
+	return 0;
+}
+
+static int init_ram_region(struct resource *res, void *arg)
+{
+	struct ram_region_iter *iter = arg;
+	unsigned long first_page, last_page;
+	struct csrow_info *csrow;
+	struct dimm_info *dimm;
+
+	if (iter->row >= iter->mci->nr_csrows)
+		return -ENOSPC;
+
+	first_page = PFN_UP(res->start);
+	last_page = PFN_DOWN(res->end + 1);
+	if (last_page <= first_page)
+		return 0;
+
+	csrow = iter->mci->csrows[iter->row++];
+	csrow->first_page = first_page;
+	csrow->last_page = last_page - 1;
+
+	dimm = csrow->channels[0]->dimm;
+	dimm->nr_pages = last_page - first_page;
+	dimm->grain = L1_CACHE_BYTES;
+	dimm->mtype = MEM_UNKNOWN;
+	dimm->dtype = DEV_UNKNOWN;
+	dimm->edac_mode = EDAC_SECDED;
+
+	return 0;
+}
+
+/*
+ * Expose each System RAM range as a csrow of a memory controller, for
+ * the software scrubber to patrol. L2 ECC errors are faults of the cache
+ * SRAM, not of DRAM, so they are only reported on the device controller.
+ */
+static int ecc_register_mc(struct platform_device *pdev,
+			   struct sifive_edac_priv *p)
+{
+	struct ram_region_iter iter = { .row = 0 };
+	struct edac_mc_layer layers[1];
+	unsigned int nr_regions = 0;
+	struct mem_ctl_info *mci;
+	int ret;
+
+	walk_system_ram_res(0, -1, &nr_regions, count_ram_region);
+	if (!nr_regions)
+		return -ENODEV;
+
+	layers[0].type = EDAC_MC_LAYER_CHIP_SELECT;
+	layers[0].size = nr_regions;
+	layers[0].is_virt_csrow = true;
+
+	mci = edac_mc_alloc(0, ARRAY_SIZE(layers), layers, 0);
+	if (!mci)
+		return -ENOMEM;
+
+	mci->pdev = &pdev->dev;
+	mci->edac_ctl_cap = EDAC_FLAG_SECDED;
+	mci->edac_cap = EDAC_FLAG_SECDED;
+	mci->mod_name = "Sifive ECC Manager";
+	mci->ctl_name = "sifive_dram";
+	mci->dev_name = dev_name(&pdev->dev);
+
+	iter.mci = mci;
+	walk_system_ram_res(0, -1, &iter, init_ram_region);
+
+	ret = edac_scrub_init(mci, scrub_rate);
+	if (ret)
+		goto err;
+
+	ret = edac_mc_add_mc(mci);
+	if (ret)
+		goto err;
+
+	p->mci = mci;
+
+	return 0;
+
+err:
+	edac_mc_free(mci);
+
+	return ret;
+}
+
+static void ecc_unregister_mc(struct platform_device *pdev,
+			      struct sifive_edac_priv *p)
+{
+	if (!p->mci)
+		return;
+
+	edac_mc_del_mc(&pdev->dev);
+	edac_mc_free(p->mci);
+}
+
+#else
+
+static inline int ecc_register_mc(struct platform_device *pdev,
+				  struct sifive_edac_priv *p)
+{
+	return 0;
+}
+
+static inline void ecc_unregister_mc(struct platform_device *pdev,
+				     struct sifive_edac_priv *p)
+{
+}
+
+#endif /* CONFIG_EDAC_SCRUB */
+
 /**
  * EDAC error callback
  *
@@ -67,6 +198,9 @@ static int ecc_register(struct platform_device *pdev)
 		goto err;
 	}
 
+	if (ecc_register_mc(pdev, p))
+		dev_warn(&pdev->dev, "DRAM scrubbing unavailable\n");
+
 	register_sifive_l2_error_notifier(&p->notifier);
 
 	return 0;
@@ -82,6 +216,7 @@ static int ecc_unregister(struct platform_device *pdev)
 	struct sifive_edac_priv *p = platform_get_drvdata(pdev);
 
 	unregister_sifive_l2_error_notifier(&p->notifier);
+	ecc_unregister_mc(pdev, p);
 	edac_device_del_device(&pdev->dev);
 	edac_device_free_ctl_info(p->dci);
 
@@ -106,6 +106,11 @@ struct dwapb_gpio {
 	struct dwapb_gpio_port	*ports;
 	unsigned int		nr_ports;
 	unsigned int		flags;
+	/*
+	 * Serializes accesses to the interrupt registers, which the
+	 * irqchip handlers may perform from the out-of-band stage.
+	 */
+	hard_spinlock_t		irq_lock;
 	struct reset_control	*rst;
 	struct clk_bulk_data	clks[DWAPB_NR_CLOCKS];
 };
@@ -231,9 +236,9 @@ static void dwapb_irq_ack(struct irq_data *d)
 	u32 val = BIT(irqd_to_hwirq(d));
 	unsigned long flags;
 
-	spin_lock_irqsave(&gc->bgpio_lock, flags);
+	raw_spin_lock_irqsave(&gpio->irq_lock, flags);
 	dwapb_write(gpio, GPIO_PORTA_EOI, val);
-	spin_unlock_irqrestore(&gc->bgpio_lock, flags);
+	raw_spin_unlock_irqrestore(&gpio->irq_lock, flags);
 }
 
 static void dwapb_irq_mask(struct irq_data *d)
@@ -243,10 +248,10 @@ static void dwapb_irq_mask(struct irq_data *d)
 	unsigned long flags;
 	u32 val;
 
-	spin_lock_irqsave(&gc->bgpio_lock, flags);
+	raw_spin_lock_irqsave(&gpio->irq_lock, flags);
 	val = dwapb_read(gpio, GPIO_INTMASK) | BIT(irqd_to_hwirq(d));
 	dwapb_write(gpio, GPIO_INTMASK, val);
-	spin_unlock_irqrestore(&gc->bgpio_lock, flags);
+	raw_spin_unlock_irqrestore(&gpio->irq_lock, flags);
 }
 
 static void dwapb_irq_unmask(struct irq_data *d)
@@ -256,10 +261,10 @@ static void dwapb_irq_unmask(struct irq_data *d)
 	unsigned long flags;
 	u32 val;
 
-	spin_lock_irqsave(&gc->bgpio_lock, flags);
+	raw_spin_lock_irqsave(&gpio->irq_lock, flags);
 	val = dwapb_read(gpio, GPIO_INTMASK) & ~BIT(irqd_to_hwirq(d));
 	dwapb_write(gpio, GPIO_INTMASK, val);
-	spin_unlock_irqrestore(&gc->bgpio_lock, flags);
+	raw_spin_unlock_irqrestore(&gpio->irq_lock, flags);
 }
 
 static void dwapb_irq_enable(struct irq_data *d)
@@ -269,11 +274,11 @@ static void dwapb_irq_enable(struct irq_data *d)
 	unsigned long flags;
 	u32 val;
 
-	spin_lock_irqsave(&gc->bgpio_lock, flags);
+	raw_spin_lock_irqsave(&gpio->irq_lock, flags);
 	val = dwapb_read(gpio, GPIO_INTEN);
 	val |= BIT(irqd_to_hwirq(d));
 	dwapb_write(gpio, GPIO_INTEN, val);
-	spin_unlock_irqrestore(&gc->bgpio_lock, flags);
+	raw_spin_unlock_irqrestore(&gpio->irq_lock, flags);
 }
 
 static void dwapb_irq_disable(struct irq_data *d)
@@ -283,11 +288,11 @@ static void dwapb_irq_disable(struct irq_data *d)
 	unsigned long flags;
 	u32 val;
 
-	spin_lock_irqsave(&gc->bgpio_lock, flags);
+	raw_spin_lock_irqsave(&gpio->irq_lock, flags);
 	val = dwapb_read(gpio, GPIO_INTEN);
 	val &= ~BIT(irqd_to_hwirq(d));
 	dwapb_write(gpio, GPIO_INTEN, val);
-	spin_unlock_irqrestore(&gc->bgpio_lock, flags);
+	raw_spin_unlock_irqrestore(&gpio->irq_lock, flags);
 }
 
 static int dwapb_irq_set_type(struct irq_data *d, u32 type)
@@ -300,7 +305,7 @@ static int dwapb_irq_set_type(struct irq_data *d, u32 type)
 	if (type & ~IRQ_TYPE_SENSE_MASK)
 		return -EINVAL;
 
-	spin_lock_irqsave(&gc->bgpio_lock, flags);
+	raw_spin_lock_irqsave(&gpio->irq_lock, flags);
 	level = dwapb_read(gpio, GPIO_INTTYPE_LEVEL);
 	polarity = dwapb_read(gpio, GPIO_INT_POLARITY);
 
@@ -335,7 +340,7 @@ static int dwapb_irq_set_type(struct irq_data *d, u32 type)
 	dwapb_write(gpio, GPIO_INTTYPE_LEVEL, level);
 	if (type != IRQ_TYPE_EDGE_BOTH)
 		dwapb_write(gpio, GPIO_INT_POLARITY, polarity);
-	spin_unlock_irqrestore(&gc->bgpio_lock, flags);
+	raw_spin_unlock_irqrestore(&gpio->irq_lock, flags);
 
 	return 0;
 }
@@ -442,6 +447,8 @@ static void dwapb_configure_irqs(struct dwapb_gpio *gpio,
 #endif
 
 	if (!pp->irq_shared) {
+		/* The chained handler may run on the oob stage. */
+		pirq->irqchip.flags = IRQCHIP_PIPELINE_SAFE;
 		girq->num_parents = pirq->nr_irqs;
 		girq->parents = pirq->irq;
 		girq->parent_handler_data = gpio;
@@ -716,6 +723,7 @@ static int dwapb_gpio_probe(struct platform_device *pdev)
 		return err;
 
 	gpio->flags = (uintptr_t)device_get_match_data(dev);
+	raw_spin_lock_init(&gpio->irq_lock);
 
 	for (i = 0; i < gpio->nr_ports; i++) {
 		err = dwapb_gpio_add_port(gpio, &pdata->properties[i], i);
@@ -733,7 +741,7 @@ static int dwapb_gpio_suspend(struct device *dev)
 {
 	struct dwapb_gpio *gpio = dev_get_drvdata(dev);
 	struct gpio_chip *gc	= &gpio->ports[0].gc;
-	unsigned long flags;
+	unsigned long flags, irq_flags;
 	int i;
 
 	spin_lock_irqsave(&gc->bgpio_lock, flags);
@@ -753,6 +761,7 @@ static int dwapb_gpio_suspend(struct device *dev)
 
 		/* Only port A can provide interrupts */
 		if (idx == 0) {
+			raw_spin_lock_irqsave(&gpio->irq_lock, irq_flags);
 			ctx->int_mask	= dwapb_read(gpio, GPIO_INTMASK);
 			ctx->int_en	= dwapb_read(gpio, GPIO_INTEN);
 			ctx->int_pol	= dwapb_read(gpio, GPIO_INT_POLARITY);
@@ -761,6 +770,7 @@ static int dwapb_gpio_suspend(struct device *dev)
 
 			/* Mask out interrupts */
 			dwapb_write(gpio, GPIO_INTMASK, ~ctx->wake_en);
+			raw_spin_unlock_irqrestore(&gpio->irq_lock, irq_flags);
 		}
 	}
 	spin_unlock_irqrestore(&gc->bgpio_lock, flags);
@@ -774,7 +784,7 @@ static int dwapb_gpio_resume(struct device *dev)
 {
 	struct dwapb_gpio *gpio = dev_get_drvdata(dev);
 	struct gpio_chip *gc	= &gpio->ports[0].gc;
-	unsigned long flags;
+	unsigned long flags, irq_flags;
 	int i, err;
 
 	err = clk_bulk_prepare_enable(DWAPB_NR_CLOCKS, gpio->clks);
@@ -800,6 +810,7 @@ static int dwapb_gpio_resume(struct device *dev)
 
 		/* Only port A can provide interrupts */
 		if (idx == 0) {
+			raw_spin_lock_irqsave(&gpio->irq_lock, irq_flags);
 			dwapb_write(gpio, GPIO_INTTYPE_LEVEL, ctx->int_type);
 			dwapb_write(gpio, GPIO_INT_POLARITY, ctx->int_pol);
 			dwapb_write(gpio, GPIO_PORTA_DEBOUNCE, ctx->int_deb);
@@ -808,6 +819,7 @@ static int dwapb_gpio_resume(struct device *dev)
 
 			/* Clear out spurious interrupts */
 			dwapb_write(gpio, GPIO_PORTA_EOI, 0xffffffff);
+			raw_spin_unlock_irqrestore(&gpio->irq_lock, irq_flags);
 		}
 	}
 	spin_unlock_irqrestore(&gc->bgpio_lock, flags);
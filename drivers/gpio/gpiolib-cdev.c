@@ -8,6 +8,7 @@
 #include <linux/compat.h>
 #include <linux/compiler.h>
 #include <linux/device.h>
+#include <linux/dovetail.h>
 #include <linux/err.h>
 #include <linux/file.h>
 #include <linux/gpio.h>
@@ -25,6 +26,7 @@
 #include <linux/uaccess.h>
 #include <linux/workqueue.h>
 #include <uapi/linux/gpio.h>
+#include <dovetail/poll.h>
 
 #include "gpiolib.h"
 #include "gpiolib-cdev.h"
@@ -479,6 +481,9 @@ struct line {
  * the line_seqno is then the same and is cheaper to calculate.
  * @config_mutex: mutex for serializing ioctl() calls to ensure consistency
  * of configuration, particularly multi-step accesses to desc flags.
+ * @oob_lock: hard lock serializing accesses to @oob_events
+ * @oob_events: KFIFO for the GPIO events of lines delivering out-of-band
+ * @oob_poll: poll head signaled by the out-of-band edge handler
  * @lines: the lines held by this line request, with @num_lines elements.
  */
 struct linereq {
@@ -490,6 +495,11 @@ struct linereq {
 	DECLARE_KFIFO_PTR(events, struct gpio_v2_line_event);
 	atomic_t seqno;
 	struct mutex config_mutex;
+#ifdef CONFIG_GPIO_CDEV_OOB
+	hard_spinlock_t oob_lock;
+	DECLARE_KFIFO_PTR(oob_events, struct gpio_v2_line_event);
+	struct oob_poll_head oob_poll;
+#endif
 	struct line lines[];
 };
 
@@ -512,12 +522,19 @@ struct linereq {
 
 #define GPIO_V2_LINE_FLAG_EDGE_BOTH GPIO_V2_LINE_EDGE_FLAGS
 
+#ifdef CONFIG_GPIO_CDEV_OOB
+#define GPIO_V2_LINE_OOB_FLAGS	GPIO_V2_LINE_FLAG_EVENT_OOB
+#else
+#define GPIO_V2_LINE_OOB_FLAGS	0
+#endif
+
 #define GPIO_V2_LINE_VALID_FLAGS \
 	(GPIO_V2_LINE_FLAG_ACTIVE_LOW | \
 	 GPIO_V2_LINE_DIRECTION_FLAGS | \
 	 GPIO_V2_LINE_DRIVE_FLAGS | \
 	 GPIO_V2_LINE_EDGE_FLAGS | \
 	 GPIO_V2_LINE_FLAG_EVENT_CLOCK_REALTIME | \
+	 GPIO_V2_LINE_OOB_FLAGS | \
 	 GPIO_V2_LINE_BIAS_FLAGS)
 
 static void linereq_put_event(struct linereq *lr,
@@ -616,6 +633,120 @@ static irqreturn_t edge_irq_handler(int irq, void *p)
 	return IRQ_WAKE_THREAD;
 }
 
+#ifdef CONFIG_GPIO_CDEV_OOB
+
+static void linereq_put_oob_event(struct linereq *lr,
+				  struct gpio_v2_line_event *le)
+{
+	bool overflow = false;
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&lr->oob_lock, flags);
+	if (kfifo_is_full(&lr->oob_events)) {
+		overflow = true;
+		kfifo_skip(&lr->oob_events);
+	}
+	kfifo_in(&lr->oob_events, le, 1);
+	raw_spin_unlock_irqrestore(&lr->oob_lock, flags);
+	if (!overflow)
+		oob_poll_signal(&lr->oob_poll, EPOLLIN | EPOLLRDNORM);
+}
+
+/* The regular clock accessors are not safe from the oob stage. */
+static u64 line_event_timestamp_oob(struct line *line)
+{
+	if (test_bit(FLAG_EVENT_CLOCK_REALTIME, &line->desc->flags))
+		return ktime_get_real_fast_ns();
+
+	return ktime_get_mono_fast_ns();
+}
+
+/*
+ * Runs from the oob stage, so the whole event is built right here
+ * instead of being deferred to an IRQ thread.
+ */
+static irqreturn_t edge_irq_oob_handler(int irq, void *p)
+{
+	struct line *line = p;
+	struct linereq *lr = line->req;
+	struct gpio_v2_line_event le;
+	u64 eflags;
+
+	/* Do not leak kernel stack to userspace */
+	memset(&le, 0, sizeof(le));
+
+	le.timestamp_ns = line_event_timestamp_oob(line);
+
+	eflags = READ_ONCE(line->eflags);
+	if (eflags == GPIO_V2_LINE_FLAG_EDGE_BOTH) {
+		if (gpiod_get_value(line->desc))
+			le.id = GPIO_V2_LINE_EVENT_RISING_EDGE;
+		else
+			le.id = GPIO_V2_LINE_EVENT_FALLING_EDGE;
+	} else if (eflags == GPIO_V2_LINE_FLAG_EDGE_RISING) {
+		le.id = GPIO_V2_LINE_EVENT_RISING_EDGE;
+	} else if (eflags == GPIO_V2_LINE_FLAG_EDGE_FALLING) {
+		le.id = GPIO_V2_LINE_EVENT_FALLING_EDGE;
+	} else {
+		return IRQ_NONE;
+	}
+	line->line_seqno++;
+	le.line_seqno = line->line_seqno;
+	le.seqno = (lr->num_lines == 1) ?
+		le.line_seqno : atomic_inc_return(&lr->seqno);
+	le.offset = gpio_chip_hwgpio(line->desc);
+
+	linereq_put_oob_event(lr, &le);
+
+	return IRQ_HANDLED;
+}
+
+static int edge_detector_setup_oob(struct line *line, int irq,
+				   unsigned long irqflags)
+{
+	struct linereq *lr = line->req;
+	int ret;
+
+	/* The level of both-edge lines is read from the oob handler. */
+	if (gpiod_cansleep(line->desc))
+		return -EOPNOTSUPP;
+
+	if (!kfifo_initialized(&lr->oob_events)) {
+		ret = kfifo_alloc(&lr->oob_events, lr->event_buffer_size,
+				  GFP_KERNEL);
+		if (ret)
+			return ret;
+	}
+
+	ret = request_irq(irq, edge_irq_oob_handler, irqflags | IRQF_OOB,
+			  lr->label, line);
+	if (ret)
+		return ret;
+
+	line->irq = irq;
+	return 0;
+}
+
+static bool line_event_oob(struct line *line)
+{
+	return test_bit(FLAG_EVENT_OOB, &line->desc->flags);
+}
+
+#else
+
+static inline int edge_detector_setup_oob(struct line *line, int irq,
+					  unsigned long irqflags)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline bool line_event_oob(struct line *line)
+{
+	return false;
+}
+
+#endif /* CONFIG_GPIO_CDEV_OOB */
+
 /*
  * returns the current debounced logical value.
  */
@@ -790,7 +921,8 @@ static int edge_detector_setup(struct line *line,
 	unsigned long irqflags = 0;
 	int irq, ret;
 
-	if (eflags && !kfifo_initialized(&line->req->events)) {
+	if (eflags && !line_event_oob(line) &&
+	    !kfifo_initialized(&line->req->events)) {
 		ret = kfifo_alloc(&line->req->events,
 				  line->req->event_buffer_size, GFP_KERNEL);
 		if (ret)
@@ -819,6 +951,10 @@ static int edge_detector_setup(struct line *line,
 	if (eflags & GPIO_V2_LINE_FLAG_EDGE_FALLING)
 		irqflags |= test_bit(FLAG_ACTIVE_LOW, &line->desc->flags) ?
 			IRQF_TRIGGER_RISING : IRQF_TRIGGER_FALLING;
+
+	if (line_event_oob(line))
+		return edge_detector_setup_oob(line, irq, irqflags);
+
 	irqflags |= IRQF_ONESHOT;
 
 	/* Request a thread to read the events */
@@ -905,6 +1041,11 @@ static int gpio_v2_line_flags_validate(u64 flags)
 	    !(flags & GPIO_V2_LINE_FLAG_INPUT))
 		return -EINVAL;
 
+	/* Out-of-band delivery only applies to edge events. */
+	if ((flags & GPIO_V2_LINE_FLAG_EVENT_OOB) &&
+	    !(flags & GPIO_V2_LINE_EDGE_FLAGS))
+		return -EINVAL;
+
 	/*
 	 * Do not allow OPEN_SOURCE and OPEN_DRAIN flags in a single
 	 * request. If the hardware actually supports enabling both at the
@@ -958,6 +1099,11 @@ static int gpio_v2_line_config_validate(struct gpio_v2_line_config *lc,
 		if (gpio_v2_line_config_debounced(lc, i) &&
 		    !(flags & GPIO_V2_LINE_FLAG_INPUT))
 			return -EINVAL;
+
+		/* the software debouncer is an in-band worker */
+		if (gpio_v2_line_config_debounced(lc, i) &&
+		    (flags & GPIO_V2_LINE_FLAG_EVENT_OOB))
+			return -EINVAL;
 	}
 	return 0;
 }
@@ -992,6 +1138,9 @@ static void gpio_v2_line_config_flags_to_desc_flags(u64 flags,
 
 	assign_bit(FLAG_EVENT_CLOCK_REALTIME, flagsp,
 		   flags & GPIO_V2_LINE_FLAG_EVENT_CLOCK_REALTIME);
+
+	assign_bit(FLAG_EVENT_OOB, flagsp,
+		   flags & GPIO_V2_LINE_FLAG_EVENT_OOB);
 }
 
 static long linereq_get_values(struct linereq *lr, void __user *ip)
@@ -1123,6 +1272,14 @@ static long linereq_set_config_unlocked(struct linereq *lr,
 	bool polarity_change;
 	int ret;
 
+	/* The event delivery stage is set once for all at request time. */
+	for (i = 0; i < lr->num_lines; i++) {
+		flags = gpio_v2_line_config_flags(lc, i);
+		if (line_event_oob(&lr->lines[i]) !=
+		    !!(flags & GPIO_V2_LINE_FLAG_EVENT_OOB))
+			return -EINVAL;
+	}
+
 	for (i = 0; i < lr->num_lines; i++) {
 		desc = lr->lines[i].desc;
 		flags = gpio_v2_line_config_flags(lc, i);
@@ -1275,6 +1432,79 @@ static ssize_t linereq_read(struct file *file,
 	return bytes_read;
 }
 
+#ifdef CONFIG_GPIO_CDEV_OOB
+
+static __poll_t linereq_oob_poll(struct file *file,
+				 struct oob_poll_wait *wait)
+{
+	struct linereq *lr = file->private_data;
+	__poll_t events = 0;
+	unsigned long flags;
+
+	oob_poll_watch(&lr->oob_poll, wait);
+
+	raw_spin_lock_irqsave(&lr->oob_lock, flags);
+	if (!kfifo_is_empty(&lr->oob_events))
+		events = EPOLLIN | EPOLLRDNORM;
+	raw_spin_unlock_irqrestore(&lr->oob_lock, flags);
+
+	return events;
+}
+
+/*
+ * Never blocks, oob callers should wait for EPOLLIN with oob_poll()
+ * when -EAGAIN is returned.
+ */
+static ssize_t linereq_oob_read(struct file *file, char __user *buf,
+				size_t count)
+{
+	struct linereq *lr = file->private_data;
+	struct gpio_v2_line_event le;
+	ssize_t bytes_read = 0;
+	unsigned long flags;
+	int ret;
+
+	if (count < sizeof(le))
+		return -EINVAL;
+
+	if (!access_ok(buf, count))
+		return -EFAULT;
+
+	do {
+		raw_spin_lock_irqsave(&lr->oob_lock, flags);
+		ret = kfifo_out(&lr->oob_events, &le, 1);
+		raw_spin_unlock_irqrestore(&lr->oob_lock, flags);
+		if (ret != 1)
+			break;
+
+		if (raw_copy_to_user(buf + bytes_read, &le, sizeof(le)))
+			return -EFAULT;
+		bytes_read += sizeof(le);
+	} while (count >= bytes_read + sizeof(le));
+
+	return bytes_read ?: -EAGAIN;
+}
+
+static void linereq_init_oob(struct linereq *lr)
+{
+	raw_spin_lock_init(&lr->oob_lock);
+	oob_poll_head_init(&lr->oob_poll);
+}
+
+static void linereq_free_oob(struct linereq *lr)
+{
+	oob_poll_head_destroy(&lr->oob_poll);
+	kfifo_free(&lr->oob_events);
+}
+
+#else
+
+static inline void linereq_init_oob(struct linereq *lr) { }
+
+static inline void linereq_free_oob(struct linereq *lr) { }
+
+#endif /* CONFIG_GPIO_CDEV_OOB */
+
 static void linereq_free(struct linereq *lr)
 {
 	unsigned int i;
@@ -1285,6 +1515,7 @@ static void linereq_free(struct linereq *lr)
 			gpiod_free(lr->lines[i].desc);
 	}
 	kfifo_free(&lr->events);
+	linereq_free_oob(lr);
 	kfree(lr->label);
 	put_device(&lr->gdev->dev);
 	kfree(lr);
@@ -1308,6 +1539,10 @@ static const struct file_operations line_fileops = {
 #ifdef CONFIG_COMPAT
 	.compat_ioctl = linereq_ioctl_compat,
 #endif
+#ifdef CONFIG_GPIO_CDEV_OOB
+	.oob_read = linereq_oob_read,
+	.oob_poll = linereq_oob_poll,
+#endif
 };
 
 static int linereq_create(struct gpio_device *gdev, void __user *ip)
@@ -1340,6 +1575,7 @@ static int linereq_create(struct gpio_device *gdev, void __user *ip)
 
 	lr->gdev = gdev;
 	get_device(&gdev->dev);
+	linereq_init_oob(lr);
 
 	for (i = 0; i < ulr.num_lines; i++) {
 		lr->lines[i].req = lr;
@@ -1959,6 +2195,8 @@ static void gpio_desc_to_lineinfo(struct gpio_desc *desc,
 
 	if (test_bit(FLAG_EVENT_CLOCK_REALTIME, &desc->flags))
 		info->flags |= GPIO_V2_LINE_FLAG_EVENT_CLOCK_REALTIME;
+	if (test_bit(FLAG_EVENT_OOB, &desc->flags))
+		info->flags |= GPIO_V2_LINE_FLAG_EVENT_OOB;
 
 	debounce_period_us = READ_ONCE(desc->debounce_period_us);
 	if (debounce_period_us) {
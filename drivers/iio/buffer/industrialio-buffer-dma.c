@@ -16,6 +16,8 @@
 #include <linux/iio/buffer-dma.h>
 #include <linux/dma-mapping.h>
 #include <linux/sizes.h>
+#include <linux/dovetail.h>
+#include <linux/mm.h>
 
 /*
  * For DMA buffers the storage is sub-divided into so called blocks. Each block
@@ -88,6 +90,15 @@
  * has special requirements that are not handled by the generic functions. If a
  * driver chooses to overload a callback it has to ensure that the generic
  * callback is called from within the custom callback.
+ *
+ * As an alternative to read() access, the application may allocate a block
+ * ring which it maps into its address space. Once the buffer is enabled, the
+ * driver fills the ring cyclically from its ring_start() callback, calling
+ * iio_dma_buffer_ring_block_done() for each completed block. The application
+ * dequeues completed blocks, reads the samples in place, then enqueues the
+ * blocks back. Since the ring state is protected by a hard lock, completions
+ * may be signaled from the out-of-band stage, and the dequeue/enqueue
+ * operations are available to out-of-band callers as well.
  */
 
 static void iio_buffer_block_release(struct kref *kref)
@@ -270,6 +281,503 @@ static bool iio_dma_block_reusable(struct iio_dma_buffer_block *block)
 	}
 }
 
+#define IIO_DMA_BUFFER_RING_MAX_BLOCKS	64
+
+static void iio_dma_buffer_ring_wake(struct irq_work *work)
+{
+	struct iio_dma_buffer_queue *queue = container_of(work,
+		struct iio_dma_buffer_queue, ring.wake_work);
+
+	wake_up_interruptible_poll(&queue->buffer.pollq, EPOLLIN | EPOLLRDNORM);
+}
+
+#ifdef CONFIG_IIO_BUFFER_DMA_OOB
+
+static void iio_dma_buffer_ring_init_oob(struct iio_dma_buffer_ring *ring)
+{
+	oob_poll_head_init(&ring->poll);
+}
+
+static void iio_dma_buffer_ring_destroy_oob(struct iio_dma_buffer_ring *ring)
+{
+	oob_poll_head_destroy(&ring->poll);
+}
+
+static void iio_dma_buffer_ring_signal_oob(struct iio_dma_buffer_ring *ring,
+	__poll_t events)
+{
+	oob_poll_signal(&ring->poll, events);
+}
+
+#else
+
+static inline void iio_dma_buffer_ring_init_oob(struct iio_dma_buffer_ring *ring)
+{
+}
+
+static inline void iio_dma_buffer_ring_destroy_oob(struct iio_dma_buffer_ring *ring)
+{
+}
+
+static inline void iio_dma_buffer_ring_signal_oob(struct iio_dma_buffer_ring *ring,
+	__poll_t events)
+{
+}
+
+#endif /* CONFIG_IIO_BUFFER_DMA_OOB */
+
+static void iio_dma_buffer_ring_notify(struct iio_dma_buffer_queue *queue,
+	__poll_t events)
+{
+	iio_dma_buffer_ring_signal_oob(&queue->ring, events);
+
+	/* The in-band waitqueue cannot be woken up from the oob stage. */
+	if (running_inband())
+		wake_up_interruptible_poll(&queue->buffer.pollq, events);
+	else
+		irq_work_queue(&queue->ring.wake_work);
+}
+
+/* Must be called with ring->lock held. */
+static void iio_dma_buffer_ring_reset(struct iio_dma_buffer_ring *ring)
+{
+	unsigned int i;
+
+	for (i = 0; i < ring->num_blocks; i++) {
+		ring->blocks[i].state = IIO_RING_BLOCK_FREE;
+		ring->blocks[i].timestamp = 0;
+		ring->blocks[i].seq = 0;
+	}
+
+	ring->done_head = 0;
+	ring->done_count = 0;
+	ring->hw_pos = 0;
+	ring->seq = 0;
+	ring->overruns = 0;
+}
+
+static void iio_dma_buffer_ring_stop(struct iio_dma_buffer_queue *queue)
+{
+	struct iio_dma_buffer_ring *ring = &queue->ring;
+
+	raw_spin_lock_irq(&ring->lock);
+	ring->running = false;
+	raw_spin_unlock_irq(&ring->lock);
+}
+
+static int iio_dma_buffer_ring_start(struct iio_dma_buffer_queue *queue)
+{
+	struct iio_dma_buffer_ring *ring = &queue->ring;
+	int ret;
+
+	if (!queue->ops)
+		return -ENODEV;
+
+	raw_spin_lock_irq(&ring->lock);
+	iio_dma_buffer_ring_reset(ring);
+	ring->running = true;
+	raw_spin_unlock_irq(&ring->lock);
+
+	ret = queue->ops->ring_start(queue);
+	if (ret)
+		iio_dma_buffer_ring_stop(queue);
+
+	return ret;
+}
+
+static void iio_dma_buffer_ring_free(struct iio_dma_buffer_queue *queue)
+{
+	struct iio_dma_buffer_ring *ring = &queue->ring;
+	struct iio_dma_buffer_ring_block *blocks;
+	unsigned int *done, num_blocks;
+	dma_addr_t phys_addr;
+	void *vaddr;
+
+	raw_spin_lock_irq(&ring->lock);
+	vaddr = ring->vaddr;
+	phys_addr = ring->phys_addr;
+	num_blocks = ring->num_blocks;
+	blocks = ring->blocks;
+	done = ring->done;
+	ring->vaddr = NULL;
+	ring->num_blocks = 0;
+	ring->blocks = NULL;
+	ring->done = NULL;
+	raw_spin_unlock_irq(&ring->lock);
+
+	irq_work_sync(&ring->wake_work);
+
+	dma_free_coherent(queue->dev, PAGE_ALIGN(ring->block_size * num_blocks),
+		vaddr, phys_addr);
+	kfree(done);
+	kfree(blocks);
+}
+
+/* Must be called with ring->lock held. */
+static void iio_dma_buffer_ring_describe(struct iio_dma_buffer_ring *ring,
+	unsigned int id, struct iio_buffer_block *desc)
+{
+	desc->id = id;
+	desc->size = ring->block_size;
+	desc->bytes_used = ring->block_size;
+	desc->flags = 0;
+	desc->offset = id * ring->block_size;
+	desc->seq = ring->blocks[id].seq;
+	desc->timestamp = ring->blocks[id].timestamp;
+}
+
+/**
+ * iio_dma_buffer_ring_block_done() - Indicate that a ring block has been filled
+ * @queue: Queue the block ring belongs to
+ *
+ * Should be called by the driver each time the DMA controller has completed a
+ * block of the ring, which is filled in order. May be called from the
+ * out-of-band stage.
+ */
+void iio_dma_buffer_ring_block_done(struct iio_dma_buffer_queue *queue)
+{
+	struct iio_dma_buffer_ring *ring = &queue->ring;
+	struct iio_dma_buffer_ring_block *block;
+	unsigned long flags;
+	unsigned int id;
+	u32 seq;
+
+	raw_spin_lock_irqsave(&ring->lock, flags);
+
+	if (!ring->running) {
+		raw_spin_unlock_irqrestore(&ring->lock, flags);
+		return;
+	}
+
+	id = ring->hw_pos;
+	ring->hw_pos = (id + 1) % ring->num_blocks;
+	seq = ring->seq++;
+	block = &ring->blocks[id];
+
+	if (block->state == IIO_RING_BLOCK_USER) {
+		/* Overwritten while the application was reading it */
+		ring->overruns++;
+		raw_spin_unlock_irqrestore(&ring->lock, flags);
+		return;
+	}
+
+	block->state = IIO_RING_BLOCK_DONE;
+	block->seq = seq;
+	block->timestamp = ktime_get_mono_fast_ns();
+	ring->done[(ring->done_head + ring->done_count) % ring->num_blocks] = id;
+	ring->done_count++;
+
+	/*
+	 * The DMA controller is already filling the next block. If it was
+	 * not dequeued in time, take it back before it can be handed out
+	 * half overwritten. Blocks complete in order, so this is the oldest
+	 * one.
+	 */
+	block = &ring->blocks[ring->hw_pos];
+	if (block->state == IIO_RING_BLOCK_DONE) {
+		ring->overruns++;
+		block->state = IIO_RING_BLOCK_FREE;
+		ring->done_head = (ring->done_head + 1) % ring->num_blocks;
+		ring->done_count--;
+	}
+
+	raw_spin_unlock_irqrestore(&ring->lock, flags);
+
+	iio_dma_buffer_ring_notify(queue, EPOLLIN | EPOLLRDNORM);
+}
+EXPORT_SYMBOL_GPL(iio_dma_buffer_ring_block_done);
+
+/**
+ * iio_dma_buffer_alloc_blocks() - DMA buffer alloc_blocks callback
+ * @buffer: Buffer to allocate the block ring for
+ * @req: Allocation request
+ *
+ * Should be used as the alloc_blocks callback for iio_buffer_access_ops
+ * struct for DMA buffers. The ring memory is a single coherent area, block
+ * n starting at offset n * size.
+ */
+int iio_dma_buffer_alloc_blocks(struct iio_buffer *buffer,
+	struct iio_buffer_block_alloc_req *req)
+{
+	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
+	struct iio_dma_buffer_ring *ring = &queue->ring;
+	struct iio_dma_buffer_ring_block *blocks;
+	unsigned int *done;
+	void *vaddr = NULL;
+	dma_addr_t phys_addr;
+	size_t size;
+	int ret = 0;
+
+	if (req->type || req->id)
+		return -EINVAL;
+
+	if (req->count < 2 || req->count > IIO_DMA_BUFFER_RING_MAX_BLOCKS ||
+	    !req->size || req->size > INT_MAX / req->count)
+		return -EINVAL;
+
+	size = PAGE_ALIGN((size_t)req->size * req->count);
+
+	mutex_lock(&queue->lock);
+
+	if (!queue->ops || !queue->ops->ring_start) {
+		ret = -EOPNOTSUPP;
+		goto out_unlock;
+	}
+
+	if (queue->active || ring->num_blocks || queue->fileio.active_block) {
+		ret = -EBUSY;
+		goto out_unlock;
+	}
+
+	blocks = kcalloc(req->count, sizeof(*blocks), GFP_KERNEL);
+	done = kcalloc(req->count, sizeof(*done), GFP_KERNEL);
+	if (blocks && done)
+		vaddr = dma_alloc_coherent(queue->dev, size, &phys_addr,
+			GFP_KERNEL);
+	if (!vaddr) {
+		kfree(done);
+		kfree(blocks);
+		ret = -ENOMEM;
+		goto out_unlock;
+	}
+
+	raw_spin_lock_irq(&ring->lock);
+	ring->vaddr = vaddr;
+	ring->phys_addr = phys_addr;
+	ring->block_size = req->size;
+	ring->blocks = blocks;
+	ring->done = done;
+	ring->num_blocks = req->count;
+	ring->running = false;
+	iio_dma_buffer_ring_reset(ring);
+	raw_spin_unlock_irq(&ring->lock);
+
+out_unlock:
+	mutex_unlock(&queue->lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(iio_dma_buffer_alloc_blocks);
+
+/**
+ * iio_dma_buffer_free_blocks() - DMA buffer free_blocks callback
+ * @buffer: Buffer to free the block ring of
+ *
+ * Should be used as the free_blocks callback for iio_buffer_access_ops
+ * struct for DMA buffers. The buffer must be disabled and the ring unmapped.
+ */
+int iio_dma_buffer_free_blocks(struct iio_buffer *buffer)
+{
+	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
+	int ret = 0;
+
+	mutex_lock(&queue->lock);
+
+	if (queue->active || atomic_read(&queue->ring.mapped))
+		ret = -EBUSY;
+	else if (queue->ring.num_blocks)
+		iio_dma_buffer_ring_free(queue);
+
+	mutex_unlock(&queue->lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(iio_dma_buffer_free_blocks);
+
+/**
+ * iio_dma_buffer_query_block() - DMA buffer query_block callback
+ * @buffer: Buffer the block belongs to
+ * @block: Descriptor to fill, @block->id selects the block
+ *
+ * Should be used as the query_block callback for iio_buffer_access_ops
+ * struct for DMA buffers.
+ */
+int iio_dma_buffer_query_block(struct iio_buffer *buffer,
+	struct iio_buffer_block *block)
+{
+	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
+	struct iio_dma_buffer_ring *ring = &queue->ring;
+	unsigned long flags;
+	int ret = 0;
+
+	raw_spin_lock_irqsave(&ring->lock, flags);
+	if (block->id >= ring->num_blocks)
+		ret = -EINVAL;
+	else
+		iio_dma_buffer_ring_describe(ring, block->id, block);
+	raw_spin_unlock_irqrestore(&ring->lock, flags);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(iio_dma_buffer_query_block);
+
+/**
+ * iio_dma_buffer_enqueue_block() - DMA buffer enqueue_block callback
+ * @buffer: Buffer the block belongs to
+ * @block: Descriptor of a block previously dequeued
+ *
+ * Should be used as the enqueue_block callback for iio_buffer_access_ops
+ * struct for DMA buffers. May be called from the out-of-band stage.
+ */
+int iio_dma_buffer_enqueue_block(struct iio_buffer *buffer,
+	struct iio_buffer_block *block)
+{
+	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
+	struct iio_dma_buffer_ring *ring = &queue->ring;
+	unsigned long flags;
+	int ret = 0;
+
+	raw_spin_lock_irqsave(&ring->lock, flags);
+	if (block->id >= ring->num_blocks ||
+	    ring->blocks[block->id].state != IIO_RING_BLOCK_USER)
+		ret = -EINVAL;
+	else
+		ring->blocks[block->id].state = IIO_RING_BLOCK_FREE;
+	raw_spin_unlock_irqrestore(&ring->lock, flags);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(iio_dma_buffer_enqueue_block);
+
+/**
+ * iio_dma_buffer_dequeue_block() - DMA buffer dequeue_block callback
+ * @buffer: Buffer to dequeue a block from
+ * @block: Descriptor receiving the oldest completed block
+ *
+ * Should be used as the dequeue_block callback for iio_buffer_access_ops
+ * struct for DMA buffers. May be called from the out-of-band stage. Never
+ * blocks, -EAGAIN is returned if no block has completed.
+ */
+int iio_dma_buffer_dequeue_block(struct iio_buffer *buffer,
+	struct iio_buffer_block *block)
+{
+	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
+	struct iio_dma_buffer_ring *ring = &queue->ring;
+	unsigned long flags;
+	unsigned int id;
+	int ret = 0;
+
+	raw_spin_lock_irqsave(&ring->lock, flags);
+
+	if (!ring->num_blocks) {
+		ret = -EINVAL;
+	} else if (!ring->done_count) {
+		ret = -EAGAIN;
+	} else {
+		id = ring->done[ring->done_head];
+		ring->done_head = (ring->done_head + 1) % ring->num_blocks;
+		ring->done_count--;
+		ring->blocks[id].state = IIO_RING_BLOCK_USER;
+		iio_dma_buffer_ring_describe(ring, id, block);
+		if (ring->overruns) {
+			block->flags |= IIO_BUFFER_BLOCK_FLAG_OVERRUN;
+			ring->overruns = 0;
+		}
+	}
+
+	raw_spin_unlock_irqrestore(&ring->lock, flags);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(iio_dma_buffer_dequeue_block);
+
+static void iio_dma_buffer_vm_open(struct vm_area_struct *vma)
+{
+	struct iio_dma_buffer_queue *queue = vma->vm_private_data;
+
+	iio_buffer_get(&queue->buffer);
+	atomic_inc(&queue->ring.mapped);
+}
+
+static void iio_dma_buffer_vm_close(struct vm_area_struct *vma)
+{
+	struct iio_dma_buffer_queue *queue = vma->vm_private_data;
+
+	atomic_dec(&queue->ring.mapped);
+	iio_buffer_put(&queue->buffer);
+}
+
+static const struct vm_operations_struct iio_dma_buffer_vm_ops = {
+	.open = iio_dma_buffer_vm_open,
+	.close = iio_dma_buffer_vm_close,
+};
+
+/**
+ * iio_dma_buffer_mmap() - DMA buffer mmap callback
+ * @buffer: Buffer to map the block ring of
+ * @vma: Mapping to populate, must start at offset 0
+ *
+ * Should be used as the mmap callback for iio_buffer_access_ops
+ * struct for DMA buffers.
+ */
+int iio_dma_buffer_mmap(struct iio_buffer *buffer,
+	struct vm_area_struct *vma)
+{
+	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
+	struct iio_dma_buffer_ring *ring = &queue->ring;
+	size_t len = vma->vm_end - vma->vm_start;
+	int ret;
+
+	if (!(vma->vm_flags & VM_SHARED) || vma->vm_pgoff)
+		return -EINVAL;
+
+	mutex_lock(&queue->lock);
+
+	if (!ring->num_blocks || !queue->ops ||
+	    len > PAGE_ALIGN(ring->block_size * ring->num_blocks)) {
+		ret = -EINVAL;
+		goto out_unlock;
+	}
+
+	ret = dma_mmap_coherent(queue->dev, vma, ring->vaddr,
+		ring->phys_addr, len);
+	if (ret)
+		goto out_unlock;
+
+	vma->vm_ops = &iio_dma_buffer_vm_ops;
+	vma->vm_private_data = queue;
+	iio_dma_buffer_vm_open(vma);
+
+out_unlock:
+	mutex_unlock(&queue->lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(iio_dma_buffer_mmap);
+
+#ifdef CONFIG_IIO_BUFFER_DMA_OOB
+
+/**
+ * iio_dma_buffer_oob_poll() - DMA buffer oob_poll callback
+ * @buffer: Buffer to poll
+ * @wait: oob poll descriptor
+ *
+ * Should be used as the oob_poll callback for iio_buffer_access_ops
+ * struct for DMA buffers.
+ */
+__poll_t iio_dma_buffer_oob_poll(struct iio_buffer *buffer,
+	struct oob_poll_wait *wait)
+{
+	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
+	struct iio_dma_buffer_ring *ring = &queue->ring;
+	__poll_t events = 0;
+	unsigned long flags;
+
+	oob_poll_watch(&ring->poll, wait);
+
+	raw_spin_lock_irqsave(&ring->lock, flags);
+	if (ring->done_count)
+		events = EPOLLIN | EPOLLRDNORM;
+	else if (!ring->running)
+		events = EPOLLHUP;
+	raw_spin_unlock_irqrestore(&ring->lock, flags);
+
+	return events;
+}
+EXPORT_SYMBOL_GPL(iio_dma_buffer_oob_poll);
+
+#endif /* CONFIG_IIO_BUFFER_DMA_OOB */
+
 /**
  * iio_dma_buffer_request_update() - DMA buffer request_update callback
  * @buffer: The buffer which to request an update
@@ -296,6 +804,10 @@ int iio_dma_buffer_request_update(struct iio_buffer *buffer)
 
 	mutex_lock(&queue->lock);
 
+	/* The block ring replaces the fileio blocks */
+	if (queue->ring.num_blocks)
+		goto out_unlock;
+
 	/* Allocations are page aligned */
 	if (PAGE_ALIGN(queue->fileio.block_size) == PAGE_ALIGN(size))
 		try_reuse = true;
@@ -402,16 +914,24 @@ int iio_dma_buffer_enable(struct iio_buffer *buffer,
 {
 	struct iio_dma_buffer_queue *queue = iio_buffer_to_queue(buffer);
 	struct iio_dma_buffer_block *block, *_block;
+	int ret = 0;
 
 	mutex_lock(&queue->lock);
 	queue->active = true;
+	if (queue->ring.num_blocks) {
+		ret = iio_dma_buffer_ring_start(queue);
+		if (ret)
+			queue->active = false;
+		goto out_unlock;
+	}
 	list_for_each_entry_safe(block, _block, &queue->incoming, head) {
 		list_del(&block->head);
 		iio_dma_buffer_submit_block(queue, block);
 	}
+out_unlock:
 	mutex_unlock(&queue->lock);
 
-	return 0;
+	return ret;
 }
 EXPORT_SYMBOL_GPL(iio_dma_buffer_enable);
 
@@ -431,10 +951,16 @@ int iio_dma_buffer_disable(struct iio_buffer *buffer,
 	mutex_lock(&queue->lock);
 	queue->active = false;
 
+	if (queue->ring.num_blocks)
+		iio_dma_buffer_ring_stop(queue);
+
 	if (queue->ops && queue->ops->abort)
 		queue->ops->abort(queue);
 	mutex_unlock(&queue->lock);
 
+	if (queue->ring.num_blocks)
+		iio_dma_buffer_ring_notify(queue, EPOLLHUP);
+
 	return 0;
 }
 EXPORT_SYMBOL_GPL(iio_dma_buffer_disable);
@@ -490,6 +1016,11 @@ int iio_dma_buffer_read(struct iio_buffer *buffer, size_t n,
 
 	mutex_lock(&queue->lock);
 
+	if (queue->ring.num_blocks) {
+		ret = -EBUSY;
+		goto out_unlock;
+	}
+
 	if (!queue->fileio.active_block) {
 		block = iio_dma_buffer_dequeue(queue);
 		if (block == NULL) {
@@ -548,6 +1079,13 @@ size_t iio_dma_buffer_data_available(struct iio_buffer *buf)
 	 */
 
 	mutex_lock(&queue->lock);
+	if (queue->ring.num_blocks) {
+		raw_spin_lock_irq(&queue->ring.lock);
+		data_available = queue->ring.done_count * queue->ring.block_size;
+		raw_spin_unlock_irq(&queue->ring.lock);
+		goto out_unlock;
+	}
+
 	if (queue->fileio.active_block)
 		data_available += queue->fileio.active_block->size;
 
@@ -555,6 +1093,7 @@ size_t iio_dma_buffer_data_available(struct iio_buffer *buf)
 	list_for_each_entry(block, &queue->outgoing, head)
 		data_available += block->size;
 	spin_unlock_irq(&queue->list_lock);
+out_unlock:
 	mutex_unlock(&queue->lock);
 
 	return data_available;
@@ -622,6 +1161,11 @@ int iio_dma_buffer_init(struct iio_dma_buffer_queue *queue,
 	mutex_init(&queue->lock);
 	spin_lock_init(&queue->list_lock);
 
+	raw_spin_lock_init(&queue->ring.lock);
+	init_irq_work(&queue->ring.wake_work, iio_dma_buffer_ring_wake);
+	atomic_set(&queue->ring.mapped, 0);
+	iio_dma_buffer_ring_init_oob(&queue->ring);
+
 	return 0;
 }
 EXPORT_SYMBOL_GPL(iio_dma_buffer_init);
@@ -659,6 +1203,10 @@ void iio_dma_buffer_exit(struct iio_dma_buffer_queue *queue)
 	queue->fileio.active_block = NULL;
 	queue->ops = NULL;
 
+	/* A mapped ring is released with the last buffer reference. */
+	if (queue->ring.num_blocks && !atomic_read(&queue->ring.mapped))
+		iio_dma_buffer_ring_free(queue);
+
 	mutex_unlock(&queue->lock);
 }
 EXPORT_SYMBOL_GPL(iio_dma_buffer_exit);
@@ -673,6 +1221,9 @@ EXPORT_SYMBOL_GPL(iio_dma_buffer_exit);
  */
 void iio_dma_buffer_release(struct iio_dma_buffer_queue *queue)
 {
+	if (queue->ring.num_blocks)
+		iio_dma_buffer_ring_free(queue);
+	iio_dma_buffer_ring_destroy_oob(&queue->ring);
 	mutex_destroy(&queue->lock);
 }
 EXPORT_SYMBOL_GPL(iio_dma_buffer_release);
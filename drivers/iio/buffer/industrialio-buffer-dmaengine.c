@@ -92,6 +92,52 @@ static int iio_dmaengine_buffer_submit_block(struct iio_dma_buffer_queue *queue,
 	return 0;
 }
 
+static void iio_dmaengine_buffer_ring_done(void *data)
+{
+	iio_dma_buffer_ring_block_done(data);
+}
+
+/*
+ * Fill the block ring with a cyclic transfer, one period per block. With
+ * CONFIG_IIO_BUFFER_DMA_OOB and an oob capable channel, completions are
+ * signaled right from the oob stage.
+ */
+static int iio_dmaengine_buffer_ring_start(struct iio_dma_buffer_queue *queue)
+{
+	struct dmaengine_buffer *dmaengine_buffer =
+		iio_buffer_to_dmaengine_buffer(&queue->buffer);
+	struct dma_chan *chan = dmaengine_buffer->chan;
+	struct dma_async_tx_descriptor *desc;
+	unsigned long flags = DMA_PREP_INTERRUPT;
+	size_t block_size = queue->ring.block_size;
+	dma_cookie_t cookie;
+
+	if (block_size % dmaengine_buffer->align ||
+	    block_size > dmaengine_buffer->max_size)
+		return -EINVAL;
+
+	if (IS_ENABLED(CONFIG_IIO_BUFFER_DMA_OOB) &&
+	    dma_has_cap(DMA_OOB, chan->device->cap_mask))
+		flags |= DMA_OOB_INTERRUPT;
+
+	desc = dmaengine_prep_dma_cyclic(chan, queue->ring.phys_addr,
+		block_size * queue->ring.num_blocks, block_size,
+		DMA_DEV_TO_MEM, flags);
+	if (!desc)
+		return -ENOMEM;
+
+	desc->callback = iio_dmaengine_buffer_ring_done;
+	desc->callback_param = queue;
+
+	cookie = dmaengine_submit(desc);
+	if (dma_submit_error(cookie))
+		return dma_submit_error(cookie);
+
+	dma_async_issue_pending(chan);
+
+	return 0;
+}
+
 static void iio_dmaengine_buffer_abort(struct iio_dma_buffer_queue *queue)
 {
 	struct dmaengine_buffer *dmaengine_buffer =
@@ -119,6 +165,15 @@ static const struct iio_buffer_access_funcs iio_dmaengine_buffer_ops = {
 	.disable = iio_dma_buffer_disable,
 	.data_available = iio_dma_buffer_data_available,
 	.release = iio_dmaengine_buffer_release,
+	.alloc_blocks = iio_dma_buffer_alloc_blocks,
+	.free_blocks = iio_dma_buffer_free_blocks,
+	.query_block = iio_dma_buffer_query_block,
+	.enqueue_block = iio_dma_buffer_enqueue_block,
+	.dequeue_block = iio_dma_buffer_dequeue_block,
+	.mmap = iio_dma_buffer_mmap,
+#ifdef CONFIG_IIO_BUFFER_DMA_OOB
+	.oob_poll = iio_dma_buffer_oob_poll,
+#endif
 
 	.modes = INDIO_BUFFER_HARDWARE,
 	.flags = INDIO_BUFFER_FLAG_FIXED_WATERMARK,
@@ -127,6 +182,7 @@ static const struct iio_buffer_access_funcs iio_dmaengine_buffer_ops = {
 static const struct iio_dma_buffer_ops iio_dmaengine_default_ops = {
 	.submit = iio_dmaengine_buffer_submit_block,
 	.abort = iio_dmaengine_buffer_abort,
+	.ring_start = iio_dmaengine_buffer_ring_start,
 };
 
 static ssize_t iio_dmaengine_buffer_get_length_align(struct device *dev,
@@ -19,6 +19,7 @@
 #include <linux/slab.h>
 #include <linux/poll.h>
 #include <linux/sched/signal.h>
+#include <linux/uaccess.h>
 
 #include <linux/iio/iio.h>
 #include <linux/iio/iio-opaque.h>
@@ -1390,12 +1391,142 @@ static int iio_buffer_chrdev_release(struct inode *inode, struct file *filep)
 	return 0;
 }
 
+static long iio_buffer_chrdev_ioctl(struct file *filep, unsigned int cmd,
+				    unsigned long arg)
+{
+	struct iio_dev_buffer_pair *ib = filep->private_data;
+	struct iio_buffer *buffer = ib->buffer;
+	const struct iio_buffer_access_funcs *access = buffer->access;
+	void __user *_arg = (void __user *)arg;
+	struct iio_buffer_block_alloc_req req;
+	struct iio_buffer_block block;
+	int ret;
+
+	if (!ib->indio_dev->info)
+		return -ENODEV;
+
+	switch (cmd) {
+	case IIO_BUFFER_BLOCK_ALLOC_IOCTL:
+		if (!access->alloc_blocks)
+			return -ENOTTY;
+		if (copy_from_user(&req, _arg, sizeof(req)))
+			return -EFAULT;
+		return access->alloc_blocks(buffer, &req);
+	case IIO_BUFFER_BLOCK_FREE_IOCTL:
+		if (!access->free_blocks)
+			return -ENOTTY;
+		return access->free_blocks(buffer);
+	case IIO_BUFFER_BLOCK_QUERY_IOCTL:
+		if (!access->query_block)
+			return -ENOTTY;
+		if (copy_from_user(&block, _arg, sizeof(block)))
+			return -EFAULT;
+		ret = access->query_block(buffer, &block);
+		break;
+	case IIO_BUFFER_BLOCK_ENQUEUE_IOCTL:
+		if (!access->enqueue_block)
+			return -ENOTTY;
+		if (copy_from_user(&block, _arg, sizeof(block)))
+			return -EFAULT;
+		return access->enqueue_block(buffer, &block);
+	case IIO_BUFFER_BLOCK_DEQUEUE_IOCTL:
+		if (!access->dequeue_block)
+			return -ENOTTY;
+		ret = access->dequeue_block(buffer, &block);
+		break;
+	default:
+		return -ENOTTY;
+	}
+
+	if (ret)
+		return ret;
+
+	if (copy_to_user(_arg, &block, sizeof(block)))
+		return -EFAULT;
+
+	return 0;
+}
+
+static int iio_buffer_chrdev_mmap(struct file *filep,
+				  struct vm_area_struct *vma)
+{
+	struct iio_dev_buffer_pair *ib = filep->private_data;
+	struct iio_buffer *buffer = ib->buffer;
+
+	if (!ib->indio_dev->info)
+		return -ENODEV;
+
+	if (!buffer->access->mmap)
+		return -ENODEV;
+
+	return buffer->access->mmap(buffer, vma);
+}
+
+/*
+ * Only the block exchange is available to oob callers, which should
+ * wait for EPOLLIN with oob_poll() when dequeuing returns -EAGAIN.
+ */
+static long iio_buffer_chrdev_oob_ioctl(struct file *filep, unsigned int cmd,
+					unsigned long arg)
+{
+	struct iio_dev_buffer_pair *ib = filep->private_data;
+	struct iio_buffer *buffer = ib->buffer;
+	const struct iio_buffer_access_funcs *access = buffer->access;
+	void __user *_arg = (void __user *)arg;
+	struct iio_buffer_block block;
+	int ret;
+
+	if (!ib->indio_dev->info)
+		return -ENODEV;
+
+	switch (cmd) {
+	case IIO_BUFFER_BLOCK_ENQUEUE_IOCTL:
+		if (!access->enqueue_block)
+			return -ENOTTY;
+		if (!access_ok(_arg, sizeof(block)) ||
+		    raw_copy_from_user(&block, _arg, sizeof(block)))
+			return -EFAULT;
+		return access->enqueue_block(buffer, &block);
+	case IIO_BUFFER_BLOCK_DEQUEUE_IOCTL:
+		if (!access->dequeue_block)
+			return -ENOTTY;
+		if (!access_ok(_arg, sizeof(block)))
+			return -EFAULT;
+		ret = access->dequeue_block(buffer, &block);
+		if (ret)
+			return ret;
+		if (raw_copy_to_user(_arg, &block, sizeof(block)))
+			return -EFAULT;
+		return 0;
+	default:
+		return -ENOTTY;
+	}
+}
+
+static __poll_t iio_buffer_chrdev_oob_poll(struct file *filep,
+					   struct oob_poll_wait *wait)
+{
+	struct iio_dev_buffer_pair *ib = filep->private_data;
+	struct iio_buffer *buffer = ib->buffer;
+
+	if (!ib->indio_dev->info || !buffer->access->oob_poll)
+		return EPOLLERR;
+
+	return buffer->access->oob_poll(buffer, wait);
+}
+
 static const struct file_operations iio_buffer_chrdev_fileops = {
 	.owner = THIS_MODULE,
 	.llseek = noop_llseek,
 	.read = iio_buffer_read,
 	.poll = iio_buffer_poll,
+	.unlocked_ioctl = iio_buffer_chrdev_ioctl,
+	.compat_ioctl = compat_ptr_ioctl,
+	.mmap = iio_buffer_chrdev_mmap,
 	.release = iio_buffer_chrdev_release,
+	.oob_ioctl = iio_buffer_chrdev_oob_ioctl,
+	.compat_oob_ioctl = compat_ptr_oob_ioctl,
+	.oob_poll = iio_buffer_chrdev_oob_poll,
 };
 
 static long iio_device_buffer_getfd(struct iio_dev *indio_dev, unsigned long arg)
@@ -9,6 +9,7 @@
 #include <linux/err.h>
 #include <linux/device.h>
 #include <linux/interrupt.h>
+#include <linux/irqstage.h>
 #include <linux/list.h>
 #include <linux/slab.h>
 
@@ -199,6 +200,48 @@ void iio_trigger_poll_chained(struct iio_trigger *trig)
 }
 EXPORT_SYMBOL(iio_trigger_poll_chained);
 
+#ifdef CONFIG_IIO_TRIGGER_OOB
+
+/*
+ * Consumers which requested their poll function with IRQF_OOB run
+ * directly from the oob stage, others are posted to the in-band
+ * stage like any non-oob interrupt would be.
+ */
+void iio_trigger_poll_oob(struct iio_trigger *trig)
+{
+	unsigned int subirq;
+	int i;
+
+	if (!running_oob()) {
+		iio_trigger_poll(trig);
+		return;
+	}
+
+	if (!atomic_read(&trig->use_count)) {
+		atomic_set(&trig->use_count, CONFIG_IIO_CONSUMERS_PER_TRIGGER);
+
+		for (i = 0; i < CONFIG_IIO_CONSUMERS_PER_TRIGGER; i++) {
+			subirq = trig->subirq_base + i;
+			if (!trig->subirqs[i].enabled)
+				iio_trigger_notify_done(trig);
+			else if (irq_is_oob(subirq))
+				generic_handle_irq(subirq);
+			else
+				irq_post_inband(subirq);
+		}
+	}
+}
+EXPORT_SYMBOL(iio_trigger_poll_oob);
+
+irqreturn_t iio_trigger_generic_data_rdy_poll_oob(int irq, void *private)
+{
+	iio_trigger_poll_oob(private);
+	return IRQ_HANDLED;
+}
+EXPORT_SYMBOL(iio_trigger_generic_data_rdy_poll_oob);
+
+#endif /* CONFIG_IIO_TRIGGER_OOB */
+
 void iio_trigger_notify_done(struct iio_trigger *trig)
 {
 	if (atomic_dec_and_test(&trig->use_count) && trig->ops &&
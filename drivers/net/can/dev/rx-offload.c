@@ -5,8 +5,13 @@
  *                         Marc Kleine-Budde <kernel@pengutronix.de>
  */
 
+#include <linux/can/can-ml.h>
 #include <linux/can/dev.h>
 #include <linux/can/rx-offload.h>
+#include <linux/dovetail.h>
+#include <linux/log2.h>
+#include <linux/mm.h>
+#include <linux/poll.h>
 
 struct can_rx_offload_cb {
 	u32 timestamp;
@@ -115,6 +120,304 @@ static int can_rx_offload_compare(struct sk_buff *a, struct sk_buff *b)
 	return cb_b->timestamp - cb_a->timestamp;
 }
 
+#ifdef CONFIG_CAN_RX_OFFLOAD_OOB
+
+/**
+ * can_rx_offload_oob_queue() - Queue a CAN frame for oob readers
+ * @offload: pointer to rx_offload context
+ * @cf: received frame, a struct can_frame unless @flags has CAN_OOB_FRAME_FD
+ * @flags: CAN_OOB_FRAME_* flags
+ * @hw_timestamp: controller timestamp of the frame
+ *
+ * May be called from the oob stage, typically from an IRQF_OOB
+ * handler. Frames are delivered in submission order, which is the
+ * controller's reception order for FIFO based devices.
+ *
+ * Return: 0 on success, -ENOBUFS if the oob ring is full, -EAGAIN if
+ *         the oob delivery mode is not active.
+ */
+int can_rx_offload_oob_queue(struct can_rx_offload *offload,
+			     const struct canfd_frame *cf, u32 flags,
+			     u32 hw_timestamp)
+{
+	struct can_rx_offload_oob *oob = &offload->oob;
+	struct can_oob_frame *f;
+	unsigned long irqflags;
+	int ret = 0;
+
+	raw_spin_lock_irqsave(&oob->lock, irqflags);
+
+	if (!oob->active) {
+		ret = -EAGAIN;
+		goto out;
+	}
+
+	if (oob->head - oob->tail >= oob->size) {
+		oob->rx_dropped++;
+		ret = -ENOBUFS;
+		goto out;
+	}
+
+	f = &oob->ring[oob->head & (oob->size - 1)];
+	f->timestamp = ktime_get_mono_fast_ns();
+	f->hw_timestamp = hw_timestamp;
+	f->flags = flags;
+	if (flags & CAN_OOB_FRAME_FD)
+		f->frame = *cf;
+	else
+		memcpy(&f->frame, cf, sizeof(struct can_frame));
+	oob->head++;
+	oob->rx_packets++;
+out:
+	raw_spin_unlock_irqrestore(&oob->lock, irqflags);
+
+	if (!ret)
+		oob_poll_signal(&oob->poll, EPOLLIN | EPOLLRDNORM);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(can_rx_offload_oob_queue);
+
+/**
+ * can_rx_offload_oob_read() - Fetch frames from the oob ring
+ * @offload: pointer to rx_offload context
+ * @frames: array receiving the frames
+ * @count: number of entries in @frames
+ *
+ * Never blocks, callers should wait for EPOLLIN with
+ * can_rx_offload_oob_poll() when -EAGAIN is returned.
+ *
+ * Return: The number of frames copied to @frames, -EAGAIN if the ring
+ *         is empty, -EPERM if the oob delivery mode is not active.
+ */
+ssize_t can_rx_offload_oob_read(struct can_rx_offload *offload,
+				struct can_oob_frame *frames,
+				unsigned int count)
+{
+	struct can_rx_offload_oob *oob = &offload->oob;
+	unsigned long flags;
+	unsigned int n = 0;
+
+	raw_spin_lock_irqsave(&oob->lock, flags);
+
+	if (!oob->active) {
+		raw_spin_unlock_irqrestore(&oob->lock, flags);
+		return -EPERM;
+	}
+
+	while (n < count && oob->tail != oob->head) {
+		frames[n++] = oob->ring[oob->tail & (oob->size - 1)];
+		oob->tail++;
+	}
+
+	raw_spin_unlock_irqrestore(&oob->lock, flags);
+
+	return n ?: -EAGAIN;
+}
+EXPORT_SYMBOL_GPL(can_rx_offload_oob_read);
+
+__poll_t can_rx_offload_oob_poll(struct can_rx_offload *offload,
+				 struct oob_poll_wait *wait)
+{
+	struct can_rx_offload_oob *oob = &offload->oob;
+	__poll_t events = 0;
+	unsigned long flags;
+
+	oob_poll_watch(&oob->poll, wait);
+
+	raw_spin_lock_irqsave(&oob->lock, flags);
+	if (!oob->active)
+		events = EPOLLERR;
+	else if (oob->tail != oob->head)
+		events = EPOLLIN | EPOLLRDNORM;
+	if (oob->xmit)
+		events |= EPOLLOUT | EPOLLWRNORM;
+	raw_spin_unlock_irqrestore(&oob->lock, flags);
+
+	return events;
+}
+EXPORT_SYMBOL_GPL(can_rx_offload_oob_poll);
+
+/**
+ * can_rx_offload_oob_xmit() - Submit a CAN frame from the oob stage
+ * @offload: pointer to rx_offload context
+ * @cf: frame to send, a struct can_frame unless @flags has CAN_OOB_FRAME_FD
+ * @flags: CAN_OOB_FRAME_* flags
+ *
+ * Return: 0 on success, -EAGAIN if the controller cannot take the frame
+ *         right now, -EOPNOTSUPP if the driver has no oob TX support.
+ */
+int can_rx_offload_oob_xmit(struct can_rx_offload *offload,
+			    const struct canfd_frame *cf, u32 flags)
+{
+	struct can_rx_offload_oob *oob = &offload->oob;
+
+	if (!oob->xmit)
+		return -EOPNOTSUPP;
+
+	if (!can_rx_offload_oob_active(offload))
+		return -EPERM;
+
+	return oob->xmit(offload, cf, flags);
+}
+EXPORT_SYMBOL_GPL(can_rx_offload_oob_xmit);
+
+/**
+ * can_rx_offload_oob_get() - Find the rx_offload context of a CAN device
+ * @dev: CAN network device
+ *
+ * This is how oob consumers reach the oob ring of an interface, given
+ * its net_device. The caller must hold a reference on @dev, the
+ * context goes away when the driver unregisters the interface.
+ *
+ * Return: The rx_offload context, NULL if @dev has none.
+ */
+struct can_rx_offload *can_rx_offload_oob_get(struct net_device *dev)
+{
+	struct can_ml_priv *can_ml = can_get_ml_priv(dev);
+
+	return can_ml ? READ_ONCE(can_ml->rx_offload) : NULL;
+}
+EXPORT_SYMBOL_GPL(can_rx_offload_oob_get);
+
+/**
+ * can_rx_offload_oob_enable() - Switch received frames to oob delivery
+ * @offload: pointer to rx_offload context
+ * @nr_frames: size of the oob ring, rounded up to a power of two
+ *
+ * From now on, the frames the driver queues to @offload are stored to
+ * the oob ring instead of going through NAPI. TX echo frames still
+ * take the in-band route.
+ */
+int can_rx_offload_oob_enable(struct can_rx_offload *offload,
+			      unsigned int nr_frames)
+{
+	struct can_rx_offload_oob *oob = &offload->oob;
+	struct can_oob_frame *ring, *old;
+	unsigned long flags;
+
+	if (!nr_frames)
+		return -EINVAL;
+
+	nr_frames = roundup_pow_of_two(nr_frames);
+	ring = kvcalloc(nr_frames, sizeof(*ring), GFP_KERNEL);
+	if (!ring)
+		return -ENOMEM;
+
+	raw_spin_lock_irqsave(&oob->lock, flags);
+	if (oob->active) {
+		raw_spin_unlock_irqrestore(&oob->lock, flags);
+		kvfree(ring);
+		return -EBUSY;
+	}
+	old = oob->ring;
+	oob->ring = ring;
+	oob->size = nr_frames;
+	oob->head = oob->tail = 0;
+	WRITE_ONCE(oob->active, true);
+	raw_spin_unlock_irqrestore(&oob->lock, flags);
+
+	kvfree(old);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(can_rx_offload_oob_enable);
+
+void can_rx_offload_oob_disable(struct can_rx_offload *offload)
+{
+	struct can_rx_offload_oob *oob = &offload->oob;
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&oob->lock, flags);
+	WRITE_ONCE(oob->active, false);
+	raw_spin_unlock_irqrestore(&oob->lock, flags);
+
+	oob_poll_signal(&oob->poll, EPOLLERR | EPOLLHUP);
+}
+EXPORT_SYMBOL_GPL(can_rx_offload_oob_disable);
+
+/* In-band producers: move the frame to the oob ring if active. */
+static bool can_rx_offload_oob_divert(struct can_rx_offload *offload,
+				      struct sk_buff *skb)
+{
+	u32 flags = 0;
+
+	if (!can_rx_offload_oob_active(offload))
+		return false;
+
+	if (can_is_canfd_skb(skb))
+		flags |= CAN_OOB_FRAME_FD;
+
+	if (can_rx_offload_oob_queue(offload,
+				     (struct canfd_frame *)skb->data, flags,
+				     can_rx_offload_get_cb(skb)->timestamp) == -EAGAIN)
+		return false;
+
+	dev_consume_skb_any(skb);
+
+	return true;
+}
+
+static void can_rx_offload_oob_init(struct can_rx_offload *offload)
+{
+	struct can_ml_priv *can_ml = can_get_ml_priv(offload->dev);
+
+	raw_spin_lock_init(&offload->oob.lock);
+	oob_poll_head_init(&offload->oob.poll);
+	if (can_ml)
+		can_ml->rx_offload = offload;
+}
+
+static void can_rx_offload_oob_del(struct can_rx_offload *offload)
+{
+	struct can_ml_priv *can_ml = can_get_ml_priv(offload->dev);
+
+	if (can_ml && can_ml->rx_offload == offload)
+		can_ml->rx_offload = NULL;
+	can_rx_offload_oob_disable(offload);
+	oob_poll_head_destroy(&offload->oob.poll);
+	kvfree(offload->oob.ring);
+	offload->oob.ring = NULL;
+}
+
+/**
+ * can_rx_offload_add_oob() - Set up an rx_offload context for oob only
+ * @dev: CAN network device
+ * @offload: pointer to rx_offload context
+ *
+ * For drivers running their own NAPI RX path in-band, which only need
+ * the oob delivery ring. Undo with can_rx_offload_del_oob().
+ */
+int can_rx_offload_add_oob(struct net_device *dev,
+			   struct can_rx_offload *offload)
+{
+	offload->dev = dev;
+	can_rx_offload_oob_init(offload);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(can_rx_offload_add_oob);
+
+void can_rx_offload_del_oob(struct can_rx_offload *offload)
+{
+	can_rx_offload_oob_del(offload);
+}
+EXPORT_SYMBOL_GPL(can_rx_offload_del_oob);
+
+#else
+
+static inline bool can_rx_offload_oob_divert(struct can_rx_offload *offload,
+					     struct sk_buff *skb)
+{
+	return false;
+}
+
+static inline void can_rx_offload_oob_init(struct can_rx_offload *offload) { }
+
+static inline void can_rx_offload_oob_del(struct can_rx_offload *offload) { }
+
+#endif /* CONFIG_CAN_RX_OFFLOAD_OOB */
+
 /**
  * can_rx_offload_offload_one() - Read one CAN frame from HW
  * @offload: pointer to rx_offload context
@@ -176,6 +479,7 @@ int can_rx_offload_irq_offload_timestamp(struct can_rx_offload *offload,
 {
 	struct sk_buff_head skb_queue;
 	unsigned int i;
+	int received;
 
 	__skb_queue_head_init(&skb_queue);
 
@@ -194,6 +498,19 @@ int can_rx_offload_irq_offload_timestamp(struct can_rx_offload *offload,
 		__skb_queue_add_sort(&skb_queue, skb, can_rx_offload_compare);
 	}
 
+	received = skb_queue_len(&skb_queue);
+
+	if (can_rx_offload_oob_active(offload)) {
+		struct sk_buff_head inband;
+		struct sk_buff *skb;
+
+		__skb_queue_head_init(&inband);
+		while ((skb = __skb_dequeue(&skb_queue)))
+			if (!can_rx_offload_oob_divert(offload, skb))
+				__skb_queue_tail(&inband, skb);
+		skb_queue_splice_init(&inband, &skb_queue);
+	}
+
 	if (!skb_queue_empty(&skb_queue)) {
 		unsigned long flags;
 		u32 queue_len;
@@ -210,14 +527,14 @@ int can_rx_offload_irq_offload_timestamp(struct can_rx_offload *offload,
 		can_rx_offload_schedule(offload);
 	}
 
-	return skb_queue_len(&skb_queue);
+	return received;
 }
 EXPORT_SYMBOL_GPL(can_rx_offload_irq_offload_timestamp);
 
 int can_rx_offload_irq_offload_fifo(struct can_rx_offload *offload)
 {
 	struct sk_buff *skb;
-	int received = 0;
+	int received = 0, inband = 0;
 
 	while (1) {
 		skb = can_rx_offload_offload_one(offload, 0);
@@ -226,32 +543,40 @@ int can_rx_offload_irq_offload_fifo(struct can_rx_offload *offload)
 		if (!skb)
 			break;
 
-		skb_queue_tail(&offload->skb_queue, skb);
 		received++;
+		if (can_rx_offload_oob_divert(offload, skb))
+			continue;
+
+		skb_queue_tail(&offload->skb_queue, skb);
+		inband++;
 	}
 
-	if (received)
+	if (inband)
 		can_rx_offload_schedule(offload);
 
 	return received;
 }
 EXPORT_SYMBOL_GPL(can_rx_offload_irq_offload_fifo);
 
-int can_rx_offload_queue_sorted(struct can_rx_offload *offload,
-				struct sk_buff *skb, u32 timestamp)
+static int __can_rx_offload_queue_sorted(struct can_rx_offload *offload,
+					 struct sk_buff *skb, u32 timestamp,
+					 bool echo)
 {
 	struct can_rx_offload_cb *cb;
 	unsigned long flags;
 
+	cb = can_rx_offload_get_cb(skb);
+	cb->timestamp = timestamp;
+
+	if (!echo && can_rx_offload_oob_divert(offload, skb))
+		return 0;
+
 	if (skb_queue_len(&offload->skb_queue) >
 	    offload->skb_queue_len_max) {
 		dev_kfree_skb_any(skb);
 		return -ENOBUFS;
 	}
 
-	cb = can_rx_offload_get_cb(skb);
-	cb->timestamp = timestamp;
-
 	spin_lock_irqsave(&offload->skb_queue.lock, flags);
 	__skb_queue_add_sort(&offload->skb_queue, skb, can_rx_offload_compare);
 	spin_unlock_irqrestore(&offload->skb_queue.lock, flags);
@@ -260,6 +585,12 @@ int can_rx_offload_queue_sorted(struct can_rx_offload *offload,
 
 	return 0;
 }
+
+int can_rx_offload_queue_sorted(struct can_rx_offload *offload,
+				struct sk_buff *skb, u32 timestamp)
+{
+	return __can_rx_offload_queue_sorted(offload, skb, timestamp, false);
+}
 EXPORT_SYMBOL_GPL(can_rx_offload_queue_sorted);
 
 unsigned int can_rx_offload_get_echo_skb(struct can_rx_offload *offload,
@@ -276,7 +607,8 @@ unsigned int can_rx_offload_get_echo_skb(struct can_rx_offload *offload,
 	if (!skb)
 		return 0;
 
-	err = can_rx_offload_queue_sorted(offload, skb, timestamp);
+	/* Echo frames complete in-band transmissions, keep them in-band. */
+	err = __can_rx_offload_queue_sorted(offload, skb, timestamp, true);
 	if (err) {
 		stats->rx_errors++;
 		stats->tx_fifo_errors++;
@@ -289,6 +621,10 @@ EXPORT_SYMBOL_GPL(can_rx_offload_get_echo_skb);
 int can_rx_offload_queue_tail(struct can_rx_offload *offload,
 			      struct sk_buff *skb)
 {
+	can_rx_offload_get_cb(skb)->timestamp = 0;
+	if (can_rx_offload_oob_divert(offload, skb))
+		return 0;
+
 	if (skb_queue_len(&offload->skb_queue) >
 	    offload->skb_queue_len_max) {
 		dev_kfree_skb_any(skb);
@@ -312,6 +648,7 @@ static int can_rx_offload_init_queue(struct net_device *dev,
 	offload->skb_queue_len_max = 2 << fls(weight);
 	offload->skb_queue_len_max *= 4;
 	skb_queue_head_init(&offload->skb_queue);
+	can_rx_offload_oob_init(offload);
 
 	netif_napi_add(dev, &offload->napi, can_rx_offload_napi_poll, weight);
 
@@ -373,5 +710,6 @@ void can_rx_offload_del(struct can_rx_offload *offload)
 {
 	netif_napi_del(&offload->napi);
 	skb_queue_purge(&offload->skb_queue);
+	can_rx_offload_oob_del(offload);
 }
 EXPORT_SYMBOL_GPL(can_rx_offload_del);
@@ -11,6 +11,8 @@
 #include <linux/bitfield.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
+#include <linux/irq_pipeline.h>
+#include <linux/irqstage.h>
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/netdevice.h>
@@ -479,28 +481,13 @@ static void m_can_receive_skb(struct m_can_classdev *cdev,
 	}
 }
 
-static void m_can_read_fifo(struct net_device *dev, u32 rxfs)
+/* Fill @cf from RX FIFO 0 element @fgi, whose DLC word is @dlc. */
+static void m_can_read_frame(struct m_can_classdev *cdev, u32 fgi, u32 dlc,
+			     struct canfd_frame *cf)
 {
-	struct net_device_stats *stats = &dev->stats;
-	struct m_can_classdev *cdev = netdev_priv(dev);
-	struct canfd_frame *cf;
-	struct sk_buff *skb;
-	u32 id, fgi, dlc;
-	u32 timestamp = 0;
+	u32 id;
 	int i;
 
-	/* calculate the fifo get index for where to read data */
-	fgi = (rxfs & RXFS_FGI_MASK) >> RXFS_FGI_SHIFT;
-	dlc = m_can_fifo_read(cdev, fgi, M_CAN_FIFO_DLC);
-	if (dlc & RX_BUF_FDF)
-		skb = alloc_canfd_skb(dev, &cf);
-	else
-		skb = alloc_can_skb(dev, (struct can_frame **)&cf);
-	if (!skb) {
-		stats->rx_dropped++;
-		return;
-	}
-
 	if (dlc & RX_BUF_FDF)
 		cf->len = can_fd_dlc2len((dlc >> 16) & 0x0F);
 	else
@@ -512,10 +499,8 @@ static void m_can_read_fifo(struct net_device *dev, u32 rxfs)
 	else
 		cf->can_id = (id >> 18) & CAN_SFF_MASK;
 
-	if (id & RX_BUF_ESI) {
+	if (id & RX_BUF_ESI)
 		cf->flags |= CANFD_ESI;
-		netdev_dbg(dev, "ESI Error\n");
-	}
 
 	if (!(dlc & RX_BUF_FDF) && (id & RX_BUF_RTR)) {
 		cf->can_id |= CAN_RTR_FLAG;
@@ -528,6 +513,32 @@ static void m_can_read_fifo(struct net_device *dev, u32 rxfs)
 				m_can_fifo_read(cdev, fgi,
 						M_CAN_FIFO_DATA(i / 4));
 	}
+}
+
+static void m_can_read_fifo(struct net_device *dev, u32 rxfs)
+{
+	struct net_device_stats *stats = &dev->stats;
+	struct m_can_classdev *cdev = netdev_priv(dev);
+	struct canfd_frame *cf;
+	struct sk_buff *skb;
+	u32 fgi, dlc;
+	u32 timestamp = 0;
+
+	/* calculate the fifo get index for where to read data */
+	fgi = (rxfs & RXFS_FGI_MASK) >> RXFS_FGI_SHIFT;
+	dlc = m_can_fifo_read(cdev, fgi, M_CAN_FIFO_DLC);
+	if (dlc & RX_BUF_FDF)
+		skb = alloc_canfd_skb(dev, &cf);
+	else
+		skb = alloc_can_skb(dev, (struct can_frame **)&cf);
+	if (!skb) {
+		stats->rx_dropped++;
+		return;
+	}
+
+	m_can_read_frame(cdev, fgi, dlc, cf);
+	if (cf->flags & CANFD_ESI)
+		netdev_dbg(dev, "ESI Error\n");
 
 	/* acknowledge rx fifo 0 */
 	m_can_write(cdev, M_CAN_RXF0A, fgi);
@@ -566,6 +577,205 @@ static int m_can_do_rx_poll(struct net_device *dev, int quota)
 	return pkts;
 }
 
+#ifdef CONFIG_CAN_M_CAN_OOB
+
+/* Message marker of the frames sent from the oob stage, which have no
+ * echo skb. Must not collide with a TX FIFO put index.
+ */
+#define M_CAN_OOB_TX_MM		0xff
+
+/* MMIO devices take their IRQ from the oob stage if oob mode was
+ * enabled on the rx-offload when the interface was brought up.
+ */
+static inline bool m_can_oob_irq(struct m_can_classdev *cdev)
+{
+	return cdev->oob_irq;
+}
+
+static unsigned long m_can_oob_irq_flags(struct m_can_classdev *cdev)
+{
+	cdev->oob_irq = !cdev->is_peripheral &&
+		can_rx_offload_oob_active(&cdev->offload);
+	cdev->oob_rx_resume = false;
+
+	return cdev->oob_irq ? IRQF_OOB : 0;
+}
+
+/* RX FIFO 0 is drained to the oob ring directly from the oob IRQ. */
+static inline bool m_can_oob_rx_direct(struct m_can_classdev *cdev)
+{
+	return m_can_oob_irq(cdev) &&
+		can_rx_offload_oob_active(&cdev->offload);
+}
+
+static inline void m_can_oob_tx_lock(struct m_can_classdev *cdev,
+				     unsigned long *flags)
+{
+	if (!cdev->is_peripheral)
+		raw_spin_lock_irqsave(&cdev->oob_lock, *flags);
+}
+
+static inline void m_can_oob_tx_unlock(struct m_can_classdev *cdev,
+				       unsigned long flags)
+{
+	if (!cdev->is_peripheral)
+		raw_spin_unlock_irqrestore(&cdev->oob_lock, flags);
+}
+
+/* Frames sent from the oob stage take TX FIFO slots but no echo skb,
+ * so the put index cannot double as echo index for in-band frames.
+ * Echo slots are allocated in sequence instead, the message marker
+ * carries them to m_can_echo_tx_event().
+ */
+static inline int m_can_tx_echo_idx(struct m_can_classdev *cdev)
+{
+	return cdev->tx_echo_idx;
+}
+
+static inline void m_can_tx_echo_next(struct m_can_classdev *cdev)
+{
+	if (++cdev->tx_echo_idx >= cdev->can.echo_skb_max)
+		cdev->tx_echo_idx = 0;
+}
+
+/* Drain at most one FIFO worth of frames, returns true if some are
+ * left over.
+ */
+static bool m_can_oob_rx(struct m_can_classdev *cdev)
+{
+	int budget = cdev->mcfg[MRAM_RXF0].num;
+	struct canfd_frame cf;
+	u32 rxfs, fgi, dlc;
+
+	rxfs = m_can_read(cdev, M_CAN_RXF0S);
+	while ((rxfs & RXFS_FFL_MASK) && budget-- > 0) {
+		fgi = (rxfs & RXFS_FGI_MASK) >> RXFS_FGI_SHIFT;
+		dlc = m_can_fifo_read(cdev, fgi, M_CAN_FIFO_DLC);
+		memset(&cf, 0, sizeof(cf));
+		m_can_read_frame(cdev, fgi, dlc, &cf);
+		m_can_write(cdev, M_CAN_RXF0A, fgi);
+
+		/* Overflows are accounted for by the oob ring. */
+		can_rx_offload_oob_queue(&cdev->offload, &cf,
+					 dlc & RX_BUF_FDF ? CAN_OOB_FRAME_FD : 0,
+					 FIELD_GET(RX_BUF_RXTS_MASK, dlc));
+
+		rxfs = m_can_read(cdev, M_CAN_RXF0S);
+	}
+
+	return rxfs & RXFS_FFL_MASK;
+}
+
+static irqreturn_t m_can_oob_isr(int irq, struct m_can_classdev *cdev)
+{
+	unsigned long flags;
+	u32 ir;
+
+	ir = m_can_read(cdev, M_CAN_IR);
+	if (!ir && !cdev->oob_rx_resume)
+		return IRQ_NONE;
+
+	/* ACK all irqs */
+	if (ir & IR_ALL_INT)
+		m_can_write(cdev, M_CAN_IR, ir);
+
+	if (cdev->ops->clear_interrupts)
+		cdev->ops->clear_interrupts(cdev);
+
+	/* Leftovers from the previous run, see below. */
+	if (cdev->oob_rx_resume) {
+		cdev->oob_rx_resume = false;
+		ir |= IR_RF0N;
+	}
+
+	if ((ir & IR_RF0N) && m_can_oob_rx_direct(cdev)) {
+		/* Do not hog the oob stage if frames keep coming,
+		 * re-enter the pipeline from in-band for the rest.
+		 */
+		if (m_can_oob_rx(cdev)) {
+			cdev->oob_rx_resume = true;
+			irq_work_queue(&cdev->oob_rx_work);
+		}
+		ir &= ~IR_RF0N;
+	}
+
+	/* Everything else is handled by m_can_isr() in-band. */
+	if (ir) {
+		raw_spin_lock_irqsave(&cdev->oob_lock, flags);
+		cdev->oob_pending_ir |= ir;
+		raw_spin_unlock_irqrestore(&cdev->oob_lock, flags);
+		irq_post_inband(irq);
+	}
+
+	return IRQ_HANDLED;
+}
+
+static u32 m_can_oob_take_ir(struct m_can_classdev *cdev)
+{
+	unsigned long flags;
+	u32 ir;
+
+	raw_spin_lock_irqsave(&cdev->oob_lock, flags);
+	ir = cdev->oob_pending_ir;
+	cdev->oob_pending_ir = 0;
+	raw_spin_unlock_irqrestore(&cdev->oob_lock, flags);
+
+	return ir;
+}
+
+/* Resume the oob TX queue of a peripheral once FIFO slots are freed. */
+static void m_can_oob_tx_kick(struct m_can_classdev *cdev)
+{
+	if (cdev->is_peripheral && cdev->tx_wq &&
+	    READ_ONCE(cdev->oob_txq_head) != READ_ONCE(cdev->oob_txq_tail))
+		queue_work(cdev->tx_wq, &cdev->tx_work);
+}
+
+#else
+
+static inline bool m_can_oob_irq(struct m_can_classdev *cdev)
+{
+	return false;
+}
+
+static inline unsigned long m_can_oob_irq_flags(struct m_can_classdev *cdev)
+{
+	return 0;
+}
+
+static inline int m_can_tx_echo_idx(struct m_can_classdev *cdev)
+{
+	return (m_can_read(cdev, M_CAN_TXFQS) & TXFQS_TFQPI_MASK) >>
+		TXFQS_TFQPI_SHIFT;
+}
+
+static inline void m_can_tx_echo_next(struct m_can_classdev *cdev) { }
+
+static inline bool m_can_oob_rx_direct(struct m_can_classdev *cdev)
+{
+	return false;
+}
+
+static inline void m_can_oob_tx_lock(struct m_can_classdev *cdev,
+				     unsigned long *flags) { }
+
+static inline void m_can_oob_tx_unlock(struct m_can_classdev *cdev,
+				       unsigned long flags) { }
+
+static inline irqreturn_t m_can_oob_isr(int irq, struct m_can_classdev *cdev)
+{
+	return IRQ_NONE;
+}
+
+static inline u32 m_can_oob_take_ir(struct m_can_classdev *cdev)
+{
+	return 0;
+}
+
+static inline void m_can_oob_tx_kick(struct m_can_classdev *cdev) { }
+
+#endif /* CONFIG_CAN_M_CAN_OOB */
+
 static int m_can_handle_lost_msg(struct net_device *dev)
 {
 	struct m_can_classdev *cdev = netdev_priv(dev);
@@ -935,7 +1145,7 @@ static int m_can_rx_handler(struct net_device *dev, int quota)
 	if (irqstatus & IR_ERR_BUS_30X)
 		work_done += m_can_handle_bus_errors(dev, irqstatus, psr);
 
-	if (irqstatus & IR_RF0N)
+	if ((irqstatus & IR_RF0N) && !m_can_oob_rx_direct(cdev))
 		work_done += m_can_do_rx_poll(dev, (quota - work_done));
 end:
 	return work_done;
@@ -1023,6 +1233,11 @@ static void m_can_echo_tx_event(struct net_device *dev)
 		m_can_write(cdev, M_CAN_TXEFA, (TXEFA_EFAI_MASK &
 						(fgi << TXEFA_EFAI_SHIFT)));
 
+#ifdef CONFIG_CAN_M_CAN_OOB
+		/* frames sent from the oob stage have no echo skb */
+		if (msg_mark == M_CAN_OOB_TX_MM)
+			continue;
+#endif
 		/* update stats */
 		m_can_tx_update_stats(cdev, msg_mark, timestamp);
 	}
@@ -1036,16 +1251,26 @@ static irqreturn_t m_can_isr(int irq, void *dev_id)
 
 	if (pm_runtime_suspended(cdev->dev))
 		return IRQ_NONE;
-	ir = m_can_read(cdev, M_CAN_IR);
-	if (!ir)
-		return IRQ_NONE;
 
-	/* ACK all irqs */
-	if (ir & IR_ALL_INT)
-		m_can_write(cdev, M_CAN_IR, ir);
+	if (m_can_oob_irq(cdev)) {
+		/* The oob handler already acked IR, pick what it left. */
+		if (running_oob())
+			return m_can_oob_isr(irq, cdev);
+		ir = m_can_oob_take_ir(cdev);
+		if (!ir)
+			return IRQ_NONE;
+	} else {
+		ir = m_can_read(cdev, M_CAN_IR);
+		if (!ir)
+			return IRQ_NONE;
 
-	if (cdev->ops->clear_interrupts)
-		cdev->ops->clear_interrupts(cdev);
+		/* ACK all irqs */
+		if (ir & IR_ALL_INT)
+			m_can_write(cdev, M_CAN_IR, ir);
+
+		if (cdev->ops->clear_interrupts)
+			cdev->ops->clear_interrupts(cdev);
+	}
 
 	/* schedule NAPI in case of
 	 * - rx IRQ
@@ -1054,7 +1279,9 @@ static irqreturn_t m_can_isr(int irq, void *dev_id)
 	 */
 	if ((ir & IR_RF0N) || (ir & IR_ERR_ALL_30X)) {
 		cdev->irqstatus = ir;
-		m_can_disable_all_interrupts(cdev);
+		/* keep the oob RX path going while NAPI runs */
+		if (!m_can_oob_rx_direct(cdev))
+			m_can_disable_all_interrupts(cdev);
 		if (!cdev->is_peripheral)
 			napi_schedule(&cdev->napi);
 		else
@@ -1077,6 +1304,7 @@ static irqreturn_t m_can_isr(int irq, void *dev_id)
 		if (ir & IR_TEFN) {
 			/* New TX FIFO Element arrived */
 			m_can_echo_tx_event(dev);
+			m_can_oob_tx_kick(cdev);
 			can_led_event(dev, CAN_LED_EVENT_TX);
 			if (netif_queue_stopped(dev) &&
 			    !m_can_tx_fifo_full(cdev))
@@ -1526,9 +1754,16 @@ static int m_can_close(struct net_device *dev)
 
 	if (cdev->is_peripheral) {
 		cdev->tx_skb = NULL;
+#ifdef CONFIG_CAN_M_CAN_OOB
+		irq_work_sync(&cdev->oob_tx_work);
+#endif
 		destroy_workqueue(cdev->tx_wq);
 		cdev->tx_wq = NULL;
 	}
+#ifdef CONFIG_CAN_M_CAN_OOB
+	if (!cdev->is_peripheral)
+		irq_work_sync(&cdev->oob_rx_work);
+#endif
 
 	if (cdev->is_peripheral)
 		can_rx_offload_disable(&cdev->offload);
@@ -1553,19 +1788,12 @@ static int m_can_next_echo_skb_occupied(struct net_device *dev, int putidx)
 	return !!cdev->can.echo_skb[next_idx];
 }
 
-static netdev_tx_t m_can_tx_handler(struct m_can_classdev *cdev)
+/* Generate ID field for TX buffer Element */
+/* Common to all supported M_CAN versions */
+static u32 m_can_tx_id(const struct canfd_frame *cf)
 {
-	struct canfd_frame *cf = (struct canfd_frame *)cdev->tx_skb->data;
-	struct net_device *dev = cdev->net;
-	struct sk_buff *skb = cdev->tx_skb;
-	u32 id, cccr, fdflags;
-	int i;
-	int putidx;
-
-	cdev->tx_skb = NULL;
+	u32 id;
 
-	/* Generate ID field for TX buffer Element */
-	/* Common to all supported M_CAN versions */
 	if (cf->can_id & CAN_EFF_FLAG) {
 		id = cf->can_id & CAN_EFF_MASK;
 		id |= TX_BUF_XTD;
@@ -1576,11 +1804,57 @@ static netdev_tx_t m_can_tx_handler(struct m_can_classdev *cdev)
 	if (cf->can_id & CAN_RTR_FLAG)
 		id |= TX_BUF_RTR;
 
+	return id;
+}
+
+/* Fill TX FIFO element @putidx for version >= v3.1.x, @mm is the
+ * message marker reported back by the TX event FIFO.
+ */
+static void m_can_write_tx_element(struct m_can_classdev *cdev, int putidx,
+				   u32 mm, const struct canfd_frame *cf,
+				   bool fd)
+{
+	u32 fdflags = 0;
+	int i;
+
+	/* Write ID Field to FIFO Element */
+	m_can_fifo_write(cdev, putidx, M_CAN_FIFO_ID, m_can_tx_id(cf));
+
+	/* get CAN FD configuration of frame */
+	if (fd) {
+		fdflags |= TX_BUF_FDF;
+		if (cf->flags & CANFD_BRS)
+			fdflags |= TX_BUF_BRS;
+	}
+
+	/* Construct DLC Field. Also contains CAN-FD configuration */
+	m_can_fifo_write(cdev, putidx, M_CAN_FIFO_DLC,
+			 ((mm << TX_BUF_MM_SHIFT) & TX_BUF_MM_MASK) |
+			 (can_fd_len2dlc(cf->len) << 16) |
+			 fdflags | TX_BUF_EFC);
+
+	for (i = 0; i < cf->len; i += 4)
+		m_can_fifo_write(cdev, putidx, M_CAN_FIFO_DATA(i / 4),
+				 *(const u32 *)(cf->data + i));
+}
+
+static netdev_tx_t m_can_tx_handler(struct m_can_classdev *cdev)
+{
+	struct canfd_frame *cf = (struct canfd_frame *)cdev->tx_skb->data;
+	struct net_device *dev = cdev->net;
+	struct sk_buff *skb = cdev->tx_skb;
+	unsigned long flags;
+	u32 cccr;
+	int i;
+	int putidx;
+
+	cdev->tx_skb = NULL;
+
 	if (cdev->version == 30) {
 		netif_stop_queue(dev);
 
 		/* message ram configuration */
-		m_can_fifo_write(cdev, 0, M_CAN_FIFO_ID, id);
+		m_can_fifo_write(cdev, 0, M_CAN_FIFO_ID, m_can_tx_id(cf));
 		m_can_fifo_write(cdev, 0, M_CAN_FIFO_DLC,
 				 can_fd_len2dlc(cf->len) << 16);
 
@@ -1611,6 +1885,7 @@ static netdev_tx_t m_can_tx_handler(struct m_can_classdev *cdev)
 		/* End of xmit function for version 3.0.x */
 	} else {
 		/* Transmit routine for version >= v3.1.x */
+		int echo_idx;
 
 		/* Check if FIFO full */
 		if (m_can_tx_fifo_full(cdev)) {
@@ -1628,58 +1903,180 @@ static netdev_tx_t m_can_tx_handler(struct m_can_classdev *cdev)
 			}
 		}
 
+		/* Push loopback echo.
+		 * Will be looped back on TX interrupt based on message marker
+		 */
+		echo_idx = m_can_tx_echo_idx(cdev);
+		can_put_echo_skb(skb, dev, echo_idx, 0);
+
+		/* The oob stage may submit to the same FIFO on MMIO
+		 * devices, serialize the put index allocation with it.
+		 */
+		m_can_oob_tx_lock(cdev, &flags);
+
+		/* The oob stage may have taken the last free slot. */
+		if (IS_ENABLED(CONFIG_CAN_M_CAN_OOB) && !cdev->is_peripheral &&
+		    m_can_tx_fifo_full(cdev)) {
+			m_can_oob_tx_unlock(cdev, flags);
+			can_free_echo_skb(dev, echo_idx, NULL);
+			dev->stats.tx_dropped++;
+			netif_stop_queue(dev);
+			return NETDEV_TX_OK;
+		}
+
 		/* get put index for frame */
 		putidx = ((m_can_read(cdev, M_CAN_TXFQS) & TXFQS_TFQPI_MASK)
 			  >> TXFQS_TFQPI_SHIFT);
-		/* Write ID Field to FIFO Element */
-		m_can_fifo_write(cdev, putidx, M_CAN_FIFO_ID, id);
-
-		/* get CAN FD configuration of frame */
-		fdflags = 0;
-		if (can_is_canfd_skb(skb)) {
-			fdflags |= TX_BUF_FDF;
-			if (cf->flags & CANFD_BRS)
-				fdflags |= TX_BUF_BRS;
-		}
 
-		/* Construct DLC Field. Also contains CAN-FD configuration
-		 * use put index of fifo as message marker
+		/* use echo index as message marker
 		 * it is used in TX interrupt for
 		 * sending the correct echo frame
 		 */
-		m_can_fifo_write(cdev, putidx, M_CAN_FIFO_DLC,
-				 ((putidx << TX_BUF_MM_SHIFT) &
-				  TX_BUF_MM_MASK) |
-				 (can_fd_len2dlc(cf->len) << 16) |
-				 fdflags | TX_BUF_EFC);
-
-		for (i = 0; i < cf->len; i += 4)
-			m_can_fifo_write(cdev, putidx, M_CAN_FIFO_DATA(i / 4),
-					 *(u32 *)(cf->data + i));
-
-		/* Push loopback echo.
-		 * Will be looped back on TX interrupt based on message marker
-		 */
-		can_put_echo_skb(skb, dev, putidx, 0);
+		m_can_write_tx_element(cdev, putidx, echo_idx, cf,
+				       can_is_canfd_skb(skb));
 
 		/* Enable TX FIFO element to start transfer  */
 		m_can_write(cdev, M_CAN_TXBAR, (1 << putidx));
 
+		m_can_oob_tx_unlock(cdev, flags);
+
+		m_can_tx_echo_next(cdev);
+
 		/* stop network queue if fifo full */
 		if (m_can_tx_fifo_full(cdev) ||
-		    m_can_next_echo_skb_occupied(dev, putidx))
+		    m_can_next_echo_skb_occupied(dev, echo_idx))
 			netif_stop_queue(dev);
 	}
 
 	return NETDEV_TX_OK;
 }
 
+#ifdef CONFIG_CAN_M_CAN_OOB
+
+static int m_can_oob_xmit(struct can_rx_offload *offload,
+			  const struct canfd_frame *cf, u32 flags)
+{
+	struct m_can_classdev *cdev = container_of(offload,
+						   struct m_can_classdev,
+						   offload);
+	bool fd = flags & CAN_OOB_FRAME_FD;
+	struct m_can_oob_txd *txd;
+	unsigned long irqflags;
+	int putidx, ret = 0;
+
+	if (cf->len > (fd ? CANFD_MAX_DLEN : CAN_MAX_DLEN))
+		return -EINVAL;
+
+	if (fd && !(cdev->can.ctrlmode & CAN_CTRLMODE_FD))
+		return -EINVAL;
+
+	if (!netif_running(cdev->net) ||
+	    cdev->can.state == CAN_STATE_BUS_OFF)
+		return -ENETDOWN;
+
+	raw_spin_lock_irqsave(&cdev->oob_lock, irqflags);
+
+	if (cdev->is_peripheral) {
+		/* SPI transfers cannot run oob, defer to the TX worker. */
+		if (cdev->oob_txq_head - cdev->oob_txq_tail >=
+		    M_CAN_OOB_TXQ_LEN) {
+			ret = -EAGAIN;
+			goto out;
+		}
+		txd = &cdev->oob_txq[cdev->oob_txq_head % M_CAN_OOB_TXQ_LEN];
+		txd->cf = *cf;
+		txd->flags = flags;
+		WRITE_ONCE(cdev->oob_txq_head, cdev->oob_txq_head + 1);
+		irq_work_queue(&cdev->oob_tx_work);
+		goto out;
+	}
+
+	if (m_can_tx_fifo_full(cdev)) {
+		ret = -EAGAIN;
+		goto out;
+	}
+
+	putidx = ((m_can_read(cdev, M_CAN_TXFQS) & TXFQS_TFQPI_MASK)
+		  >> TXFQS_TFQPI_SHIFT);
+	m_can_write_tx_element(cdev, putidx, M_CAN_OOB_TX_MM, cf, fd);
+	m_can_write(cdev, M_CAN_TXBAR, (1 << putidx));
+out:
+	raw_spin_unlock_irqrestore(&cdev->oob_lock, irqflags);
+
+	return ret;
+}
+
+static void m_can_oob_tx_irq_work(struct irq_work *work)
+{
+	struct m_can_classdev *cdev = container_of(work,
+						   struct m_can_classdev,
+						   oob_tx_work);
+
+	m_can_oob_tx_kick(cdev);
+}
+
+static void m_can_oob_rx_irq_work(struct irq_work *work)
+{
+	struct m_can_classdev *cdev = container_of(work,
+						   struct m_can_classdev,
+						   oob_rx_work);
+
+	irq_inject_pipeline(cdev->net->irq);
+}
+
+/* Push the frames queued by m_can_oob_xmit() to a peripheral. */
+static void m_can_oob_tx_drain(struct m_can_classdev *cdev)
+{
+	struct m_can_oob_txd txd;
+	unsigned long flags;
+	int putidx;
+
+	while (!m_can_tx_fifo_full(cdev)) {
+		raw_spin_lock_irqsave(&cdev->oob_lock, flags);
+		if (cdev->oob_txq_tail == cdev->oob_txq_head) {
+			raw_spin_unlock_irqrestore(&cdev->oob_lock, flags);
+			break;
+		}
+		txd = cdev->oob_txq[cdev->oob_txq_tail % M_CAN_OOB_TXQ_LEN];
+		WRITE_ONCE(cdev->oob_txq_tail, cdev->oob_txq_tail + 1);
+		raw_spin_unlock_irqrestore(&cdev->oob_lock, flags);
+
+		putidx = ((m_can_read(cdev, M_CAN_TXFQS) & TXFQS_TFQPI_MASK)
+			  >> TXFQS_TFQPI_SHIFT);
+		m_can_write_tx_element(cdev, putidx, M_CAN_OOB_TX_MM, &txd.cf,
+				       txd.flags & CAN_OOB_FRAME_FD);
+		m_can_write(cdev, M_CAN_TXBAR, (1 << putidx));
+	}
+}
+
+static void m_can_oob_setup(struct m_can_classdev *cdev)
+{
+	raw_spin_lock_init(&cdev->oob_lock);
+	init_irq_work(&cdev->oob_tx_work, m_can_oob_tx_irq_work);
+	init_irq_work(&cdev->oob_rx_work, m_can_oob_rx_irq_work);
+
+	/* Version 3.0.x has a single TX buffer and no event FIFO. */
+	if (cdev->version > 30)
+		cdev->offload.oob.xmit = m_can_oob_xmit;
+}
+
+#else
+
+static inline void m_can_oob_tx_drain(struct m_can_classdev *cdev) { }
+
+static inline void m_can_oob_setup(struct m_can_classdev *cdev) { }
+
+#endif /* CONFIG_CAN_M_CAN_OOB */
+
 static void m_can_tx_work_queue(struct work_struct *ws)
 {
 	struct m_can_classdev *cdev = container_of(ws, struct m_can_classdev,
 						   tx_work);
 
-	m_can_tx_handler(cdev);
+	m_can_oob_tx_drain(cdev);
+
+	if (cdev->tx_skb)
+		m_can_tx_handler(cdev);
 }
 
 static netdev_tx_t m_can_start_xmit(struct sk_buff *skb,
@@ -1751,8 +2148,9 @@ static int m_can_open(struct net_device *dev)
 					   IRQF_ONESHOT,
 					   dev->name, dev);
 	} else {
-		err = request_irq(dev->irq, m_can_isr, IRQF_SHARED, dev->name,
-				  dev);
+		err = request_irq(dev->irq, m_can_isr,
+				  IRQF_SHARED | m_can_oob_irq_flags(cdev),
+				  dev->name, dev);
 	}
 
 	if (err < 0) {
@@ -1916,6 +2314,16 @@ void m_can_class_free_dev(struct net_device *net)
 }
 EXPORT_SYMBOL_GPL(m_can_class_free_dev);
 
+static void m_can_offload_del(struct m_can_classdev *cdev)
+{
+	if (cdev->is_peripheral)
+		can_rx_offload_del(&cdev->offload);
+#ifdef CONFIG_CAN_M_CAN_OOB
+	else
+		can_rx_offload_del_oob(&cdev->offload);
+#endif
+}
+
 int m_can_class_register(struct m_can_classdev *cdev)
 {
 	int ret;
@@ -1932,11 +2340,21 @@ int m_can_class_register(struct m_can_classdev *cdev)
 		if (ret)
 			goto clk_disable;
 	}
+#ifdef CONFIG_CAN_M_CAN_OOB
+	else {
+		/* NAPI does RX in-band, only the oob ring is needed. */
+		ret = can_rx_offload_add_oob(cdev->net, &cdev->offload);
+		if (ret)
+			goto clk_disable;
+	}
+#endif
 
 	ret = m_can_dev_setup(cdev);
 	if (ret)
 		goto rx_offload_del;
 
+	m_can_oob_setup(cdev);
+
 	ret = register_m_can_dev(cdev->net);
 	if (ret) {
 		dev_err(cdev->dev, "registering %s failed (err=%d)\n",
@@ -1959,8 +2377,7 @@ int m_can_class_register(struct m_can_classdev *cdev)
 	return 0;
 
 rx_offload_del:
-	if (cdev->is_peripheral)
-		can_rx_offload_del(&cdev->offload);
+	m_can_offload_del(cdev);
 clk_disable:
 	m_can_clk_stop(cdev);
 
@@ -1970,8 +2387,7 @@ EXPORT_SYMBOL_GPL(m_can_class_register);
 
 void m_can_class_unregister(struct m_can_classdev *cdev)
 {
-	if (cdev->is_peripheral)
-		can_rx_offload_del(&cdev->offload);
+	m_can_offload_del(cdev);
 	unregister_candev(cdev->net);
 }
 EXPORT_SYMBOL_GPL(m_can_class_unregister);
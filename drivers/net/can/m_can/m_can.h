@@ -28,6 +28,7 @@
 #include <linux/iopoll.h>
 #include <linux/can/dev.h>
 #include <linux/pinctrl/consumer.h>
+#include <linux/irq_work.h>
 
 /* m_can lec values */
 enum m_can_lec_type {
@@ -58,6 +59,16 @@ struct mram_cfg {
 	u8  num;
 };
 
+#ifdef CONFIG_CAN_M_CAN_OOB
+/* Frames submitted from the oob stage to a peripheral, pending SPI I/O */
+#define M_CAN_OOB_TXQ_LEN	16
+
+struct m_can_oob_txd {
+	struct canfd_frame cf;
+	u32 flags;
+};
+#endif
+
 struct m_can_classdev;
 struct m_can_ops {
 	/* Device specific call backs */
@@ -95,6 +106,19 @@ struct m_can_classdev {
 	int is_peripheral;
 
 	struct mram_cfg mcfg[MRAM_CFG_NUM];
+
+#ifdef CONFIG_CAN_M_CAN_OOB
+	hard_spinlock_t oob_lock;
+	bool oob_irq;
+	bool oob_rx_resume;
+	u32 oob_pending_ir;
+	struct irq_work oob_rx_work;
+	unsigned int tx_echo_idx;
+	struct m_can_oob_txd oob_txq[M_CAN_OOB_TXQ_LEN];
+	unsigned int oob_txq_head;
+	unsigned int oob_txq_tail;
+	struct irq_work oob_tx_work;
+#endif
 };
 
 struct m_can_classdev *m_can_class_allocate_dev(struct device *dev, int sizeof_priv);
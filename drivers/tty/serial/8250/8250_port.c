@@ -2507,6 +2507,128 @@ static void serial8250_shutdown(struct uart_port *port)
 		serial8250_do_shutdown(port);
 }
 
+#ifdef CONFIG_SERIAL_CORE_OOB
+
+/*
+ * Out-of-band mode: RX is drained into the serial core oob ring and TX
+ * refilled from it by an IRQF_OOB handler. Only plain PIO ports using
+ * the default interrupt handler qualify, DMA, RS485 emulation, the
+ * backup timer and vendor IRQ handlers all depend on in-band code.
+ * The IRQ line must not be shared either, since an oob handler cannot
+ * share it with in-band ones.
+ */
+static irqreturn_t serial8250_oob_irq(int irq, void *dev_id)
+{
+	struct uart_8250_port *up = dev_id;
+	struct uart_port *port = &up->port;
+	unsigned char buf[64];
+	int max_count = 256;
+	unsigned int n = 0, i;
+	unsigned char lsr;
+
+	if (serial_port_in(port, UART_IIR) & UART_IIR_NO_INT)
+		return IRQ_NONE;
+
+	lsr = serial_port_in(port, UART_LSR);
+	while (lsr & (UART_LSR_DR | UART_LSR_BI)) {
+		if (lsr & UART_LSR_DR)
+			buf[n++] = serial_port_in(port, UART_RX);
+		if (unlikely(lsr & UART_LSR_BRK_ERROR_BITS)) {
+			if (lsr & UART_LSR_BI)
+				port->icount.brk++;
+			else if (lsr & UART_LSR_PE)
+				port->icount.parity++;
+			else if (lsr & UART_LSR_FE)
+				port->icount.frame++;
+			if (lsr & UART_LSR_OE)
+				port->icount.overrun++;
+		}
+		if (n == sizeof(buf)) {
+			uart_oob_rx_chars(port, buf, n);
+			n = 0;
+		}
+		if (--max_count == 0)
+			break;
+		lsr = serial_port_in(port, UART_LSR);
+	}
+
+	if (n)
+		uart_oob_rx_chars(port, buf, n);
+
+	if ((lsr & UART_LSR_THRE) && (up->ier & UART_IER_THRI)) {
+		n = uart_oob_tx_chars(port, buf,
+				      min_t(unsigned int, up->tx_loadsz,
+					    sizeof(buf)));
+		for (i = 0; i < n; i++)
+			serial_port_out(port, UART_TX, buf[i]);
+	}
+
+	return IRQ_HANDLED;
+}
+
+static void serial8250_oob_start_tx(struct uart_port *port)
+{
+	serial8250_set_THRI(up_to_u8250p(port));
+}
+
+static void serial8250_oob_stop_tx(struct uart_port *port)
+{
+	serial8250_clear_THRI(up_to_u8250p(port));
+}
+
+static void serial8250_oob_set_ier(struct uart_8250_port *up,
+				   unsigned char ier)
+{
+	struct uart_port *port = &up->port;
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&port->oob_state->lock, flags);
+	up->ier = ier;
+	serial_port_out(port, UART_IER, ier);
+	raw_spin_unlock_irqrestore(&port->oob_state->lock, flags);
+}
+
+static int serial8250_oob_enable(struct uart_port *port)
+{
+	struct uart_8250_port *up = up_to_u8250p(port);
+	int ret;
+
+	if (!port->irq || (port->irqflags & IRQF_SHARED) ||
+	    up->dma || up->em485 || (up->bugs & UART_BUG_THRE) ||
+	    port->handle_irq != serial8250_default_handle_irq)
+		return -EOPNOTSUPP;
+
+	up->ops->release_irq(up);
+
+	/* No modem status nor in-band TX from now on. */
+	up->oob_saved_ier = up->ier & ~UART_IER_THRI;
+	serial8250_oob_set_ier(up, UART_IER_RLSI | UART_IER_RDI);
+
+	/* Ports chained on a single IRQ line by 8250_core fail here. */
+	ret = request_irq(port->irq, serial8250_oob_irq,
+			  port->irqflags | IRQF_OOB, port->name, up);
+	if (ret) {
+		dev_err(port->dev, "could not attach oob interrupt: %d\n",
+			ret);
+		serial8250_oob_set_ier(up, up->oob_saved_ier);
+		WARN_ON(up->ops->setup_irq(up));
+	}
+
+	return ret;
+}
+
+static void serial8250_oob_disable(struct uart_port *port)
+{
+	struct uart_8250_port *up = up_to_u8250p(port);
+
+	free_irq(port->irq, up);
+	/* Pending oob output is dropped. */
+	serial8250_oob_set_ier(up, up->oob_saved_ier);
+	WARN_ON(up->ops->setup_irq(up));
+}
+
+#endif /* CONFIG_SERIAL_CORE_OOB */
+
 /* Nuvoton NPCM UARTs have a custom divisor calculation */
 static unsigned int npcm_get_divisor(struct uart_8250_port *up,
 		unsigned int baud)
@@ -3221,6 +3343,12 @@ static const struct uart_ops serial8250_pops = {
 	.poll_get_char = serial8250_get_poll_char,
 	.poll_put_char = serial8250_put_poll_char,
 #endif
+#ifdef CONFIG_SERIAL_CORE_OOB
+	.oob_enable	= serial8250_oob_enable,
+	.oob_disable	= serial8250_oob_disable,
+	.oob_start_tx	= serial8250_oob_start_tx,
+	.oob_stop_tx	= serial8250_oob_stop_tx,
+#endif
 };
 
 void serial8250_init_port(struct uart_8250_port *up)
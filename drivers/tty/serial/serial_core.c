@@ -25,6 +25,8 @@
 #include <linux/delay.h>
 #include <linux/mutex.h>
 #include <linux/security.h>
+#include <linux/poll.h>
+#include <linux/dovetail.h>
 
 #include <linux/irq.h>
 #include <linux/uaccess.h>
@@ -123,7 +125,7 @@ static void __uart_start(struct tty_struct *tty)
 	struct uart_state *state = tty->driver_data;
 	struct uart_port *port = state->uart_port;
 
-	if (port && !uart_tx_stopped(port))
+	if (port && !uart_tx_stopped(port) && !uart_oob_active(port))
 		port->ops->start_tx(port);
 }
 
@@ -554,7 +556,7 @@ static int uart_put_char(struct tty_struct *tty, unsigned char c)
 
 	circ = &state->xmit;
 	port = uart_port_lock(state, flags);
-	if (!circ->buf) {
+	if (!circ->buf || uart_oob_active(port)) {
 		uart_port_unlock(port, flags);
 		return 0;
 	}
@@ -592,6 +594,11 @@ static int uart_write(struct tty_struct *tty,
 	}
 
 	port = uart_port_lock(state, flags);
+	if (uart_oob_active(port)) {
+		uart_port_unlock(port, flags);
+		return -EBUSY;
+	}
+
 	circ = &state->xmit;
 	if (!circ->buf) {
 		uart_port_unlock(port, flags);
@@ -683,6 +690,11 @@ static void uart_send_xchar(struct tty_struct *tty, char ch)
 	if (!port)
 		return;
 
+	if (uart_oob_active(port)) {
+		uart_port_deref(port);
+		return;
+	}
+
 	if (port->ops->send_xchar)
 		port->ops->send_xchar(port, ch);
 	else {
@@ -1021,7 +1033,10 @@ static int uart_set_info_user(struct tty_struct *tty, struct serial_struct *ss)
 	 * under us.
 	 */
 	mutex_lock(&port->mutex);
-	retval = uart_set_info(tty, port, state, ss);
+	if (uart_oob_active(state->uart_port))
+		retval = -EBUSY;
+	else
+		retval = uart_set_info(tty, port, state, ss);
 	mutex_unlock(&port->mutex);
 	up_write(&tty->termios_rwsem);
 	return retval;
@@ -1112,6 +1127,11 @@ static int uart_break_ctl(struct tty_struct *tty, int break_state)
 	if (!uport)
 		goto out;
 
+	if (uart_oob_active(uport)) {
+		ret = -EBUSY;
+		goto out;
+	}
+
 	if (uport->type != PORT_UNKNOWN && uport->ops->break_ctl)
 		uport->ops->break_ctl(uport, break_state);
 	ret = 0;
@@ -1374,6 +1394,335 @@ static int uart_set_iso7816_config(struct uart_port *port,
 	return 0;
 }
 
+#ifdef CONFIG_SERIAL_CORE_OOB
+
+/* Chunk size for moving data between the oob rings and user memory. */
+#define UART_OOB_BOUNCE_SIZE	64
+
+static unsigned int uart_oob_push(struct circ_buf *circ,
+				  const unsigned char *buf, unsigned int count)
+{
+	unsigned int c, ret = 0;
+
+	while (ret < count) {
+		c = CIRC_SPACE_TO_END(circ->head, circ->tail, UART_XMIT_SIZE);
+		c = min(c, count - ret);
+		if (!c)
+			break;
+		memcpy(circ->buf + circ->head, buf + ret, c);
+		circ->head = (circ->head + c) & (UART_XMIT_SIZE - 1);
+		ret += c;
+	}
+
+	return ret;
+}
+
+static unsigned int uart_oob_pop(struct circ_buf *circ,
+				 unsigned char *buf, unsigned int count)
+{
+	unsigned int c, ret = 0;
+
+	while (ret < count) {
+		c = CIRC_CNT_TO_END(circ->head, circ->tail, UART_XMIT_SIZE);
+		c = min(c, count - ret);
+		if (!c)
+			break;
+		memcpy(buf + ret, circ->buf + circ->tail, c);
+		circ->tail = (circ->tail + c) & (UART_XMIT_SIZE - 1);
+		ret += c;
+	}
+
+	return ret;
+}
+
+/**
+ *	uart_oob_rx_chars - queue received characters for oob readers
+ *	@port: uart port in oob mode
+ *	@buf: characters read from the hardware
+ *	@count: number of characters in @buf
+ *
+ *	Called by the driver's oob interrupt handler. Characters which
+ *	do not fit into the rx ring are dropped and accounted as buffer
+ *	overruns.
+ */
+void uart_oob_rx_chars(struct uart_port *port, const unsigned char *buf,
+		       unsigned int count)
+{
+	struct uart_oob_state *oob = port->oob_state;
+	unsigned long flags;
+	unsigned int n;
+
+	raw_spin_lock_irqsave(&oob->lock, flags);
+	n = uart_oob_push(&oob->rx, buf, count);
+	port->icount.rx += n;
+	port->icount.buf_overrun += count - n;
+	raw_spin_unlock_irqrestore(&oob->lock, flags);
+
+	if (n)
+		oob_poll_signal(&oob->poll, EPOLLIN | EPOLLRDNORM);
+}
+EXPORT_SYMBOL_GPL(uart_oob_rx_chars);
+
+/**
+ *	uart_oob_tx_chars - fetch characters to transmit in oob mode
+ *	@port: uart port in oob mode
+ *	@buf: buffer receiving the characters
+ *	@count: room in @buf, usually the free space in the tx FIFO
+ *
+ *	Called by the driver's oob interrupt handler. Once the tx ring
+ *	is drained, ->oob_stop_tx() is invoked. Returns the number of
+ *	characters copied to @buf.
+ */
+unsigned int uart_oob_tx_chars(struct uart_port *port, unsigned char *buf,
+			       unsigned int count)
+{
+	struct uart_oob_state *oob = port->oob_state;
+	unsigned long flags;
+	unsigned int n;
+
+	raw_spin_lock_irqsave(&oob->lock, flags);
+	n = uart_oob_pop(&oob->tx, buf, count);
+	port->icount.tx += n;
+	if (uart_circ_empty(&oob->tx))
+		port->ops->oob_stop_tx(port);
+	raw_spin_unlock_irqrestore(&oob->lock, flags);
+
+	if (n)
+		oob_poll_signal(&oob->poll, EPOLLOUT | EPOLLWRNORM);
+
+	return n;
+}
+EXPORT_SYMBOL_GPL(uart_oob_tx_chars);
+
+static struct uart_port *uart_oob_port(struct tty_struct *tty)
+{
+	struct uart_state *state = tty->driver_data;
+	struct uart_port *uport = READ_ONCE(state->uart_port);
+
+	return uart_oob_active(uport) ? uport : NULL;
+}
+
+/*
+ * The oob I/O handlers never block, oob callers should wait for
+ * EPOLLIN/EPOLLOUT with oob_poll() when -EAGAIN is returned.
+ */
+static ssize_t uart_oob_read(struct tty_struct *tty, char __user *buf,
+			     size_t count)
+{
+	struct uart_port *uport = uart_oob_port(tty);
+	unsigned char bounce[UART_OOB_BOUNCE_SIZE];
+	struct uart_oob_state *oob;
+	unsigned long flags;
+	size_t done = 0;
+	unsigned int c;
+
+	if (!uport)
+		return -EBADFD;
+
+	if (!access_ok(buf, count))
+		return -EFAULT;
+
+	oob = uport->oob_state;
+	while (done < count) {
+		raw_spin_lock_irqsave(&oob->lock, flags);
+		c = uart_oob_pop(&oob->rx, bounce,
+				 min_t(size_t, count - done, sizeof(bounce)));
+		raw_spin_unlock_irqrestore(&oob->lock, flags);
+		if (!c)
+			break;
+		if (raw_copy_to_user(buf + done, bounce, c))
+			return done ?: -EFAULT;
+		done += c;
+	}
+
+	return done ?: -EAGAIN;
+}
+
+static ssize_t uart_oob_write(struct tty_struct *tty, const char __user *buf,
+			      size_t count)
+{
+	struct uart_port *uport = uart_oob_port(tty);
+	unsigned char bounce[UART_OOB_BOUNCE_SIZE];
+	struct uart_oob_state *oob;
+	unsigned int c, len;
+	unsigned long flags;
+	size_t done = 0;
+
+	if (!uport)
+		return -EBADFD;
+
+	if (!access_ok(buf, count))
+		return -EFAULT;
+
+	oob = uport->oob_state;
+	while (done < count) {
+		len = min_t(size_t, count - done, sizeof(bounce));
+		if (raw_copy_from_user(bounce, buf + done, len))
+			return done ?: -EFAULT;
+		raw_spin_lock_irqsave(&oob->lock, flags);
+		c = uart_oob_push(&oob->tx, bounce, len);
+		if (c)
+			uport->ops->oob_start_tx(uport);
+		raw_spin_unlock_irqrestore(&oob->lock, flags);
+		done += c;
+		if (c < len)
+			break;
+	}
+
+	return done ?: -EAGAIN;
+}
+
+static __poll_t uart_oob_poll(struct tty_struct *tty,
+			      struct oob_poll_wait *wait)
+{
+	struct uart_port *uport = uart_oob_port(tty);
+	struct uart_oob_state *oob;
+	__poll_t events = 0;
+	unsigned long flags;
+
+	if (!uport)
+		return EPOLLERR;
+
+	oob = uport->oob_state;
+	oob_poll_watch(&oob->poll, wait);
+
+	raw_spin_lock_irqsave(&oob->lock, flags);
+	if (!uart_circ_empty(&oob->rx))
+		events |= EPOLLIN | EPOLLRDNORM;
+	if (uart_circ_chars_free(&oob->tx))
+		events |= EPOLLOUT | EPOLLWRNORM;
+	raw_spin_unlock_irqrestore(&oob->lock, flags);
+
+	return events;
+}
+
+static struct uart_oob_state *uart_oob_alloc(void)
+{
+	struct uart_oob_state *oob;
+
+	oob = kzalloc(sizeof(*oob), GFP_KERNEL);
+	if (!oob)
+		return NULL;
+
+	oob->rx.buf = kmalloc(UART_XMIT_SIZE, GFP_KERNEL);
+	oob->tx.buf = kmalloc(UART_XMIT_SIZE, GFP_KERNEL);
+	if (!oob->rx.buf || !oob->tx.buf) {
+		kfree(oob->rx.buf);
+		kfree(oob->tx.buf);
+		kfree(oob);
+		return NULL;
+	}
+
+	raw_spin_lock_init(&oob->lock);
+	oob_poll_head_init(&oob->poll);
+
+	return oob;
+}
+
+/*
+ * The oob state outlives the oob mode, so that oob callers racing
+ * with uart_oob_disable() never see it vanish. It is only released
+ * with the port.
+ */
+static void uart_oob_free(struct uart_port *uport)
+{
+	struct uart_oob_state *oob = uport->oob_state;
+
+	if (!oob)
+		return;
+
+	uport->oob_state = NULL;
+	oob_poll_head_destroy(&oob->poll);
+	kfree(oob->rx.buf);
+	kfree(oob->tx.buf);
+	kfree(oob);
+}
+
+/* Caller holds port->mutex. */
+static int uart_oob_enable(struct uart_state *state, struct uart_port *uport)
+{
+	struct uart_oob_state *oob;
+	unsigned long flags;
+	int ret;
+
+	if (uport->oob_active)
+		return 0;
+
+	if (!uport->ops->oob_enable)
+		return -EOPNOTSUPP;
+
+	/* printk() would have to go through the in-band tty path. */
+	if (uart_console(uport))
+		return -EBUSY;
+
+	if (!uport->oob_state) {
+		uport->oob_state = uart_oob_alloc();
+		if (!uport->oob_state)
+			return -ENOMEM;
+	}
+
+	oob = uport->oob_state;
+	uart_circ_clear(&oob->rx);
+	uart_circ_clear(&oob->tx);
+
+	/*
+	 * Fence off the in-band output path, dropping whatever it still
+	 * had queued.
+	 */
+	spin_lock_irqsave(&uport->lock, flags);
+	WRITE_ONCE(uport->oob_active, true);
+	uport->ops->stop_tx(uport);
+	uart_circ_clear(&state->xmit);
+	spin_unlock_irqrestore(&uport->lock, flags);
+
+	ret = uport->ops->oob_enable(uport);
+	if (ret)
+		WRITE_ONCE(uport->oob_active, false);
+
+	return ret;
+}
+
+/* Caller holds port->mutex. */
+static void uart_oob_disable(struct uart_port *uport)
+{
+	if (!uport->oob_active)
+		return;
+
+	uport->ops->oob_disable(uport);
+	WRITE_ONCE(uport->oob_active, false);
+	oob_poll_signal(&uport->oob_state->poll, EPOLLERR | EPOLLHUP);
+}
+
+static int uart_oob_ioctl(struct uart_state *state, struct uart_port *uport,
+			  int __user *uarg)
+{
+	int enable;
+
+	if (get_user(enable, uarg))
+		return -EFAULT;
+
+	if (enable)
+		return uart_oob_enable(state, uport);
+
+	uart_oob_disable(uport);
+
+	return 0;
+}
+
+#else
+
+static inline void uart_oob_free(struct uart_port *uport) { }
+
+static inline void uart_oob_disable(struct uart_port *uport) { }
+
+static inline int uart_oob_ioctl(struct uart_state *state,
+				 struct uart_port *uport, int __user *uarg)
+{
+	return -ENOIOCTLCMD;
+}
+
+#endif /* CONFIG_SERIAL_CORE_OOB */
+
 /*
  * Called via sys_ioctl.  We can use spin_lock_irq() here.
  */
@@ -1386,6 +1735,9 @@ uart_ioctl(struct tty_struct *tty, unsigned int cmd, unsigned long arg)
 	void __user *uarg = (void __user *)arg;
 	int ret = -ENOIOCTLCMD;
 
+	/* Only TIOCSEROOB may leave the oob mode. */
+	if (cmd != TIOCSEROOB && uart_oob_active(READ_ONCE(state->uart_port)))
+		return -EBUSY;
 
 	/*
 	 * These ioctls don't rely on the hardware to be present.
@@ -1431,7 +1783,16 @@ uart_ioctl(struct tty_struct *tty, unsigned int cmd, unsigned long arg)
 	 * protected against the tty being hung up.
 	 */
 
+	if (cmd != TIOCSEROOB && uart_oob_active(uport)) {
+		ret = -EBUSY;
+		goto out_up;
+	}
+
 	switch (cmd) {
+	case TIOCSEROOB:
+		ret = uart_oob_ioctl(state, uport, uarg);
+		break;
+
 	case TIOCSERGETLSR: /* Get line status register */
 		ret = uart_get_lsr_info(tty, state, uarg);
 		break;
@@ -1492,6 +1853,12 @@ static void uart_set_termios(struct tty_struct *tty,
 	if (!uport)
 		goto out;
 
+	/* The line settings are frozen while in oob mode. */
+	if (uart_oob_active(uport)) {
+		tty->termios = *old_termios;
+		goto out;
+	}
+
 	/*
 	 * Drivers doing software flow control also need to know
 	 * about changes to these input settings.
@@ -1574,6 +1941,8 @@ static void uart_tty_port_shutdown(struct tty_port *port)
 	if (WARN(!uport, "detached port still initialized!\n"))
 		return;
 
+	uart_oob_disable(uport);
+
 	spin_lock_irq(&uport->lock);
 	uport->ops->stop_rx(uport);
 	spin_unlock_irq(&uport->lock);
@@ -1705,8 +2074,10 @@ static void uart_port_shutdown(struct tty_port *port)
 	/*
 	 * Free the IRQ and disable the port.
 	 */
-	if (uport)
+	if (uport) {
+		uart_oob_disable(uport);
 		uport->ops->shutdown(uport);
+	}
 
 	/*
 	 * Ensure that the IRQ handler isn't running on another CPU.
@@ -2509,6 +2880,11 @@ static const struct tty_operations uart_ops = {
 	.poll_get_char	= uart_poll_get_char,
 	.poll_put_char	= uart_poll_put_char,
 #endif
+#ifdef CONFIG_SERIAL_CORE_OOB
+	.oob_read	= uart_oob_read,
+	.oob_write	= uart_oob_write,
+	.oob_poll	= uart_oob_poll,
+#endif
 };
 
 static const struct tty_port_operations uart_port_ops = {
@@ -3018,6 +3394,7 @@ int uart_remove_one_port(struct uart_driver *drv, struct uart_port *uport)
 	mutex_lock(&port->mutex);
 	WARN_ON(atomic_dec_return(&state->refcount) < 0);
 	wait_event(state->remove_wait, !atomic_read(&state->refcount));
+	uart_oob_free(uport);
 	state->uart_port = NULL;
 	mutex_unlock(&port->mutex);
 out:
@@ -609,6 +609,95 @@ static void sifive_serial_shutdown(struct uart_port *port)
 	__ssp_disable_txwm(ssp);
 }
 
+#ifdef CONFIG_SERIAL_CORE_OOB
+
+/*
+ * Out-of-band mode: the RX FIFO is drained into the serial core oob
+ * ring and the TX FIFO refilled from it directly from the oob stage,
+ * the tty flip buffer and port lock are not involved.
+ */
+static irqreturn_t sifive_serial_oob_irq(int irq, void *dev_id)
+{
+	struct sifive_serial_port *ssp = dev_id;
+	unsigned char buf[SIFIVE_RX_FIFO_DEPTH];
+	unsigned int n, i;
+	char is_empty;
+	u32 ip;
+
+	ip = __ssp_readl(ssp, SIFIVE_SERIAL_IP_OFFS);
+	if (!ip)
+		return IRQ_NONE;
+
+	if (ip & SIFIVE_SERIAL_IP_RXWM_MASK) {
+		for (n = 0; n < SIFIVE_RX_FIFO_DEPTH; n++) {
+			buf[n] = __ssp_receive_char(ssp, &is_empty);
+			if (is_empty)
+				break;
+		}
+		if (n)
+			uart_oob_rx_chars(&ssp->port, buf, n);
+	}
+
+	/* TXWM fires once the TX FIFO is empty, fill it up. */
+	if (ip & SIFIVE_SERIAL_IP_TXWM_MASK) {
+		n = uart_oob_tx_chars(&ssp->port, buf, SIFIVE_TX_FIFO_DEPTH);
+		for (i = 0; i < n; i++)
+			__ssp_transmit_char(ssp, buf[i]);
+	}
+
+	return IRQ_HANDLED;
+}
+
+static void sifive_serial_oob_start_tx(struct uart_port *port)
+{
+	struct sifive_serial_port *ssp = port_to_sifive_serial_port(port);
+
+	__ssp_enable_txwm(ssp);
+}
+
+static void sifive_serial_oob_stop_tx(struct uart_port *port)
+{
+	struct sifive_serial_port *ssp = port_to_sifive_serial_port(port);
+
+	__ssp_disable_txwm(ssp);
+}
+
+static int sifive_serial_oob_enable(struct uart_port *port)
+{
+	struct sifive_serial_port *ssp = port_to_sifive_serial_port(port);
+	int r;
+
+	free_irq(port->irq, ssp);
+
+	r = request_irq(port->irq, sifive_serial_oob_irq,
+			port->irqflags | IRQF_OOB, dev_name(ssp->dev), ssp);
+	if (r) {
+		dev_err(ssp->dev, "could not attach oob interrupt: %d\n", r);
+		WARN_ON(request_irq(port->irq, sifive_serial_irq,
+				    port->irqflags, dev_name(ssp->dev), ssp));
+	}
+
+	return r;
+}
+
+static void sifive_serial_oob_disable(struct uart_port *port)
+{
+	struct sifive_serial_port *ssp = port_to_sifive_serial_port(port);
+	unsigned long flags;
+
+	free_irq(port->irq, ssp);
+
+	/* Pending oob output is dropped. */
+	raw_spin_lock_irqsave(&port->oob_state->lock, flags);
+	__ssp_disable_txwm(ssp);
+	raw_spin_unlock_irqrestore(&port->oob_state->lock, flags);
+
+	WARN_ON(request_irq(port->irq, sifive_serial_irq, port->irqflags,
+			    dev_name(ssp->dev), ssp));
+}
+
+#endif /* CONFIG_SERIAL_CORE_OOB */
+
 /**
  * sifive_serial_clk_notifier() - clock post-rate-change notifier
  * @nb: pointer to the struct notifier_block, from the notifier code
@@ -923,6 +1012,12 @@ static const struct uart_ops sifive_serial_uops = {
 	.poll_get_char	= sifive_serial_poll_get_char,
 	.poll_put_char	= sifive_serial_poll_put_char,
 #endif
+#ifdef CONFIG_SERIAL_CORE_OOB
+	.oob_enable	= sifive_serial_oob_enable,
+	.oob_disable	= sifive_serial_oob_disable,
+	.oob_start_tx	= sifive_serial_oob_start_tx,
+	.oob_stop_tx	= sifive_serial_oob_stop_tx,
+#endif
 };
 
 static struct uart_driver sifive_serial_uart_driver = {
@@ -471,6 +471,42 @@ static void tty_show_fdinfo(struct seq_file *m, struct file *file)
 		tty->ops->show_fdinfo(tty, m);
 }
 
+/*
+ * Out-of-band I/O entry points, straight to the driver: no ldisc, no
+ * tty lock, nothing which could sleep or run in-band code.
+ */
+static ssize_t tty_oob_read(struct file *file, char __user *buf,
+			    size_t count)
+{
+	struct tty_struct *tty = file_tty(file);
+
+	if (!tty->ops->oob_read)
+		return -EOPNOTSUPP;
+
+	return tty->ops->oob_read(tty, buf, count);
+}
+
+static ssize_t tty_oob_write(struct file *file, const char __user *buf,
+			     size_t count)
+{
+	struct tty_struct *tty = file_tty(file);
+
+	if (!tty->ops->oob_write)
+		return -EOPNOTSUPP;
+
+	return tty->ops->oob_write(tty, buf, count);
+}
+
+static __poll_t tty_oob_poll(struct file *file, struct oob_poll_wait *wait)
+{
+	struct tty_struct *tty = file_tty(file);
+
+	if (!tty->ops->oob_poll)
+		return EPOLLERR;
+
+	return tty->ops->oob_poll(tty, wait);
+}
+
 static const struct file_operations tty_fops = {
 	.llseek		= no_llseek,
 	.read_iter	= tty_read,
@@ -484,6 +520,9 @@ static const struct file_operations tty_fops = {
 	.release	= tty_release,
 	.fasync		= tty_fasync,
 	.show_fdinfo	= tty_show_fdinfo,
+	.oob_read	= tty_oob_read,
+	.oob_write	= tty_oob_write,
+	.oob_poll	= tty_oob_poll,
 };
 
 static const struct file_operations console_fops = {
@@ -2912,6 +2951,7 @@ static long tty_compat_ioctl(struct file *file, unsigned int cmd,
 	case TIOCSERGETLSR:
 	case TIOCGRS485:
 	case TIOCSRS485:
+	case TIOCSEROOB:
 #ifdef TIOCGETP
 	case TIOCGETP:
 	case TIOCSETP:
@@ -23,6 +23,8 @@
 #include <linux/string.h>
 #include <linux/kobject.h>
 #include <linux/cdev.h>
+#include <linux/dovetail.h>
+#include <linux/uaccess.h>
 #include <linux/uio_driver.h>
 
 #define UIO_MAX_DEVICES		(1U << MINORBITS)
@@ -420,17 +422,186 @@ static void uio_free_minor(unsigned long minor)
 	mutex_unlock(&minor_lock);
 }
 
+struct uio_listener {
+	struct uio_device *dev;
+	s32 event_count;
+};
+
+static void uio_wake_inband(struct uio_device *idev)
+{
+	wake_up_interruptible(&idev->wait);
+	kill_fasync(&idev->async_queue, SIGIO, POLL_IN);
+}
+
+#ifdef CONFIG_UIO_OOB
+
+static void uio_wake_work(struct irq_work *work)
+{
+	struct uio_device *idev = container_of(work, struct uio_device,
+					       wake_work);
+
+	uio_wake_inband(idev);
+}
+
+static void uio_init_oob(struct uio_device *idev)
+{
+	raw_spin_lock_init(&idev->oob_lock);
+	init_irq_work(&idev->wake_work, uio_wake_work);
+	oob_poll_head_init(&idev->oob_poll);
+}
+
+static void uio_destroy_oob(struct uio_device *idev)
+{
+	oob_poll_head_destroy(&idev->oob_poll);
+}
+
+static void uio_attach_oob(struct uio_device *idev, struct uio_info *info)
+{
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&idev->oob_lock, flags);
+	idev->oob_info = info;
+	raw_spin_unlock_irqrestore(&idev->oob_lock, flags);
+}
+
+/* Out-of-band callers cannot synchronize with info_lock. */
+static void uio_detach_oob(struct uio_device *idev)
+{
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&idev->oob_lock, flags);
+	idev->oob_info = NULL;
+	raw_spin_unlock_irqrestore(&idev->oob_lock, flags);
+
+	oob_poll_signal(&idev->oob_poll, EPOLLHUP);
+}
+
+static void uio_sync_oob(struct uio_device *idev)
+{
+	irq_work_sync(&idev->wake_work);
+}
+
+static void uio_notify(struct uio_device *idev)
+{
+	oob_poll_signal(&idev->oob_poll, EPOLLIN | EPOLLRDNORM);
+
+	/* The in-band waitqueue cannot be woken up from the oob stage. */
+	if (running_inband())
+		uio_wake_inband(idev);
+	else
+		irq_work_queue(&idev->wake_work);
+}
+
+static __poll_t uio_oob_poll(struct file *filep, struct oob_poll_wait *wait)
+{
+	struct uio_listener *listener = filep->private_data;
+	struct uio_device *idev = listener->dev;
+
+	oob_poll_watch(&idev->oob_poll, wait);
+
+	if (!READ_ONCE(idev->oob_info))
+		return EPOLLERR;
+
+	if (listener->event_count != atomic_read(&idev->event))
+		return EPOLLIN | EPOLLRDNORM;
+
+	return 0;
+}
+
+/*
+ * Never blocks, oob callers should wait for EPOLLIN with oob_poll()
+ * when -EAGAIN is returned.
+ */
+static ssize_t uio_oob_read(struct file *filep, char __user *buf,
+			    size_t count)
+{
+	struct uio_listener *listener = filep->private_data;
+	struct uio_device *idev = listener->dev;
+	s32 event_count;
+
+	if (count != sizeof(s32))
+		return -EINVAL;
+
+	if (!READ_ONCE(idev->oob_info))
+		return -EIO;
+
+	event_count = atomic_read(&idev->event);
+	if (event_count == listener->event_count)
+		return -EAGAIN;
+
+	if (!access_ok(buf, count) ||
+	    raw_copy_to_user(buf, &event_count, count))
+		return -EFAULT;
+
+	listener->event_count = event_count;
+
+	return count;
+}
+
+static ssize_t uio_oob_write(struct file *filep, const char __user *buf,
+			     size_t count)
+{
+	struct uio_listener *listener = filep->private_data;
+	struct uio_device *idev = listener->dev;
+	struct uio_info *info;
+	unsigned long flags;
+	ssize_t retval;
+	s32 irq_on;
+
+	if (count != sizeof(s32))
+		return -EINVAL;
+
+	if (!access_ok(buf, count) ||
+	    raw_copy_from_user(&irq_on, buf, count))
+		return -EFAULT;
+
+	raw_spin_lock_irqsave(&idev->oob_lock, flags);
+
+	info = idev->oob_info;
+	if (!info)
+		retval = -EIO;
+	else if (!info->irqcontrol)
+		retval = -ENOSYS;
+	else
+		retval = info->irqcontrol(info, irq_on);
+
+	raw_spin_unlock_irqrestore(&idev->oob_lock, flags);
+
+	return retval ? retval : sizeof(s32);
+}
+
+#else
+
+static inline void uio_init_oob(struct uio_device *idev) { }
+
+static inline void uio_destroy_oob(struct uio_device *idev) { }
+
+static inline void uio_attach_oob(struct uio_device *idev,
+				  struct uio_info *info) { }
+
+static inline void uio_detach_oob(struct uio_device *idev) { }
+
+static inline void uio_sync_oob(struct uio_device *idev) { }
+
+static inline void uio_notify(struct uio_device *idev)
+{
+	uio_wake_inband(idev);
+}
+
+#endif /* CONFIG_UIO_OOB */
+
 /**
  * uio_event_notify - trigger an interrupt event
  * @info: UIO device capabilities
+ *
+ * May be called from the out-of-band stage with CONFIG_UIO_OOB.
  */
 void uio_event_notify(struct uio_info *info)
 {
 	struct uio_device *idev = info->uio_dev;
 
 	atomic_inc(&idev->event);
-	wake_up_interruptible(&idev->wait);
-	kill_fasync(&idev->async_queue, SIGIO, POLL_IN);
+	uio_notify(idev);
 }
 EXPORT_SYMBOL_GPL(uio_event_notify);
 
@@ -451,11 +622,6 @@ static irqreturn_t uio_interrupt(int irq, void *dev_id)
 	return ret;
 }
 
-struct uio_listener {
-	struct uio_device *dev;
-	s32 event_count;
-};
-
 static int uio_open(struct inode *inode, struct file *filep)
 {
 	struct uio_device *idev;
@@ -823,6 +989,11 @@ static const struct file_operations uio_fops = {
 	.poll		= uio_poll,
 	.fasync		= uio_fasync,
 	.llseek		= noop_llseek,
+#ifdef CONFIG_UIO_OOB
+	.oob_read	= uio_oob_read,
+	.oob_write	= uio_oob_write,
+	.oob_poll	= uio_oob_poll,
+#endif
 };
 
 static int uio_major_init(void)
@@ -902,6 +1073,7 @@ static void uio_device_release(struct device *dev)
 {
 	struct uio_device *idev = dev_get_drvdata(dev);
 
+	uio_destroy_oob(idev);
 	kfree(idev);
 }
 
@@ -938,6 +1110,7 @@ int __uio_register_device(struct module *owner,
 	mutex_init(&idev->info_lock);
 	init_waitqueue_head(&idev->wait);
 	atomic_set(&idev->event, 0);
+	uio_init_oob(idev);
 
 	ret = uio_get_minor(idev);
 	if (ret) {
@@ -975,12 +1148,22 @@ int __uio_register_device(struct module *owner,
 		 * FDs at the time of unregister and therefore may not be
 		 * freed until they are released.
 		 */
+		if (!IS_ENABLED(CONFIG_UIO_OOB) &&
+		    (info->irq_flags & IRQF_OOB)) {
+			ret = -EOPNOTSUPP;
+			info->uio_dev = NULL;
+			goto err_request_irq;
+		}
+
 		ret = request_irq(info->irq, uio_interrupt,
 				  info->irq_flags, info->name, idev);
 		if (ret) {
 			info->uio_dev = NULL;
 			goto err_request_irq;
 		}
+
+		if (info->irq_flags & IRQF_OOB)
+			uio_attach_oob(idev, info);
 	}
 
 	return 0;
@@ -1053,9 +1236,13 @@ void uio_unregister_device(struct uio_info *info)
 	mutex_lock(&idev->info_lock);
 	uio_dev_del_attributes(idev);
 
+	uio_detach_oob(idev);
+
 	if (info->irq && info->irq != UIO_IRQ_CUSTOM)
 		free_irq(info->irq, idev);
 
+	uio_sync_oob(idev);
+
 	idev->info = NULL;
 	mutex_unlock(&idev->info_lock);
 
@@ -31,7 +31,7 @@
 
 struct uio_dmem_genirq_platdata {
 	struct uio_info *uioinfo;
-	spinlock_t lock;
+	hard_spinlock_t lock;
 	unsigned long flags;
 	struct platform_device *pdev;
 	unsigned int dmem_region_start;
@@ -125,18 +125,25 @@ static int uio_dmem_genirq_irqcontrol(struct uio_info *dev_info, s32 irq_on)
 	 * in the interrupt controller, but keep track of the
 	 * state to prevent per-irq depth damage.
 	 *
-	 * Serialize this operation to support multiple tasks.
+	 * Serialize this operation to support multiple tasks. This lock
+	 * is hard as we may be called from the out-of-band stage.
 	 */
 
-	spin_lock_irqsave(&priv->lock, flags);
+	raw_spin_lock_irqsave(&priv->lock, flags);
 	if (irq_on) {
 		if (test_and_clear_bit(0, &priv->flags))
 			enable_irq(dev_info->irq);
-		spin_unlock_irqrestore(&priv->lock, flags);
+		raw_spin_unlock_irqrestore(&priv->lock, flags);
 	} else {
 		if (!test_and_set_bit(0, &priv->flags)) {
-			spin_unlock_irqrestore(&priv->lock, flags);
-			disable_irq(dev_info->irq);
+			raw_spin_unlock_irqrestore(&priv->lock, flags);
+			/* Out-of-band callers cannot wait for the handler. */
+			if (dev_info->irq_flags & IRQF_OOB)
+				disable_irq_nosync(dev_info->irq);
+			else
+				disable_irq(dev_info->irq);
+		} else {
+			raw_spin_unlock_irqrestore(&priv->lock, flags);
 		}
 	}
 
@@ -169,6 +176,10 @@ static int uio_dmem_genirq_probe(struct platform_device *pdev)
 		uioinfo->name = devm_kasprintf(&pdev->dev, GFP_KERNEL, "%pOFn",
 					       pdev->dev.of_node);
 		uioinfo->version = "devicetree";
+
+		if (IS_ENABLED(CONFIG_UIO_OOB) &&
+		    of_property_read_bool(pdev->dev.of_node, "linux,uio-oob"))
+			uioinfo->irq_flags |= IRQF_OOB;
 	}
 
 	if (!uioinfo || !uioinfo->name || !uioinfo->version) {
@@ -191,7 +202,7 @@ static int uio_dmem_genirq_probe(struct platform_device *pdev)
 	dma_set_coherent_mask(&pdev->dev, DMA_BIT_MASK(32));
 
 	priv->uioinfo = uioinfo;
-	spin_lock_init(&priv->lock);
+	raw_spin_lock_init(&priv->lock);
 	priv->flags = 0; /* interrupt is enabled to begin with */
 	priv->pdev = pdev;
 	mutex_init(&priv->alloc_lock);
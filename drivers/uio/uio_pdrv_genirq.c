@@ -30,7 +30,7 @@
 
 struct uio_pdrv_genirq_platdata {
 	struct uio_info *uioinfo;
-	spinlock_t lock;
+	hard_spinlock_t lock;
 	unsigned long flags;
 	struct platform_device *pdev;
 };
@@ -66,10 +66,10 @@ static irqreturn_t uio_pdrv_genirq_handler(int irq, struct uio_info *dev_info)
 	 * remember the state so we can allow user space to enable it later.
 	 */
 
-	spin_lock(&priv->lock);
+	raw_spin_lock(&priv->lock);
 	if (!__test_and_set_bit(UIO_IRQ_DISABLED, &priv->flags))
 		disable_irq_nosync(irq);
-	spin_unlock(&priv->lock);
+	raw_spin_unlock(&priv->lock);
 
 	return IRQ_HANDLED;
 }
@@ -84,10 +84,11 @@ static int uio_pdrv_genirq_irqcontrol(struct uio_info *dev_info, s32 irq_on)
 	 * state to prevent per-irq depth damage.
 	 *
 	 * Serialize this operation to support multiple tasks and concurrency
-	 * with irq handler on SMP systems.
+	 * with irq handler on SMP systems. This lock is hard as we may be
+	 * called from the out-of-band stage.
 	 */
 
-	spin_lock_irqsave(&priv->lock, flags);
+	raw_spin_lock_irqsave(&priv->lock, flags);
 	if (irq_on) {
 		if (__test_and_clear_bit(UIO_IRQ_DISABLED, &priv->flags))
 			enable_irq(dev_info->irq);
@@ -95,7 +96,7 @@ static int uio_pdrv_genirq_irqcontrol(struct uio_info *dev_info, s32 irq_on)
 		if (!__test_and_set_bit(UIO_IRQ_DISABLED, &priv->flags))
 			disable_irq_nosync(dev_info->irq);
 	}
-	spin_unlock_irqrestore(&priv->lock, flags);
+	raw_spin_unlock_irqrestore(&priv->lock, flags);
 
 	return 0;
 }
@@ -135,6 +136,10 @@ static int uio_pdrv_genirq_probe(struct platform_device *pdev)
 
 		uioinfo->version = "devicetree";
 		/* Multiple IRQs are not supported */
+
+		if (IS_ENABLED(CONFIG_UIO_OOB) &&
+		    of_property_read_bool(node, "linux,uio-oob"))
+			uioinfo->irq_flags |= IRQF_OOB;
 	}
 
 	if (!uioinfo || !uioinfo->name || !uioinfo->version) {
@@ -155,7 +160,7 @@ static int uio_pdrv_genirq_probe(struct platform_device *pdev)
 	}
 
 	priv->uioinfo = uioinfo;
-	spin_lock_init(&priv->lock);
+	raw_spin_lock_init(&priv->lock);
 	priv->flags = 0; /* interrupt is enabled to begin with */
 	priv->pdev = pdev;
 
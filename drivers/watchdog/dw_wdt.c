@@ -356,6 +356,8 @@ static const struct watchdog_ops dw_wdt_ops = {
 	.set_pretimeout	= dw_wdt_set_pretimeout,
 	.get_timeleft	= dw_wdt_get_timeleft,
 	.restart	= dw_wdt_restart,
+	/* Kicking the counter is a single register write. */
+	.oob_ping	= dw_wdt_ping,
 };
 
 static irqreturn_t dw_wdt_irq(int irq, void *devid)
@@ -371,7 +373,7 @@ static irqreturn_t dw_wdt_irq(int irq, void *devid)
 	if (!val)
 		return IRQ_NONE;
 
-	watchdog_notify_pretimeout(&dw_wdt->wdd);
+	watchdog_notify_pretimeout_oob(&dw_wdt->wdd);
 
 	return IRQ_HANDLED;
 }
@@ -616,13 +618,25 @@ static int dw_wdt_drv_probe(struct platform_device *pdev)
 	 * Pre-timeout IRQ is optional, since some hardware may lack support
 	 * of it. Note we must request rising-edge IRQ, since the lane is left
 	 * pending either until the next watchdog kick event or up to the
-	 * system reset.
+	 * system reset. With CONFIG_WATCHDOG_OOB, the pre-timeout is
+	 * received from the out-of-band stage, so that it is not delayed
+	 * by a starving in-band stage. An out-of-band handler cannot
+	 * share its line with in-band ones, so this takes the lane for
+	 * ourselves, falling back to a shared in-band IRQ if it is busy.
 	 */
 	ret = platform_get_irq_optional(pdev, 0);
 	if (ret > 0) {
-		ret = devm_request_irq(dev, ret, dw_wdt_irq,
-				       IRQF_SHARED | IRQF_TRIGGER_RISING,
-				       pdev->name, dw_wdt);
+		int irq = ret;
+
+		ret = -EBUSY;
+		if (IS_ENABLED(CONFIG_WATCHDOG_OOB))
+			ret = devm_request_irq(dev, irq, dw_wdt_irq,
+					       IRQF_OOB | IRQF_TRIGGER_RISING,
+					       pdev->name, dw_wdt);
+		if (ret)
+			ret = devm_request_irq(dev, irq, dw_wdt_irq,
+					       IRQF_SHARED | IRQF_TRIGGER_RISING,
+					       pdev->name, dw_wdt);
 		if (ret)
 			goto out_disable_pclk;
 
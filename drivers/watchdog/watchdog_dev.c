@@ -33,12 +33,16 @@
 #include <linux/fs.h>		/* For file operations */
 #include <linux/init.h>		/* For __init/__exit/... */
 #include <linux/hrtimer.h>	/* For hrtimers */
+#include <linux/irq_work.h>	/* For irq_work */
+#include <linux/irqstage.h>	/* For running_inband() */
 #include <linux/kernel.h>	/* For printk/panic/... */
 #include <linux/kthread.h>	/* For kthread_work */
 #include <linux/miscdevice.h>	/* For handling misc devices */
 #include <linux/module.h>	/* For module stuff/... */
 #include <linux/mutex.h>	/* For mutexes */
+#include <linux/reboot.h>	/* For orderly_reboot */
 #include <linux/slab.h>		/* For memory functions */
+#include <linux/spinlock.h>	/* For hard spinlocks */
 #include <linux/types.h>	/* For standard types (like size_t) */
 #include <linux/watchdog.h>	/* For watchdog specific items */
 #include <linux/uaccess.h>	/* For copy_to_user/put_user/... */
@@ -53,6 +57,12 @@
  * @wdd:	Pointer to watchdog device.
  * @lock:	Lock for watchdog core.
  * @status:	Watchdog core internal status bits.
+ * @oob_lock:	Serializes oob pings with oob mode changes.
+ * @inband_deadline:	Time the in-band stage must ping by in oob mode.
+ * @inband_starved:	Number of in-band deadlines missed in oob mode.
+ * @starved_work:	Relays in-band starvation to the in-band stage.
+ *
+ * Times related to oob mode are based on ktime_get_mono_fast_ns().
  */
 struct watchdog_core_data {
 	struct device dev;
@@ -68,6 +78,14 @@ struct watchdog_core_data {
 #define _WDOG_DEV_OPEN		0	/* Opened ? */
 #define _WDOG_ALLOW_RELEASE	1	/* Did we receive the magic char ? */
 #define _WDOG_KEEPALIVE		2	/* Did we receive a keepalive ? */
+#define _WDOG_OOB_MODE		3	/* Is the hardware fed by the oob stage ? */
+#define _WDOG_INBAND_STARVED	4	/* Did the in-band stage miss a ping ? */
+#ifdef CONFIG_WATCHDOG_OOB
+	hard_spinlock_t oob_lock;
+	u64 inband_deadline;
+	unsigned long inband_starved;
+	struct irq_work starved_work;
+#endif
 };
 
 /* the dev_t structure to store the dynamically allocated watchdog devices */
@@ -82,6 +100,36 @@ static bool handle_boot_enabled =
 
 static unsigned open_timeout = CONFIG_WATCHDOG_OPEN_TIMEOUT;
 
+#ifdef CONFIG_WATCHDOG_OOB
+static bool inband_starvation_reboot;
+
+static inline bool watchdog_oob_mode(struct watchdog_core_data *wd_data)
+{
+	return test_bit(_WDOG_OOB_MODE, &wd_data->status);
+}
+
+/*
+ * In oob mode, in-band pings only push the in-band deadline forward,
+ * the hardware is fed by the oob stage.
+ */
+static void watchdog_inband_keepalive(struct watchdog_device *wdd)
+{
+	struct watchdog_core_data *wd_data = wdd->wd_data;
+
+	WRITE_ONCE(wd_data->inband_deadline, ktime_get_mono_fast_ns() +
+		   (u64)wdd->timeout * NSEC_PER_SEC);
+	clear_bit(_WDOG_INBAND_STARVED, &wd_data->status);
+}
+#else
+static inline bool watchdog_oob_mode(struct watchdog_core_data *wd_data)
+{
+	return false;
+}
+
+static inline void watchdog_inband_keepalive(struct watchdog_device *wdd)
+{ }
+#endif
+
 static bool watchdog_past_open_deadline(struct watchdog_core_data *data)
 {
 	return ktime_after(ktime_get(), data->open_deadline);
@@ -99,6 +147,10 @@ static inline bool watchdog_need_worker(struct watchdog_device *wdd)
 	unsigned int hm = wdd->max_hw_heartbeat_ms;
 	unsigned int t = wdd->timeout * 1000;
 
+	/* The oob stage is in charge of the heartbeat in oob mode. */
+	if (watchdog_oob_mode(wdd->wd_data))
+		return false;
+
 	/*
 	 * A worker to generate heartbeat requests is needed if all of the
 	 * following conditions are true.
@@ -212,6 +264,12 @@ static int watchdog_ping(struct watchdog_device *wdd)
 	set_bit(_WDOG_KEEPALIVE, &wd_data->status);
 
 	wd_data->last_keepalive = ktime_get();
+
+	if (watchdog_oob_mode(wd_data)) {
+		watchdog_inband_keepalive(wdd);
+		return 0;
+	}
+
 	return __watchdog_ping(wdd);
 }
 
@@ -445,6 +503,190 @@ static int watchdog_get_timeleft(struct watchdog_device *wdd,
 	return 0;
 }
 
+#ifdef CONFIG_WATCHDOG_OOB
+
+static void watchdog_starved_work(struct irq_work *work)
+{
+	struct watchdog_core_data *wd_data;
+
+	wd_data = container_of(work, struct watchdog_core_data, starved_work);
+
+	pr_crit("watchdog%d: in-band stage starved, hardware still fed from oob stage\n",
+		MINOR(wd_data->dev.devt));
+
+	if (inband_starvation_reboot)
+		orderly_reboot();
+}
+
+static void watchdog_pretimeout_work(struct irq_work *work)
+{
+	struct watchdog_device *wdd;
+
+	wdd = container_of(work, struct watchdog_device, pretimeout_work);
+	watchdog_notify_pretimeout(wdd);
+}
+
+/*
+ *	watchdog_notify_pretimeout_oob: report a pretimeout event
+ *	@wdd: the watchdog device which raised the event
+ *
+ *	May be called from either stage. From the oob stage, the event
+ *	is handed over to the pretimeout governor as soon as the in-band
+ *	stage resumes. Like watchdog_notify_pretimeout() does, events
+ *	raised while the device is not registered are dropped.
+ */
+
+void watchdog_notify_pretimeout_oob(struct watchdog_device *wdd)
+{
+	if (running_inband())
+		watchdog_notify_pretimeout(wdd);
+	else if (READ_ONCE(wdd->wd_data))
+		irq_work_queue(&wdd->pretimeout_work);
+}
+EXPORT_SYMBOL_GPL(watchdog_notify_pretimeout_oob);
+
+static void watchdog_init_oob(struct watchdog_device *wdd,
+			      struct watchdog_core_data *wd_data)
+{
+	raw_spin_lock_init(&wd_data->oob_lock);
+	init_irq_work(&wd_data->starved_work, watchdog_starved_work);
+	/* Never torn down, the oob stage may still refer to it. */
+	init_irq_work(&wdd->pretimeout_work, watchdog_pretimeout_work);
+}
+
+/*
+ *	watchdog_oob_ping: ping the watchdog from the oob stage.
+ *	@wd_data: the watchdog core data of the device to ping
+ *
+ *	Feed the hardware, then check whether the in-band stage kept
+ *	up with its own deadline.
+ */
+
+static int watchdog_oob_ping(struct watchdog_core_data *wd_data)
+{
+	struct watchdog_device *wdd;
+	unsigned long flags;
+	int ret = -EPERM;
+	u64 now;
+
+	raw_spin_lock_irqsave(&wd_data->oob_lock, flags);
+
+	wdd = wd_data->wdd;
+	if (!wdd) {
+		ret = -ENODEV;
+		goto out;
+	}
+
+	if (!watchdog_oob_mode(wd_data))
+		goto out;
+
+	ret = wdd->ops->oob_ping(wdd);
+	now = ktime_get_mono_fast_ns();
+
+	if (now > READ_ONCE(wd_data->inband_deadline) &&
+	    !test_and_set_bit(_WDOG_INBAND_STARVED, &wd_data->status)) {
+		wd_data->inband_starved++;
+		irq_work_queue(&wd_data->starved_work);
+	}
+out:
+	raw_spin_unlock_irqrestore(&wd_data->oob_lock, flags);
+
+	return ret;
+}
+
+static void watchdog_leave_oob(struct watchdog_core_data *wd_data)
+{
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&wd_data->oob_lock, flags);
+	clear_bit(_WDOG_OOB_MODE, &wd_data->status);
+	raw_spin_unlock_irqrestore(&wd_data->oob_lock, flags);
+
+	irq_work_sync(&wd_data->starved_work);
+}
+
+/*
+ *	watchdog_set_oob_mode: hand the heartbeat over to either stage
+ *	@wdd: the watchdog device
+ *	@on: non-zero to have the hardware fed by the oob stage
+ *
+ *	The caller must hold wd_data->lock.
+ */
+
+static int watchdog_set_oob_mode(struct watchdog_device *wdd, int on)
+{
+	struct watchdog_core_data *wd_data = wdd->wd_data;
+	unsigned long flags;
+
+	if (!wdd->ops->oob_ping)
+		return -EOPNOTSUPP;
+
+	if (!on) {
+		if (!watchdog_oob_mode(wd_data))
+			return 0;
+		watchdog_leave_oob(wd_data);
+		/* The in-band stage is in charge again. */
+		return watchdog_ping(wdd);
+	}
+
+	if (!watchdog_active(wdd))
+		return -EINVAL;
+
+	raw_spin_lock_irqsave(&wd_data->oob_lock, flags);
+	watchdog_inband_keepalive(wdd);
+	set_bit(_WDOG_OOB_MODE, &wd_data->status);
+	raw_spin_unlock_irqrestore(&wd_data->oob_lock, flags);
+
+	watchdog_update_worker(wdd);
+
+	return 0;
+}
+
+static ssize_t watchdog_oob_write(struct file *file, const char __user *data,
+				  size_t len)
+{
+	struct watchdog_core_data *wd_data = file->private_data;
+	int err;
+
+	if (len == 0)
+		return 0;
+
+	err = watchdog_oob_ping(wd_data);
+	if (err < 0)
+		return err;
+
+	return len;
+}
+
+static long watchdog_oob_ioctl(struct file *file, unsigned int cmd,
+			       unsigned long arg)
+{
+	struct watchdog_core_data *wd_data = file->private_data;
+
+	switch (cmd) {
+	case WDIOC_KEEPALIVE:
+		return watchdog_oob_ping(wd_data);
+	default:
+		return -ENOTTY;
+	}
+}
+
+#else
+
+static inline void watchdog_init_oob(struct watchdog_device *wdd,
+				     struct watchdog_core_data *wd_data)
+{ }
+
+static inline void watchdog_leave_oob(struct watchdog_core_data *wd_data)
+{ }
+
+static inline int watchdog_set_oob_mode(struct watchdog_device *wdd, int on)
+{
+	return -EOPNOTSUPP;
+}
+
+#endif /* CONFIG_WATCHDOG_OOB */
+
 #ifdef CONFIG_WATCHDOG_SYSFS
 static ssize_t nowayout_show(struct device *dev, struct device_attribute *attr,
 				char *buf)
@@ -585,6 +827,17 @@ static ssize_t pretimeout_governor_store(struct device *dev,
 }
 static DEVICE_ATTR_RW(pretimeout_governor);
 
+#ifdef CONFIG_WATCHDOG_OOB
+static ssize_t inband_starved_show(struct device *dev,
+				   struct device_attribute *attr, char *buf)
+{
+	struct watchdog_device *wdd = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%lu\n", READ_ONCE(wdd->wd_data->inband_starved));
+}
+static DEVICE_ATTR_RO(inband_starved);
+#endif
+
 static umode_t wdt_is_visible(struct kobject *kobj, struct attribute *attr,
 				int n)
 {
@@ -602,6 +855,10 @@ static umode_t wdt_is_visible(struct kobject *kobj, struct attribute *attr,
 		 (!(wdd->info->options & WDIOF_PRETIMEOUT) ||
 		  !IS_ENABLED(CONFIG_WATCHDOG_PRETIMEOUT_GOV)))
 		mode = 0;
+#ifdef CONFIG_WATCHDOG_OOB
+	else if (attr == &dev_attr_inband_starved.attr && !wdd->ops->oob_ping)
+		mode = 0;
+#endif
 
 	return mode;
 }
@@ -616,6 +873,9 @@ static struct attribute *wdt_attrs[] = {
 	&dev_attr_nowayout.attr,
 	&dev_attr_pretimeout_governor.attr,
 	&dev_attr_pretimeout_available_governors.attr,
+#ifdef CONFIG_WATCHDOG_OOB
+	&dev_attr_inband_starved.attr,
+#endif
 	NULL,
 };
 
@@ -733,6 +993,14 @@ static long watchdog_ioctl(struct file *file, unsigned int cmd,
 
 	switch (cmd) {
 	case WDIOC_GETSUPPORT:
+		if (IS_ENABLED(CONFIG_WATCHDOG_OOB) && wdd->ops->oob_ping) {
+			struct watchdog_info info = *wdd->info;
+
+			info.options |= WDIOF_OOBPING;
+			err = copy_to_user(argp, &info, sizeof(info)) ?
+				-EFAULT : 0;
+			break;
+		}
 		err = copy_to_user(argp, wdd->info,
 			sizeof(struct watchdog_info)) ? -EFAULT : 0;
 		break;
@@ -802,6 +1070,13 @@ static long watchdog_ioctl(struct file *file, unsigned int cmd,
 	case WDIOC_GETPRETIMEOUT:
 		err = put_user(wdd->pretimeout, p);
 		break;
+	case WDIOC_SETOOBMODE:
+		if (get_user(val, p)) {
+			err = -EFAULT;
+			break;
+		}
+		err = watchdog_set_oob_mode(wdd, val);
+		break;
 	default:
 		err = -ENOTTY;
 		break;
@@ -912,6 +1187,9 @@ static int watchdog_release(struct inode *inode, struct file *file)
 	if (!wdd)
 		goto done;
 
+	/* Nobody is left to ping from the oob stage. */
+	watchdog_leave_oob(wd_data);
+
 	/*
 	 * We only stop the watchdog if we received the magic character
 	 * or if WDIOF_MAGICCLOSE is not set. If nowayout was set then
@@ -956,6 +1234,11 @@ static const struct file_operations watchdog_fops = {
 	.compat_ioctl	= compat_ptr_ioctl,
 	.open		= watchdog_open,
 	.release	= watchdog_release,
+#ifdef CONFIG_WATCHDOG_OOB
+	.oob_write	= watchdog_oob_write,
+	.oob_ioctl	= watchdog_oob_ioctl,
+	.compat_oob_ioctl = compat_ptr_oob_ioctl,
+#endif
 };
 
 static struct miscdevice watchdog_miscdev = {
@@ -988,6 +1271,7 @@ static int watchdog_cdev_register(struct watchdog_device *wdd)
 	if (!wd_data)
 		return -ENOMEM;
 	mutex_init(&wd_data->lock);
+	watchdog_init_oob(wdd, wd_data);
 
 	wd_data->wdd = wdd;
 	wdd->wd_data = wd_data;
@@ -1090,12 +1374,16 @@ static void watchdog_cdev_unregister(struct watchdog_device *wdd)
 	}
 
 	mutex_lock(&wd_data->lock);
+	watchdog_leave_oob(wd_data);
 	wd_data->wdd = NULL;
 	wdd->wd_data = NULL;
 	mutex_unlock(&wd_data->lock);
 
 	hrtimer_cancel(&wd_data->timer);
 	kthread_cancel_work_sync(&wd_data->work);
+#ifdef CONFIG_WATCHDOG_OOB
+	irq_work_sync(&wdd->pretimeout_work);
+#endif
 
 	put_device(&wd_data->dev);
 }
@@ -1224,6 +1512,12 @@ MODULE_PARM_DESC(handle_boot_enabled,
 	"Watchdog core auto-updates boot enabled watchdogs before userspace takes over (default="
 	__MODULE_STRING(IS_ENABLED(CONFIG_WATCHDOG_HANDLE_BOOT_ENABLED)) ")");
 
+#ifdef CONFIG_WATCHDOG_OOB
+module_param(inband_starvation_reboot, bool, 0644);
+MODULE_PARM_DESC(inband_starvation_reboot,
+	"Reboot in an orderly manner when the in-band stage misses its ping while the oob stage feeds the watchdog (default=0)");
+#endif
+
 module_param(open_timeout, uint, 0644);
 MODULE_PARM_DESC(open_timeout,
 	"Maximum time (in seconds, 0 means infinity) for userspace to take over a running watchdog (default="
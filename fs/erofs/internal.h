@@ -402,6 +402,13 @@ int erofs_namei(struct inode *dir, struct qstr *name,
 /* dir.c */
 extern const struct file_operations erofs_dir_fops;
 
+/* oob.c */
+#ifdef CONFIG_EROFS_FS_OOB
+extern const struct file_operations erofs_file_fops;
+#else
+#define erofs_file_fops		generic_ro_fops
+#endif
+
 static inline void *erofs_vm_map_ram(struct page **pages, unsigned int count)
 {
 	int retried = 0;
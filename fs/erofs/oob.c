@@ -0,0 +1,208 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Out-of-band read path for pinned regular files.
+ *
+ * A file opted in with EROFS_IOC_OOB_PIN has its whole contents read
+ * (and decompressed if needed) from in-band context, then the
+ * resulting page cache pages are held until the file is released.
+ * oob_read() and EROFS_IOC_OOB_PREAD only copy from those pages,
+ * so they never sleep, allocate memory, walk the page cache or
+ * trigger any decompression.
+ */
+#include "internal.h"
+#include <linux/uaccess.h>
+#include <linux/compat.h>
+#include <linux/dovetail.h>
+#include <uapi/linux/erofs.h>
+
+struct erofs_oob_pin {
+	struct page **pages;
+	unsigned int nr_pages;
+	loff_t size;
+};
+
+static void erofs_oob_free_pin(struct erofs_oob_pin *pin)
+{
+	while (pin->nr_pages)
+		put_page(pin->pages[--pin->nr_pages]);
+
+	kvfree(pin->pages);
+	kfree(pin);
+}
+
+static int erofs_oob_pin(struct file *filp)
+{
+	struct inode *inode = file_inode(filp);
+	struct address_space *mapping = inode->i_mapping;
+	struct erofs_oob_pin *pin;
+	unsigned long nr_pages, i;
+	struct page *page;
+	int err;
+
+	if (!S_ISREG(inode->i_mode))
+		return -EINVAL;
+
+	if (READ_ONCE(filp->private_data))
+		return -EBUSY;
+
+	/* never let a single file hog more than half of the memory */
+	nr_pages = DIV_ROUND_UP(inode->i_size, PAGE_SIZE);
+	if (nr_pages > totalram_pages() / 2)
+		return -EFBIG;
+
+	pin = kzalloc(sizeof(*pin), GFP_KERNEL);
+	if (!pin)
+		return -ENOMEM;
+
+	pin->size = inode->i_size;
+	if (nr_pages) {
+		pin->pages = kvmalloc_array(nr_pages, sizeof(*pin->pages),
+					    GFP_KERNEL);
+		if (!pin->pages) {
+			kfree(pin);
+			return -ENOMEM;
+		}
+		/* batch the I/O and the pcluster decompression upfront */
+		page_cache_sync_readahead(mapping, &filp->f_ra, filp,
+					  0, nr_pages);
+	}
+
+	for (i = 0; i < nr_pages; i++) {
+		page = read_mapping_page(mapping, i, NULL);
+		if (IS_ERR(page)) {
+			err = PTR_ERR(page);
+			goto out_free;
+		}
+		pin->pages[pin->nr_pages++] = page;
+		cond_resched();
+	}
+
+	if (cmpxchg(&filp->private_data, NULL, pin)) {
+		err = -EBUSY;
+		goto out_free;
+	}
+
+	erofs_dbg("%s, nid %llu pinned %lu pages for oob access", __func__,
+		  EROFS_I(inode)->nid, nr_pages);
+	return 0;
+
+out_free:
+	erofs_oob_free_pin(pin);
+	return err;
+}
+
+/* oob stage: copy from the pinned pages, no page cache lookup. */
+static ssize_t erofs_oob_copy(struct erofs_oob_pin *pin,
+			      char __user *u_buf, size_t count, loff_t pos)
+{
+	size_t done = 0, ofs, len;
+	struct page *page;
+
+	if (pos < 0)
+		return -EINVAL;
+
+	if (pos >= pin->size)
+		return 0;
+
+	count = min_t(loff_t, count, pin->size - pos);
+	if (!access_ok(u_buf, count))
+		return -EFAULT;
+
+	while (done < count) {
+		page = pin->pages[pos >> PAGE_SHIFT];
+		ofs = offset_in_page(pos);
+		len = min_t(size_t, PAGE_SIZE - ofs, count - done);
+		if (raw_copy_to_user(u_buf + done, page_address(page) + ofs,
+				     len))
+			return done ?: -EFAULT;
+		done += len;
+		pos += len;
+	}
+
+	return done;
+}
+
+static ssize_t erofs_oob_read(struct file *filp, char __user *u_buf,
+			      size_t count)
+{
+	struct erofs_oob_pin *pin = READ_ONCE(filp->private_data);
+	ssize_t ret;
+
+	if (!pin)
+		return -EPERM;
+
+	ret = erofs_oob_copy(pin, u_buf, count, filp->f_pos);
+	if (ret > 0)
+		filp->f_pos += ret;
+
+	return ret;
+}
+
+static long erofs_oob_ioctl(struct file *filp, unsigned int cmd,
+			    unsigned long arg)
+{
+	struct erofs_oob_pin *pin = READ_ONCE(filp->private_data);
+	struct erofs_oob_pread __user *u_req = (void __user *)arg;
+	struct erofs_oob_pread req;
+	ssize_t ret;
+
+	if (cmd != EROFS_IOC_OOB_PREAD)
+		return -ENOTTY;
+
+	if (!pin)
+		return -EPERM;
+
+	if (!access_ok(u_req, sizeof(req)) ||
+	    raw_copy_from_user(&req, u_req, sizeof(req)))
+		return -EFAULT;
+
+	if (req.offset > LLONG_MAX)
+		return -EINVAL;
+
+	ret = erofs_oob_copy(pin, u64_to_user_ptr(req.buf),
+			     min_t(u64, req.len, MAX_RW_COUNT), req.offset);
+	if (ret < 0)
+		return ret;
+
+	req.len = ret;
+	if (raw_copy_to_user(&u_req->len, &req.len, sizeof(req.len)))
+		return -EFAULT;
+
+	return 0;
+}
+
+static long erofs_ioctl(struct file *filp, unsigned int cmd,
+			unsigned long arg)
+{
+	switch (cmd) {
+	case EROFS_IOC_OOB_PIN:
+		return erofs_oob_pin(filp);
+	}
+
+	return -ENOTTY;
+}
+
+static int erofs_file_release(struct inode *inode, struct file *filp)
+{
+	struct erofs_oob_pin *pin = filp->private_data;
+
+	if (pin)
+		erofs_oob_free_pin(pin);
+
+	return 0;
+}
+
+const struct file_operations erofs_file_fops = {
+	.llseek		= generic_file_llseek,
+	.read_iter	= generic_file_read_iter,
+	.mmap		= generic_file_readonly_mmap,
+	.splice_read	= generic_file_splice_read,
+	.unlocked_ioctl	= erofs_ioctl,
+	.release	= erofs_file_release,
+	.oob_read	= erofs_oob_read,
+	.oob_ioctl	= erofs_oob_ioctl,
+#ifdef CONFIG_COMPAT
+	.compat_ioctl	= compat_ptr_ioctl,
+	.compat_oob_ioctl = compat_ptr_oob_ioctl,
+#endif
+};
@@ -125,9 +125,45 @@ typedef tagptr1_t compressed_page_t;
 
 static struct workqueue_struct *z_erofs_workqueue __read_mostly;
 
+#ifdef CONFIG_EROFS_FS_ZIP_PARALLEL
+struct z_erofs_split_ctl {
+	atomic_t pending;
+	struct completion done;
+};
+
+struct z_erofs_split_work {
+	struct work_struct work;
+	struct super_block *sb;
+	struct z_erofs_pcluster *pcl;
+	/* NULL if nobody waits for completion (background queue) */
+	struct z_erofs_split_ctl *ctl;
+};
+
+static struct kmem_cache *z_erofs_split_cachep __read_mostly;
+static unsigned int z_erofs_split_max __read_mostly;
+static atomic_t z_erofs_split_inflight = ATOMIC_INIT(0);
+
+static int z_erofs_init_split(void)
+{
+	/* keep at most two pclusters in flight per CPU */
+	z_erofs_split_max = 2 * num_possible_cpus();
+	z_erofs_split_cachep = KMEM_CACHE(z_erofs_split_work, 0);
+	return z_erofs_split_cachep ? 0 : -ENOMEM;
+}
+
+static void z_erofs_exit_split(void)
+{
+	kmem_cache_destroy(z_erofs_split_cachep);
+}
+#else
+static inline int z_erofs_init_split(void) { return 0; }
+static inline void z_erofs_exit_split(void) {}
+#endif
+
 void z_erofs_exit_zip_subsystem(void)
 {
 	destroy_workqueue(z_erofs_workqueue);
+	z_erofs_exit_split();
 	z_erofs_destroy_pcluster_pool();
 }
 
@@ -151,9 +187,18 @@ int __init z_erofs_init_zip_subsystem(void)
 
 	if (err)
 		return err;
+	err = z_erofs_init_split();
+	if (err)
+		goto out_pool;
 	err = z_erofs_init_workqueue();
 	if (err)
-		z_erofs_destroy_pcluster_pool();
+		goto out_split;
+	return 0;
+
+out_split:
+	z_erofs_exit_split();
+out_pool:
+	z_erofs_destroy_pcluster_pool();
 	return err;
 }
 
@@ -1040,8 +1085,105 @@ static int z_erofs_decompress_pcluster(struct super_block *sb,
 	return err;
 }
 
+#ifdef CONFIG_EROFS_FS_ZIP_PARALLEL
+/*
+ * Decompressing all pclusters of a batch one after another pegs a
+ * single CPU when cold-starting large files. Instead, every pcluster
+ * but the last one of a queue is handed over to the unbound workqueue,
+ * the last one is kept for the current context. The number of split
+ * pclusters in flight is bounded, the remaining ones are decompressed
+ * inline once the limit is reached.
+ *
+ * Only synchronous callers wait for the split work to complete, a
+ * background queue never does so from the workqueue context, since
+ * this could starve the very workers which should complete it.
+ */
+static void z_erofs_split_ctl_put(struct z_erofs_split_ctl *ctl)
+{
+	if (atomic_dec_and_test(&ctl->pending))
+		complete(&ctl->done);
+}
+
+static void z_erofs_split_work_fn(struct work_struct *work)
+{
+	struct z_erofs_split_work *sw =
+		container_of(work, struct z_erofs_split_work, work);
+	LIST_HEAD(pagepool);
+
+	z_erofs_decompress_pcluster(sw->sb, sw->pcl, &pagepool);
+	put_pages_list(&pagepool);
+
+	atomic_dec(&z_erofs_split_inflight);
+	if (sw->ctl)
+		z_erofs_split_ctl_put(sw->ctl);
+	kmem_cache_free(z_erofs_split_cachep, sw);
+}
+
+static bool z_erofs_split_pcluster(struct super_block *sb,
+				   struct z_erofs_pcluster *pcl,
+				   struct z_erofs_split_ctl *ctl)
+{
+	struct z_erofs_split_work *sw;
+
+	if (atomic_inc_return(&z_erofs_split_inflight) > z_erofs_split_max)
+		goto out;
+
+	/* splitting is optional, decompress inline rather than wait for memory */
+	sw = kmem_cache_alloc(z_erofs_split_cachep,
+			      GFP_NOWAIT | __GFP_NOWARN);
+	if (!sw)
+		goto out;
+
+	INIT_WORK(&sw->work, z_erofs_split_work_fn);
+	sw->sb = sb;
+	sw->pcl = pcl;
+	sw->ctl = ctl;
+	if (ctl)
+		atomic_inc(&ctl->pending);
+	queue_work(z_erofs_workqueue, &sw->work);
+	return true;
+out:
+	atomic_dec(&z_erofs_split_inflight);
+	return false;
+}
+
 static void z_erofs_decompress_queue(const struct z_erofs_decompressqueue *io,
-				     struct list_head *pagepool)
+				     struct list_head *pagepool, bool sync)
+{
+	z_erofs_next_pcluster_t owned = io->head;
+	struct z_erofs_split_ctl ctl;
+	bool split = num_online_cpus() > 1;
+
+	atomic_set(&ctl.pending, 1);
+	init_completion(&ctl.done);
+
+	while (owned != Z_EROFS_PCLUSTER_TAIL_CLOSED) {
+		struct z_erofs_pcluster *pcl;
+
+		/* no possible that 'owned' equals Z_EROFS_WORK_TPTR_TAIL */
+		DBG_BUGON(owned == Z_EROFS_PCLUSTER_TAIL);
+
+		/* no possible that 'owned' equals NULL */
+		DBG_BUGON(owned == Z_EROFS_PCLUSTER_NIL);
+
+		pcl = container_of(owned, struct z_erofs_pcluster, next);
+		owned = READ_ONCE(pcl->next);
+
+		/* keep the last pcluster for the current context */
+		if (split && owned != Z_EROFS_PCLUSTER_TAIL_CLOSED &&
+		    z_erofs_split_pcluster(io->sb, pcl, sync ? &ctl : NULL))
+			continue;
+
+		z_erofs_decompress_pcluster(io->sb, pcl, pagepool);
+	}
+
+	z_erofs_split_ctl_put(&ctl);
+	if (sync)
+		wait_for_completion(&ctl.done);
+}
+#else
+static void z_erofs_decompress_queue(const struct z_erofs_decompressqueue *io,
+				     struct list_head *pagepool, bool sync)
 {
 	z_erofs_next_pcluster_t owned = io->head;
 
@@ -1060,6 +1202,7 @@ static void z_erofs_decompress_queue(const struct z_erofs_decompressqueue *io,
 		z_erofs_decompress_pcluster(io->sb, pcl, pagepool);
 	}
 }
+#endif	/* !CONFIG_EROFS_FS_ZIP_PARALLEL */
 
 static void z_erofs_decompressqueue_work(struct work_struct *work)
 {
@@ -1068,7 +1211,7 @@ static void z_erofs_decompressqueue_work(struct work_struct *work)
 	LIST_HEAD(pagepool);
 
 	DBG_BUGON(bgq->head == Z_EROFS_PCLUSTER_TAIL_CLOSED);
-	z_erofs_decompress_queue(bgq, &pagepool);
+	z_erofs_decompress_queue(bgq, &pagepool, false);
 
 	put_pages_list(&pagepool);
 	kvfree(bgq);
@@ -1369,7 +1512,7 @@ static void z_erofs_runqueue(struct super_block *sb,
 	z_erofs_submit_queue(sb, f, pagepool, io, &force_fg);
 
 	/* handle bypass queue (no i/o pclusters) immediately */
-	z_erofs_decompress_queue(&io[JQ_BYPASS], pagepool);
+	z_erofs_decompress_queue(&io[JQ_BYPASS], pagepool, true);
 
 	if (!force_fg)
 		return;
@@ -1379,7 +1522,7 @@ static void z_erofs_runqueue(struct super_block *sb,
 		      !atomic_read(&io[JQ_SUBMIT].pending_bios));
 
 	/* handle synchronous decompress queue in the caller context */
-	z_erofs_decompress_queue(&io[JQ_SUBMIT], pagepool);
+	z_erofs_decompress_queue(&io[JQ_SUBMIT], pagepool, true);
 }
 
 static int z_erofs_readpage(struct file *file, struct page *page)
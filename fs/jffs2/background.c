@@ -19,11 +19,16 @@
 #include <linux/sched/signal.h>
 #include <linux/freezer.h>
 #include <linux/kthread.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include "nodelist.h"
 
 
 static int jffs2_garbage_collect_thread(void *);
 
+/* Longest a writer may wait for the GC cap to be lifted. */
+#define JFFS2_GC_THROTTLE_SLICE	msecs_to_jiffies(10)
+
 void jffs2_garbage_collect_trigger(struct jffs2_sb_info *c)
 {
 	assert_spin_locked(&c->erase_completion_lock);
@@ -31,6 +36,115 @@ void jffs2_garbage_collect_trigger(struct jffs2_sb_info *c)
 		send_sig(SIGHUP, c->gc_task, 1);
 }
 
+/*
+ * Free space is short enough for writers to depend on GC, in which case
+ * the background GC thread must not be throttled.
+ */
+bool jffs2_gc_under_pressure(struct jffs2_sb_info *c)
+{
+	return READ_ONCE(c->nr_free_blocks) + READ_ONCE(c->nr_erasing_blocks) <
+		c->resv_blocks_gctrigger;
+}
+
+/*
+ * A foreground write may run at most gc_fg_passes GC passes inline,
+ * then it has to leave the remaining work to the GC thread, if any.
+ */
+bool jffs2_gc_fg_budget_exhausted(struct jffs2_sb_info *c, unsigned int passes)
+{
+	unsigned int budget = READ_ONCE(c->mount_opts.gc_fg_passes);
+
+	return budget && passes >= budget && READ_ONCE(c->gc_task);
+}
+
+/*
+ * Kick the GC thread and wait for it to make some room, without doing
+ * any GC work in the caller's context. The caller rechecks the free
+ * space on return, so a bounded wait is fine.
+ */
+void jffs2_gc_wait_background(struct jffs2_sb_info *c, uint32_t blocksneeded)
+{
+	spin_lock(&c->erase_completion_lock);
+	jffs2_garbage_collect_trigger(c);
+	spin_unlock(&c->erase_completion_lock);
+
+	wait_event_interruptible_timeout(c->erase_wait,
+		READ_ONCE(c->nr_free_blocks) +
+		READ_ONCE(c->nr_erasing_blocks) >= blocksneeded,
+		msecs_to_jiffies(50));
+}
+
+/*
+ * Enforce the throughput cap of the background GC, unless writers are
+ * waiting for it. SIGHUP is blocked at this point, so writers cannot
+ * cut the nap short: sleep in slices and check for pressure after
+ * each of them instead.
+ */
+static void jffs2_gc_throttle(struct jffs2_sb_info *c, unsigned long bytes)
+{
+	unsigned int rate = READ_ONCE(c->mount_opts.gc_rate);
+	unsigned long timeout, slice, start = jiffies;
+
+	if (!rate || !bytes)
+		return;
+
+	timeout = DIV_ROUND_UP_ULL((u64)bytes * HZ, rate);
+	while (timeout && !jffs2_gc_under_pressure(c) &&
+	       !signal_pending(current)) {
+		slice = min(timeout, JFFS2_GC_THROTTLE_SLICE);
+		schedule_timeout_interruptible(slice);
+		timeout -= slice;
+	}
+
+	c->gc_stats.bg_throttled_ms += jiffies_to_msecs(jiffies - start);
+}
+
+#ifdef CONFIG_DEBUG_FS
+static int jffs2_gc_stats_show(struct seq_file *m, void *v)
+{
+	struct jffs2_sb_info *c = m->private;
+	struct jffs2_gc_stats *st = &c->gc_stats;
+	unsigned long fg_stalls, fg_passes, fg_waits;
+	u64 total_ns, max_ns, avg_ns;
+
+	spin_lock(&c->erase_completion_lock);
+	fg_stalls = st->fg_stalls;
+	fg_passes = st->fg_passes;
+	fg_waits = st->fg_waits;
+	total_ns = st->fg_stall_ns_total;
+	max_ns = st->fg_stall_ns_max;
+	spin_unlock(&c->erase_completion_lock);
+
+	seq_printf(m, "bg_passes: %lu\n", st->bg_passes);
+	seq_printf(m, "bg_bytes: %lu\n", st->bg_bytes);
+	seq_printf(m, "bg_throttled_ms: %lu\n", st->bg_throttled_ms);
+	seq_printf(m, "fg_stalls: %lu\n", fg_stalls);
+	seq_printf(m, "fg_passes: %lu\n", fg_passes);
+	seq_printf(m, "fg_waits: %lu\n", fg_waits);
+	avg_ns = fg_stalls ? div64_ul(total_ns, fg_stalls) : 0;
+	seq_printf(m, "fg_stall_us_avg: %llu\n", div_u64(avg_ns, NSEC_PER_USEC));
+	seq_printf(m, "fg_stall_us_max: %llu\n", div_u64(max_ns, NSEC_PER_USEC));
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(jffs2_gc_stats);
+
+void jffs2_gc_debugfs_init(struct jffs2_sb_info *c)
+{
+	char name[32];
+
+	snprintf(name, sizeof(name), "jffs2_gc_mtd%d", c->mtd->index);
+	c->gc_stats_dentry = debugfs_create_file(name, 0444, NULL, c,
+						 &jffs2_gc_stats_fops);
+}
+
+void jffs2_gc_debugfs_exit(struct jffs2_sb_info *c)
+{
+	debugfs_remove(c->gc_stats_dentry);
+	c->gc_stats_dentry = NULL;
+}
+#endif	/* CONFIG_DEBUG_FS */
+
 /* This must only ever be called when no GC thread is currently running */
 int jffs2_start_garbage_collect_thread(struct jffs2_sb_info *c)
 {
@@ -75,6 +189,7 @@ void jffs2_stop_garbage_collect_thread(struct jffs2_sb_info *c)
 static int jffs2_garbage_collect_thread(void *_c)
 {
 	struct jffs2_sb_info *c = _c;
+	unsigned long gc_bytes;
 	sigset_t hupmask;
 
 	siginitset(&hupmask, sigmask(SIGHUP));
@@ -109,8 +224,11 @@ static int jffs2_garbage_collect_thread(void *_c)
 		 * disk).
 		 * This forces the GCD to slow the hell down.   Pulling an
 		 * inode in with read_inode() is much preferable to having
-		 * the GC thread get there first. */
-		schedule_timeout_interruptible(msecs_to_jiffies(50));
+		 * the GC thread get there first.
+		 * Don't nap though if writers are bounded in the amount of
+		 * GC work they may do, and are waiting for us. */
+		if (!c->mount_opts.gc_fg_passes || !jffs2_gc_under_pressure(c))
+			schedule_timeout_interruptible(msecs_to_jiffies(50));
 
 		if (kthread_should_stop()) {
 			jffs2_dbg(1, "%s(): kthread_stop() called\n", __func__);
@@ -152,10 +270,15 @@ static int jffs2_garbage_collect_thread(void *_c)
 		sigprocmask(SIG_BLOCK, &hupmask, NULL);
 
 		jffs2_dbg(1, "%s(): pass\n", __func__);
+		gc_bytes = READ_ONCE(c->gc_stats.gc_bytes);
 		if (jffs2_garbage_collect_pass(c) == -ENOSPC) {
 			pr_notice("No space for garbage collection. Aborting GC thread\n");
 			goto die;
 		}
+		gc_bytes = READ_ONCE(c->gc_stats.gc_bytes) - gc_bytes;
+		c->gc_stats.bg_passes++;
+		c->gc_stats.bg_bytes += gc_bytes;
+		jffs2_gc_throttle(c, gc_bytes);
 	}
  die:
 	spin_lock(&c->erase_completion_lock);
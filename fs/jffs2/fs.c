@@ -407,6 +407,8 @@ int jffs2_do_remount_fs(struct super_block *sb, struct fs_context *fc)
 	if (!sb_rdonly(sb)) {
 		jffs2_stop_garbage_collect_thread(c);
 		mutex_lock(&c->alloc_sem);
+		if (c->mount_opts.seal_summary && (fc->sb_flags & SB_RDONLY))
+			jffs2_seal_nextblock(c);
 		jffs2_flush_wbuf_pad(c);
 		mutex_unlock(&c->alloc_sem);
 	}
@@ -40,6 +40,38 @@ struct jffs2_mount_opts {
 	 * available space is less then 'rp_size'. */
 	bool set_rp_size;
 	unsigned int rp_size;
+
+	/* Seal the current write block with its summary node on clean
+	 * unmount or remount read-only, so that the next mount reads its
+	 * summary rather than fully scanning it. */
+	bool set_seal_summary;
+	bool seal_summary;
+
+	/* GC scheduling: throughput cap of the background GC thread in
+	 * bytes per second (0 means unlimited), number of free blocks
+	 * below which the GC thread starts collecting proactively, and
+	 * maximum number of GC passes a foreground write may run inline
+	 * before waiting for the GC thread instead (0 means unbounded). */
+	bool set_gc_rate;
+	unsigned int gc_rate;
+	bool set_gc_watermark;
+	unsigned int gc_watermark;
+	bool set_gc_fg_passes;
+	unsigned int gc_fg_passes;
+};
+
+/* GC activity and foreground write stall accounting. */
+struct jffs2_gc_stats {
+	unsigned long gc_bytes;		/* written by GC, under alloc_sem */
+	unsigned long bg_passes;
+	unsigned long bg_bytes;
+	unsigned long bg_throttled_ms;
+	/* The following are updated under erase_completion_lock. */
+	unsigned long fg_stalls;	/* writes which had to wait for GC */
+	unsigned long fg_passes;	/* GC passes run inline by writers */
+	unsigned long fg_waits;		/* waits for the GC thread */
+	u64 fg_stall_ns_total;
+	u64 fg_stall_ns_max;
 };
 
 /* A struct for the overall file system control.  Pointers to
@@ -142,6 +174,10 @@ struct jffs2_sb_info {
 
 	struct jffs2_summary *summary;		/* Summary information */
 	struct jffs2_mount_opts mount_opts;
+	struct jffs2_gc_stats gc_stats;
+#ifdef CONFIG_DEBUG_FS
+	struct dentry *gc_stats_dentry;
+#endif
 
 #ifdef CONFIG_JFFS2_FS_XATTR
 #define XATTRINDEX_HASHSIZE	(57)
@@ -15,6 +15,7 @@
 #include <linux/mtd/mtd.h>
 #include <linux/compiler.h>
 #include <linux/sched/signal.h>
+#include <linux/ktime.h>
 #include "nodelist.h"
 #include "debug.h"
 
@@ -71,11 +72,32 @@ static int jffs2_rp_can_write(struct jffs2_sb_info *c)
 static int jffs2_do_reserve_space(struct jffs2_sb_info *c,  uint32_t minsize,
 				  uint32_t *len, uint32_t sumsize);
 
+/* Must be called with erase_completion_lock held. */
+static void jffs2_gc_account_stall(struct jffs2_sb_info *c, ktime_t stall_start,
+				   unsigned int gc_passes, unsigned int gc_waits)
+{
+	struct jffs2_gc_stats *st = &c->gc_stats;
+	u64 stall_ns;
+
+	if (!stall_start)
+		return;
+
+	stall_ns = ktime_to_ns(ktime_sub(ktime_get(), stall_start));
+	st->fg_stalls++;
+	st->fg_passes += gc_passes;
+	st->fg_waits += gc_waits;
+	st->fg_stall_ns_total += stall_ns;
+	if (stall_ns > st->fg_stall_ns_max)
+		st->fg_stall_ns_max = stall_ns;
+}
+
 int jffs2_reserve_space(struct jffs2_sb_info *c, uint32_t minsize,
 			uint32_t *len, int prio, uint32_t sumsize)
 {
 	int ret = -EAGAIN;
 	int blocksneeded = c->resv_blocks_write;
+	unsigned int gc_passes = 0, gc_waits = 0;
+	ktime_t stall_start = 0;
 	/* align it */
 	minsize = PAD(minsize);
 
@@ -123,6 +145,8 @@ int jffs2_reserve_space(struct jffs2_sb_info *c, uint32_t minsize,
 					  dirty, c->unchecked_size,
 					  c->sector_size);
 
+				jffs2_gc_account_stall(c, stall_start,
+						       gc_passes, gc_waits);
 				spin_unlock(&c->erase_completion_lock);
 				mutex_unlock(&c->alloc_sem);
 				return -ENOSPC;
@@ -147,6 +171,8 @@ int jffs2_reserve_space(struct jffs2_sb_info *c, uint32_t minsize,
 
 				jffs2_dbg(1, "max. available size 0x%08x  < blocksneeded * sector_size 0x%08x, returning -ENOSPC\n",
 					  avail, blocksneeded * c->sector_size);
+				jffs2_gc_account_stall(c, stall_start,
+						       gc_passes, gc_waits);
 				spin_unlock(&c->erase_completion_lock);
 				mutex_unlock(&c->alloc_sem);
 				return -ENOSPC;
@@ -164,7 +190,18 @@ int jffs2_reserve_space(struct jffs2_sb_info *c, uint32_t minsize,
 				  c->flash_size);
 			spin_unlock(&c->erase_completion_lock);
 
-			ret = jffs2_garbage_collect_pass(c);
+			if (!stall_start)
+				stall_start = ktime_get();
+
+			/* Bound the GC work done on behalf of this write. */
+			if (jffs2_gc_fg_budget_exhausted(c, gc_passes)) {
+				jffs2_gc_wait_background(c, blocksneeded);
+				gc_waits++;
+				ret = 0;
+			} else {
+				ret = jffs2_garbage_collect_pass(c);
+				gc_passes++;
+			}
 
 			if (ret == -EAGAIN) {
 				spin_lock(&c->erase_completion_lock);
@@ -183,12 +220,14 @@ int jffs2_reserve_space(struct jffs2_sb_info *c, uint32_t minsize,
 				} else
 					spin_unlock(&c->erase_completion_lock);
 			} else if (ret)
-				return ret;
+				goto out_stalled;
 
 			cond_resched();
 
-			if (signal_pending(current))
-				return -EINTR;
+			if (signal_pending(current)) {
+				ret = -EINTR;
+				goto out_stalled;
+			}
 
 			mutex_lock(&c->alloc_sem);
 			spin_lock(&c->erase_completion_lock);
@@ -200,6 +239,8 @@ int jffs2_reserve_space(struct jffs2_sb_info *c, uint32_t minsize,
 		}
 	}
 
+	jffs2_gc_account_stall(c, stall_start, gc_passes, gc_waits);
+
 out:
 	spin_unlock(&c->erase_completion_lock);
 	if (!ret)
@@ -207,6 +248,13 @@ int jffs2_reserve_space(struct jffs2_sb_info *c, uint32_t minsize,
 	if (ret)
 		mutex_unlock(&c->alloc_sem);
 	return ret;
+
+out_stalled:
+	/* Neither the alloc_sem nor the erase_completion_lock are held. */
+	spin_lock(&c->erase_completion_lock);
+	jffs2_gc_account_stall(c, stall_start, gc_passes, gc_waits);
+	spin_unlock(&c->erase_completion_lock);
+	return ret;
 }
 
 int jffs2_reserve_space_gc(struct jffs2_sb_info *c, uint32_t minsize,
@@ -231,8 +279,10 @@ int jffs2_reserve_space_gc(struct jffs2_sb_info *c, uint32_t minsize,
 		else
 			break;
 	}
-	if (!ret)
+	if (!ret) {
+		c->gc_stats.gc_bytes += minsize;
 		ret = jffs2_prealloc_raw_node_refs(c, c->nextblock, 1);
+	}
 
 	return ret;
 }
@@ -485,6 +535,48 @@ static int jffs2_do_reserve_space(struct jffs2_sb_info *c, uint32_t minsize,
 	return 0;
 }
 
+/**
+ *	jffs2_seal_nextblock - seal c->nextblock with its summary node
+ *	@c: superblock info
+ *
+ *	Write out the summary collected for the current nextblock and close
+ *	it ahead of time, so that the next mount reads its summary node
+ *	rather than fully scanning the partially written block. This is
+ *	not a checkpoint: mount still walks the summary of every block to
+ *	rebuild the block lists and the inode cache. The free space left
+ *	in the sealed block is accounted as wasted until GC recycles it.
+ *
+ *	Must be called with the alloc_sem held.
+ */
+int jffs2_seal_nextblock(struct jffs2_sb_info *c)
+{
+	struct jffs2_eraseblock *jeb;
+	int ret = 0;
+
+	if (!jffs2_sum_active())
+		return 0;
+
+	spin_lock(&c->erase_completion_lock);
+
+	jeb = c->nextblock;
+	if (!jeb || jffs2_sum_is_disabled(c->summary) || !c->summary->sum_num)
+		goto out;
+
+	/* Not enough room left for the summary node. */
+	if (PAD(c->summary->sum_size + JFFS2_SUMMARY_FRAME_SIZE) > jeb->free_size)
+		goto out;
+
+	jffs2_dbg(1, "%s(): sealing nextblock 0x%08x\n", __func__, jeb->offset);
+
+	ret = jffs2_sum_write_sumnode(c);
+	if (!ret && !jffs2_sum_is_disabled(c->summary))
+		jffs2_close_nextblock(c, jeb);
+out:
+	spin_unlock(&c->erase_completion_lock);
+
+	return ret;
+}
+
 /**
  *	jffs2_add_physical_node_ref - add a physical node reference to the list
  *	@c: superblock info
@@ -861,7 +953,9 @@ int jffs2_thread_should_wake(struct jffs2_sb_info *c)
 	 */
 	dirty = c->dirty_size + c->erasing_size - c->nr_erasing_blocks * c->sector_size;
 
-	if (c->nr_free_blocks + c->nr_erasing_blocks < c->resv_blocks_gctrigger &&
+	/* The GC watermark may start collecting before space gets short. */
+	if (c->nr_free_blocks + c->nr_erasing_blocks <
+	    max_t(uint32_t, c->resv_blocks_gctrigger, c->mount_opts.gc_watermark) &&
 			(dirty > c->nospc_dirty_size))
 		ret = 1;
 
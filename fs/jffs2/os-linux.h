@@ -145,6 +145,16 @@ void jffs2_dirty_trigger(struct jffs2_sb_info *c);
 int jffs2_start_garbage_collect_thread(struct jffs2_sb_info *c);
 void jffs2_stop_garbage_collect_thread(struct jffs2_sb_info *c);
 void jffs2_garbage_collect_trigger(struct jffs2_sb_info *c);
+bool jffs2_gc_under_pressure(struct jffs2_sb_info *c);
+bool jffs2_gc_fg_budget_exhausted(struct jffs2_sb_info *c, unsigned int passes);
+void jffs2_gc_wait_background(struct jffs2_sb_info *c, uint32_t blocksneeded);
+#ifdef CONFIG_DEBUG_FS
+void jffs2_gc_debugfs_init(struct jffs2_sb_info *c);
+void jffs2_gc_debugfs_exit(struct jffs2_sb_info *c);
+#else
+static inline void jffs2_gc_debugfs_init(struct jffs2_sb_info *c) { }
+static inline void jffs2_gc_debugfs_exit(struct jffs2_sb_info *c) { }
+#endif
 
 /* dir.c */
 extern const struct file_operations jffs2_dir_operations;
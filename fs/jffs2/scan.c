@@ -38,6 +38,8 @@ static uint32_t pseudo_random;
 
 static int jffs2_scan_eraseblock (struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
 				  unsigned char *buf, uint32_t buf_size, struct jffs2_summary *s);
+static int jffs2_fill_scan_buf(struct jffs2_sb_info *c, void *buf,
+			       uint32_t ofs, uint32_t len);
 
 /* These helper functions _must_ increase ofs and also do the dirty/used space accounting.
  * Returning an error will abort the mount - bad checksums etc. should just mark the space
@@ -88,6 +90,194 @@ static int file_dirty(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb)
 	return 0;
 }
 
+#ifdef CONFIG_JFFS2_FS_PARALLEL_SCAN
+/*
+ * When the flash cannot be pointed to, the scan reads every block
+ * without a usable summary through the MTD layer one after another,
+ * interleaving flash I/O and node parsing. Instead, whole blocks are
+ * read ahead of the parser by a pool of unbound workers, so that the
+ * reads, ECC corrections and CRC checks of different blocks overlap.
+ * Blocks are still parsed in order by the mounting thread, since the
+ * in-core lists it builds are not designed for concurrent updates.
+ * Each prefetched block is handed over to jffs2_scan_eraseblock() as
+ * if it was pointed to (XIP-style), so no further read is issued for
+ * it. Blocks ending with a summary marker are left to the regular
+ * summary scan, which only reads the summary node.
+ */
+struct jffs2_scan_slot {
+	struct work_struct work;
+	struct completion done;
+	struct jffs2_sb_info *c;
+	unsigned char *buf;
+	uint32_t blocknr;
+	int err;
+	bool summary;
+};
+
+struct jffs2_scan_prefetch {
+	struct workqueue_struct *wq;
+	struct jffs2_scan_slot *slots;
+	unsigned int nr_slots;
+};
+
+static void jffs2_scan_prefetch_work(struct work_struct *work)
+{
+	struct jffs2_scan_slot *slot =
+		container_of(work, struct jffs2_scan_slot, work);
+	struct jffs2_sb_info *c = slot->c;
+	struct jffs2_eraseblock *jeb = &c->blocks[slot->blocknr];
+	struct jffs2_sum_marker *sm;
+	uint32_t ofs;
+
+	slot->summary = false;
+
+	/* Let the regular scan deal with bad blocks. */
+	if (mtd_block_isbad(c->mtd, jeb->offset)) {
+		slot->err = -EIO;
+		goto out;
+	}
+
+	/*
+	 * Don't read a block the summary scan would only need the
+	 * tail of. If the summary turns out to be unusable, the scan
+	 * reads the block by itself.
+	 */
+	if (jffs2_sum_active()) {
+		ofs = c->sector_size - sizeof(*sm);
+		sm = (void *)slot->buf + ofs;
+		slot->err = jffs2_fill_scan_buf(c, sm, jeb->offset + ofs,
+						sizeof(*sm));
+		if (!slot->err && je32_to_cpu(sm->magic) == JFFS2_SUM_MAGIC) {
+			slot->summary = true;
+			goto out;
+		}
+	}
+
+	slot->err = jffs2_fill_scan_buf(c, slot->buf, jeb->offset,
+					c->sector_size);
+out:
+	complete(&slot->done);
+}
+
+static void jffs2_scan_prefetch_queue(struct jffs2_scan_prefetch *pf,
+				      uint32_t blocknr)
+{
+	struct jffs2_scan_slot *slot = &pf->slots[blocknr % pf->nr_slots];
+
+	slot->blocknr = blocknr;
+	reinit_completion(&slot->done);
+	queue_work(pf->wq, &slot->work);
+}
+
+static void jffs2_scan_prefetch_exit(struct jffs2_scan_prefetch *pf)
+{
+	unsigned int i;
+
+	/* Waits for all pending reads. */
+	if (pf->wq)
+		destroy_workqueue(pf->wq);
+
+	if (pf->slots) {
+		for (i = 0; i < pf->nr_slots; i++)
+			kfree(pf->slots[i].buf);
+		kfree(pf->slots);
+	}
+
+	memset(pf, 0, sizeof(*pf));
+}
+
+static void jffs2_scan_prefetch_init(struct jffs2_sb_info *c,
+				     struct jffs2_scan_prefetch *pf)
+{
+	unsigned int i, nr_slots;
+	size_t size;
+
+	memset(pf, 0, sizeof(*pf));
+
+	if (num_online_cpus() < 2)
+		return;
+
+	nr_slots = min_t(unsigned int, 2 * num_online_cpus(), c->nr_blocks);
+	pf->slots = kcalloc(nr_slots, sizeof(*pf->slots), GFP_KERNEL);
+	if (!pf->slots)
+		return;
+
+	for (i = 0; i < nr_slots; i++) {
+		struct jffs2_scan_slot *slot = &pf->slots[i];
+
+		size = c->sector_size;
+		slot->buf = mtd_kmalloc_up_to(c->mtd, &size);
+		if (!slot->buf || size < c->sector_size) {
+			kfree(slot->buf);
+			slot->buf = NULL;
+			break;
+		}
+		slot->c = c;
+		INIT_WORK(&slot->work, jffs2_scan_prefetch_work);
+		init_completion(&slot->done);
+	}
+
+	pf->nr_slots = i;
+	if (pf->nr_slots < 2)
+		goto fail;
+
+	pf->wq = alloc_workqueue("jffs2_scan", WQ_UNBOUND, num_online_cpus());
+	if (!pf->wq)
+		goto fail;
+
+	jffs2_dbg(1, "Prefetching %u blocks ahead of scan\n", pf->nr_slots);
+
+	for (i = 0; i < pf->nr_slots; i++)
+		jffs2_scan_prefetch_queue(pf, i);
+
+	return;
+fail:
+	jffs2_scan_prefetch_exit(pf);
+}
+
+/*
+ * Pick the prefetched contents of block @blocknr if available, leave
+ * the regular read buffer in place otherwise.
+ */
+static void jffs2_scan_prefetch_get(struct jffs2_scan_prefetch *pf,
+				    uint32_t blocknr, unsigned char **buf,
+				    uint32_t *buf_size)
+{
+	struct jffs2_scan_slot *slot;
+
+	if (!pf->nr_slots)
+		return;
+
+	slot = &pf->slots[blocknr % pf->nr_slots];
+	wait_for_completion(&slot->done);
+	if (!slot->err && !slot->summary) {
+		*buf = slot->buf;
+		*buf_size = 0;
+	}
+}
+
+/* Reuse the slot of the block just scanned for the next one in line. */
+static void jffs2_scan_prefetch_next(struct jffs2_sb_info *c,
+				     struct jffs2_scan_prefetch *pf,
+				     uint32_t blocknr)
+{
+	if (pf->nr_slots && blocknr + pf->nr_slots < c->nr_blocks)
+		jffs2_scan_prefetch_queue(pf, blocknr + pf->nr_slots);
+}
+#else
+struct jffs2_scan_prefetch { };
+
+static inline void jffs2_scan_prefetch_init(struct jffs2_sb_info *c,
+					    struct jffs2_scan_prefetch *pf) { }
+static inline void jffs2_scan_prefetch_exit(struct jffs2_scan_prefetch *pf) { }
+static inline void jffs2_scan_prefetch_get(struct jffs2_scan_prefetch *pf,
+					   uint32_t blocknr, unsigned char **buf,
+					   uint32_t *buf_size) { }
+static inline void jffs2_scan_prefetch_next(struct jffs2_sb_info *c,
+					    struct jffs2_scan_prefetch *pf,
+					    uint32_t blocknr) { }
+#endif	/* !CONFIG_JFFS2_FS_PARALLEL_SCAN */
+
 int jffs2_scan_medium(struct jffs2_sb_info *c)
 {
 	int i, ret;
@@ -95,6 +285,7 @@ int jffs2_scan_medium(struct jffs2_sb_info *c)
 	unsigned char *flashbuf = NULL;
 	uint32_t buf_size = 0;
 	struct jffs2_summary *s = NULL; /* summary info collected by the scan process */
+	struct jffs2_scan_prefetch pf = { };
 #ifndef __ECOS
 	size_t pointlen, try_size;
 
@@ -140,20 +331,28 @@ int jffs2_scan_medium(struct jffs2_sb_info *c)
 		}
 	}
 
+	if (buf_size)
+		jffs2_scan_prefetch_init(c, &pf);
+
 	for (i=0; i<c->nr_blocks; i++) {
 		struct jffs2_eraseblock *jeb = &c->blocks[i];
+		unsigned char *scanbuf = buf_size?flashbuf:(flashbuf+jeb->offset);
+		uint32_t scanbuf_size = buf_size;
 
 		cond_resched();
 
 		/* reset summary info for next eraseblock scan */
 		jffs2_sum_reset_collected(s);
 
-		ret = jffs2_scan_eraseblock(c, jeb, buf_size?flashbuf:(flashbuf+jeb->offset),
-						buf_size, s);
+		jffs2_scan_prefetch_get(&pf, i, &scanbuf, &scanbuf_size);
+
+		ret = jffs2_scan_eraseblock(c, jeb, scanbuf, scanbuf_size, s);
 
 		if (ret < 0)
 			goto out;
 
+		jffs2_scan_prefetch_next(c, &pf, i);
+
 		jffs2_dbg_acct_paranoia_check_nolock(c, jeb);
 
 		/* Now decide which list to put it on */
@@ -275,6 +474,7 @@ int jffs2_scan_medium(struct jffs2_sb_info *c)
 	}
 	ret = 0;
  out:
+	jffs2_scan_prefetch_exit(&pf);
 	if (buf_size)
 		kfree(flashbuf);
 #ifndef __ECOS
@@ -90,6 +90,14 @@ static int jffs2_show_options(struct seq_file *s, struct dentry *root)
 		seq_printf(s, ",compr=%s", jffs2_compr_name(opts->compr));
 	if (opts->set_rp_size)
 		seq_printf(s, ",rp_size=%u", opts->rp_size / 1024);
+	if (opts->seal_summary)
+		seq_puts(s, ",seal_summary");
+	if (opts->gc_rate)
+		seq_printf(s, ",gc_rate=%u", opts->gc_rate / 1024);
+	if (opts->gc_watermark)
+		seq_printf(s, ",gc_watermark=%u", opts->gc_watermark);
+	if (opts->gc_fg_passes)
+		seq_printf(s, ",gc_fg_passes=%u", opts->gc_fg_passes);
 
 	return 0;
 }
@@ -161,10 +169,18 @@ static const struct export_operations jffs2_export_ops = {
  * Opt_source: The source device
  * Opt_override_compr: override default compressor
  * Opt_rp_size: size of reserved pool in KiB
+ * Opt_seal_summary: seal the write block with its summary on unmount
+ * Opt_gc_rate: throughput cap of the background GC in KiB/s
+ * Opt_gc_watermark: free blocks below which GC starts proactively
+ * Opt_gc_fg_passes: max GC passes a foreground write may run inline
  */
 enum {
 	Opt_override_compr,
 	Opt_rp_size,
+	Opt_seal_summary,
+	Opt_gc_rate,
+	Opt_gc_watermark,
+	Opt_gc_fg_passes,
 };
 
 static const struct constant_table jffs2_param_compr[] = {
@@ -181,6 +197,10 @@ static const struct constant_table jffs2_param_compr[] = {
 static const struct fs_parameter_spec jffs2_fs_parameters[] = {
 	fsparam_enum	("compr",	Opt_override_compr, jffs2_param_compr),
 	fsparam_u32	("rp_size",	Opt_rp_size),
+	fsparam_flag_no	("seal_summary", Opt_seal_summary),
+	fsparam_u32	("gc_rate",	Opt_gc_rate),
+	fsparam_u32	("gc_watermark", Opt_gc_watermark),
+	fsparam_u32	("gc_fg_passes", Opt_gc_fg_passes),
 	{}
 };
 
@@ -205,6 +225,26 @@ static int jffs2_parse_param(struct fs_context *fc, struct fs_parameter *param)
 		c->mount_opts.rp_size = result.uint_32 * 1024;
 		c->mount_opts.set_rp_size = true;
 		break;
+	case Opt_seal_summary:
+		if (!jffs2_sum_active())
+			return invalf(fc, "jffs2: seal_summary requires summary support");
+		c->mount_opts.seal_summary = !result.negated;
+		c->mount_opts.set_seal_summary = true;
+		break;
+	case Opt_gc_rate:
+		if (result.uint_32 > UINT_MAX / 1024)
+			return invalf(fc, "jffs2: gc_rate unrepresentable");
+		c->mount_opts.gc_rate = result.uint_32 * 1024;
+		c->mount_opts.set_gc_rate = true;
+		break;
+	case Opt_gc_watermark:
+		c->mount_opts.gc_watermark = result.uint_32;
+		c->mount_opts.set_gc_watermark = true;
+		break;
+	case Opt_gc_fg_passes:
+		c->mount_opts.gc_fg_passes = result.uint_32;
+		c->mount_opts.set_gc_fg_passes = true;
+		break;
 	default:
 		return -EINVAL;
 	}
@@ -226,6 +266,22 @@ static inline void jffs2_update_mount_opts(struct fs_context *fc)
 		c->mount_opts.set_rp_size = new_c->mount_opts.set_rp_size;
 		c->mount_opts.rp_size = new_c->mount_opts.rp_size;
 	}
+	if (new_c->mount_opts.set_seal_summary) {
+		c->mount_opts.set_seal_summary = new_c->mount_opts.set_seal_summary;
+		c->mount_opts.seal_summary = new_c->mount_opts.seal_summary;
+	}
+	if (new_c->mount_opts.set_gc_rate) {
+		c->mount_opts.set_gc_rate = new_c->mount_opts.set_gc_rate;
+		c->mount_opts.gc_rate = new_c->mount_opts.gc_rate;
+	}
+	if (new_c->mount_opts.set_gc_watermark) {
+		c->mount_opts.set_gc_watermark = new_c->mount_opts.set_gc_watermark;
+		c->mount_opts.gc_watermark = new_c->mount_opts.gc_watermark;
+	}
+	if (new_c->mount_opts.set_gc_fg_passes) {
+		c->mount_opts.set_gc_fg_passes = new_c->mount_opts.set_gc_fg_passes;
+		c->mount_opts.gc_fg_passes = new_c->mount_opts.gc_fg_passes;
+	}
 	mutex_unlock(&c->alloc_sem);
 }
 
@@ -257,6 +313,7 @@ static const struct super_operations jffs2_super_operations =
 static int jffs2_fill_super(struct super_block *sb, struct fs_context *fc)
 {
 	struct jffs2_sb_info *c = sb->s_fs_info;
+	int ret;
 
 	jffs2_dbg(1, "jffs2_get_sb_mtd():"
 		  " New superblock for device %d (\"%s\")\n",
@@ -285,7 +342,11 @@ static int jffs2_fill_super(struct super_block *sb, struct fs_context *fc)
 #ifdef CONFIG_JFFS2_FS_POSIX_ACL
 	sb->s_flags |= SB_POSIXACL;
 #endif
-	return jffs2_do_fill_super(sb, fc);
+	ret = jffs2_do_fill_super(sb, fc);
+	if (!ret)
+		jffs2_gc_debugfs_init(c);
+
+	return ret;
 }
 
 static int jffs2_get_tree(struct fs_context *fc)
@@ -324,7 +385,11 @@ static void jffs2_put_super (struct super_block *sb)
 
 	jffs2_dbg(2, "%s()\n", __func__);
 
+	jffs2_gc_debugfs_exit(c);
+
 	mutex_lock(&c->alloc_sem);
+	if (c->mount_opts.seal_summary && !sb_rdonly(sb))
+		jffs2_seal_nextblock(c);
 	jffs2_flush_wbuf_pad(c);
 	mutex_unlock(&c->alloc_sem);
 
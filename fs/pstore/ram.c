@@ -21,6 +21,7 @@
 #include <linux/pstore_ram.h>
 #include <linux/of.h>
 #include <linux/of_address.h>
+#include <linux/timekeeping.h>
 #include "internal.h"
 
 #define RAMOOPS_KERNMSG_HDR "===="
@@ -43,6 +44,10 @@ static ulong ramoops_pmsg_size = MIN_MEM_SIZE;
 module_param_named(pmsg_size, ramoops_pmsg_size, ulong, 0400);
 MODULE_PARM_DESC(pmsg_size, "size of user space message log");
 
+static ulong ramoops_oob_size;
+module_param_named(oob_size, ramoops_oob_size, ulong, 0400);
+MODULE_PARM_DESC(oob_size, "size of out-of-band event log, split between CPUs");
+
 static unsigned long long mem_address;
 module_param_hw(mem_address, ullong, other, 0400);
 MODULE_PARM_DESC(mem_address,
@@ -70,6 +75,12 @@ MODULE_PARM_DESC(ramoops_ecc,
 		"ECC buffer size in bytes (1 is a special value, means 16 "
 		"bytes ECC)");
 
+static int ramoops_oob_ecc;
+module_param_named(oob_ecc, ramoops_oob_ecc, int, 0400);
+MODULE_PARM_DESC(oob_ecc,
+		"if non-zero, ECC buffer size in bytes for the out-of-band "
+		"event log only (1 means 16 bytes ECC), overriding ecc");
+
 static int ramoops_dump_oops = -1;
 module_param_named(dump_oops, ramoops_dump_oops, int, 0400);
 MODULE_PARM_DESC(dump_oops,
@@ -80,6 +91,7 @@ struct ramoops_context {
 	struct persistent_ram_zone *cprz;	/* Console zone */
 	struct persistent_ram_zone **fprzs;	/* Ftrace zones */
 	struct persistent_ram_zone *mprz;	/* PMSG zone */
+	struct persistent_ram_zone **oprzs;	/* Oob event zones */
 	phys_addr_t phys_addr;
 	unsigned long size;
 	unsigned int memtype;
@@ -87,8 +99,10 @@ struct ramoops_context {
 	size_t console_size;
 	size_t ftrace_size;
 	size_t pmsg_size;
+	size_t oob_size;
 	u32 flags;
 	struct persistent_ram_ecc_info ecc_info;
+	struct persistent_ram_ecc_info oob_ecc_info;
 	unsigned int max_dump_cnt;
 	unsigned int dump_write_cnt;
 	/* _read_cnt need clear on ramoops_pstore_open */
@@ -97,6 +111,8 @@ struct ramoops_context {
 	unsigned int max_ftrace_cnt;
 	unsigned int ftrace_read_cnt;
 	unsigned int pmsg_read_cnt;
+	unsigned int max_oob_cnt;
+	unsigned int oob_read_cnt;
 	struct pstore_info pstore;
 };
 
@@ -110,6 +126,7 @@ static int ramoops_pstore_open(struct pstore_info *psi)
 	cxt->console_read_cnt = 0;
 	cxt->ftrace_read_cnt = 0;
 	cxt->pmsg_read_cnt = 0;
+	cxt->oob_read_cnt = 0;
 	return 0;
 }
 
@@ -213,6 +230,11 @@ static ssize_t ramoops_pstore_read(struct pstore_record *record)
 	if (!prz_ok(prz) && !cxt->pmsg_read_cnt++)
 		prz = ramoops_get_next_prz(&cxt->mprz, 0 /* single */, record);
 
+	/* One record per CPU, time stamps are part of the log lines. */
+	while (cxt->oob_read_cnt < cxt->max_oob_cnt && !prz_ok(prz))
+		prz = ramoops_get_next_prz(cxt->oprzs, cxt->oob_read_cnt++,
+					   record);
+
 	/* ftrace is last since it may want to dynamically allocate memory. */
 	if (!prz_ok(prz)) {
 		if (!(cxt->flags & RAMOOPS_FLAG_FTRACE_PER_CPU) &&
@@ -425,6 +447,11 @@ static int ramoops_pstore_erase(struct pstore_record *record)
 	case PSTORE_TYPE_PMSG:
 		prz = cxt->mprz;
 		break;
+	case PSTORE_TYPE_OOB:
+		if (record->id >= cxt->max_oob_cnt)
+			return -EINVAL;
+		prz = cxt->oprzs[record->id];
+		break;
 	default:
 		return -EINVAL;
 	}
@@ -447,6 +474,50 @@ static struct ramoops_context oops_cxt = {
 	},
 };
 
+/**
+ * ramoops_oob_write - append an event to the persistent oob log
+ * @buf: event data, usually a text line
+ * @len: length of @buf
+ *
+ * The event is prefixed with a monotonic time stamp and appended to the
+ * zone of the current CPU. This may be called from either stage,
+ * including from oob interrupt handlers: the zone is only ever written
+ * by the CPU owning it, with hard irqs off, so no lock is involved.
+ * Once the machine has restarted, the log of each CPU shows up as
+ * oob-ramoops-<cpu> under the pstore filesystem.
+ *
+ * Returns 0 on success, -ENODEV if no oob log was configured.
+ */
+int notrace ramoops_oob_write(const void *buf, size_t len)
+{
+	struct ramoops_context *cxt = &oops_cxt;
+	char hdr[32]; /* "["(1), %5llu(20), "."(1), %06u(6), "] "(2) */
+	struct persistent_ram_zone **przs, *prz;
+	unsigned long flags;
+	size_t hlen;
+	u32 rem;
+	u64 ts;
+
+	przs = READ_ONCE(cxt->oprzs);
+	if (!przs)
+		return -ENODEV;
+
+	flags = hard_local_irq_save();
+
+	ts = ktime_get_mono_fast_ns();
+	rem = do_div(ts, NSEC_PER_SEC);
+	hlen = scnprintf(hdr, sizeof(hdr), "[%5llu.%06u] ", ts, rem / 1000);
+
+	prz = przs[raw_smp_processor_id()];
+	persistent_ram_write(prz, hdr, hlen);
+	persistent_ram_write(prz, buf, len);
+
+	hard_local_irq_restore(flags);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(ramoops_oob_write);
+
 static void ramoops_free_przs(struct ramoops_context *cxt)
 {
 	int i;
@@ -467,6 +538,15 @@ static void ramoops_free_przs(struct ramoops_context *cxt)
 		kfree(cxt->fprzs);
 		cxt->max_ftrace_cnt = 0;
 	}
+
+	/* Free oob PRZs */
+	if (cxt->oprzs) {
+		for (i = 0; i < cxt->max_oob_cnt; i++)
+			persistent_ram_free(cxt->oprzs[i]);
+		kfree(cxt->oprzs);
+		cxt->oprzs = NULL;
+		cxt->max_oob_cnt = 0;
+	}
 }
 
 static int ramoops_init_przs(const char *name,
@@ -474,6 +554,7 @@ static int ramoops_init_przs(const char *name,
 			     struct persistent_ram_zone ***przs,
 			     phys_addr_t *paddr, size_t mem_sz,
 			     ssize_t record_size,
+			     struct persistent_ram_ecc_info *ecc_info,
 			     unsigned int *cnt, u32 sig, u32 flags)
 {
 	int err = -ENOMEM;
@@ -537,7 +618,7 @@ static int ramoops_init_przs(const char *name,
 			label = kasprintf(GFP_KERNEL, "ramoops:%s(%d/%d)",
 					  name, i, *cnt - 1);
 		prz_ar[i] = persistent_ram_new(*paddr, zone_sz, sig,
-					       &cxt->ecc_info,
+					       ecc_info,
 					       cxt->memtype, flags, label);
 		kfree(label);
 		if (IS_ERR(prz_ar[i])) {
@@ -675,7 +756,9 @@ static int ramoops_parse_dt(struct platform_device *pdev,
 	parse_u32("console-size", pdata->console_size, 0);
 	parse_u32("ftrace-size", pdata->ftrace_size, 0);
 	parse_u32("pmsg-size", pdata->pmsg_size, 0);
+	parse_u32("oob-size", pdata->oob_size, 0);
 	parse_u32("ecc-size", pdata->ecc_info.ecc_size, 0);
+	parse_u32("oob-ecc-size", pdata->oob_ecc_size, 0);
 	parse_u32("flags", pdata->flags, 0);
 	parse_u32("max-reason", pdata->max_reason, pdata->max_reason);
 
@@ -739,7 +822,8 @@ static int ramoops_probe(struct platform_device *pdev)
 	}
 
 	if (!pdata->mem_size || (!pdata->record_size && !pdata->console_size &&
-			!pdata->ftrace_size && !pdata->pmsg_size)) {
+			!pdata->ftrace_size && !pdata->pmsg_size &&
+			!pdata->oob_size)) {
 		pr_err("The memory size and the record/console size must be "
 			"non-zero\n");
 		goto fail_out;
@@ -753,6 +837,8 @@ static int ramoops_probe(struct platform_device *pdev)
 		pdata->ftrace_size = rounddown_pow_of_two(pdata->ftrace_size);
 	if (pdata->pmsg_size && !is_power_of_2(pdata->pmsg_size))
 		pdata->pmsg_size = rounddown_pow_of_two(pdata->pmsg_size);
+	if (pdata->oob_size && !is_power_of_2(pdata->oob_size))
+		pdata->oob_size = rounddown_pow_of_two(pdata->oob_size);
 
 	cxt->size = pdata->mem_size;
 	cxt->phys_addr = pdata->mem_address;
@@ -761,15 +847,19 @@ static int ramoops_probe(struct platform_device *pdev)
 	cxt->console_size = pdata->console_size;
 	cxt->ftrace_size = pdata->ftrace_size;
 	cxt->pmsg_size = pdata->pmsg_size;
+	cxt->oob_size = pdata->oob_size;
 	cxt->flags = pdata->flags;
 	cxt->ecc_info = pdata->ecc_info;
+	cxt->oob_ecc_info = pdata->ecc_info;
+	if (pdata->oob_ecc_size)
+		cxt->oob_ecc_info.ecc_size = pdata->oob_ecc_size;
 
 	paddr = cxt->phys_addr;
 
 	dump_mem_sz = cxt->size - cxt->console_size - cxt->ftrace_size
-			- cxt->pmsg_size;
+			- cxt->pmsg_size - cxt->oob_size;
 	err = ramoops_init_przs("dmesg", dev, cxt, &cxt->dprzs, &paddr,
-				dump_mem_sz, cxt->record_size,
+				dump_mem_sz, cxt->record_size, &cxt->ecc_info,
 				&cxt->max_dump_cnt, 0, 0);
 	if (err)
 		goto fail_out;
@@ -783,7 +873,7 @@ static int ramoops_probe(struct platform_device *pdev)
 				? nr_cpu_ids
 				: 1;
 	err = ramoops_init_przs("ftrace", dev, cxt, &cxt->fprzs, &paddr,
-				cxt->ftrace_size, -1,
+				cxt->ftrace_size, -1, &cxt->ecc_info,
 				&cxt->max_ftrace_cnt, LINUX_VERSION_CODE,
 				(cxt->flags & RAMOOPS_FLAG_FTRACE_PER_CPU)
 					? PRZ_FLAG_NO_LOCK : 0);
@@ -795,6 +885,18 @@ static int ramoops_probe(struct platform_device *pdev)
 	if (err)
 		goto fail_init_mprz;
 
+	/*
+	 * Each oob zone is only written by its own CPU with hard irqs
+	 * off, so it needs no lock, which is what makes it usable from
+	 * the oob stage.
+	 */
+	cxt->max_oob_cnt = nr_cpu_ids;
+	err = ramoops_init_przs("oob", dev, cxt, &cxt->oprzs, &paddr,
+				cxt->oob_size, -1, &cxt->oob_ecc_info,
+				&cxt->max_oob_cnt, 0, PRZ_FLAG_NO_LOCK);
+	if (err)
+		goto fail_init_oprz;
+
 	cxt->pstore.data = cxt;
 	/*
 	 * Prepare frontend flags based on which areas are initialized.
@@ -846,6 +948,7 @@ static int ramoops_probe(struct platform_device *pdev)
 	ramoops_console_size = pdata->console_size;
 	ramoops_pmsg_size = pdata->pmsg_size;
 	ramoops_ftrace_size = pdata->ftrace_size;
+	ramoops_oob_size = pdata->oob_size;
 
 	pr_info("using 0x%lx@0x%llx, ecc: %d\n",
 		cxt->size, (unsigned long long)cxt->phys_addr,
@@ -857,6 +960,7 @@ static int ramoops_probe(struct platform_device *pdev)
 	kfree(cxt->pstore.buf);
 fail_clear:
 	cxt->pstore.bufsize = 0;
+fail_init_oprz:
 	persistent_ram_free(cxt->mprz);
 fail_init_mprz:
 fail_init_fprz:
@@ -925,6 +1029,7 @@ static void __init ramoops_register_dummy(void)
 	pdata.console_size = ramoops_console_size;
 	pdata.ftrace_size = ramoops_ftrace_size;
 	pdata.pmsg_size = ramoops_pmsg_size;
+	pdata.oob_size = ramoops_oob_size;
 	/* If "max_reason" is set, its value has priority over "dump_oops". */
 	if (ramoops_max_reason >= 0)
 		pdata.max_reason = ramoops_max_reason;
@@ -942,6 +1047,7 @@ static void __init ramoops_register_dummy(void)
 	 * (using 1 byte for ECC isn't much of use anyway).
 	 */
 	pdata.ecc_info.ecc_size = ramoops_ecc == 1 ? 16 : ramoops_ecc;
+	pdata.oob_ecc_size = ramoops_oob_ecc == 1 ? 16 : ramoops_oob_ecc;
 
 	dummy = platform_device_register_data(NULL, "ramoops", -1,
 			&pdata, sizeof(pdata));
@@ -8,6 +8,7 @@
 
 #include <linux/kconfig.h>
 #include <linux/types.h>
+#include <linux/instruction_pointer.h>
 
 #ifdef CONFIG_IRQ_PIPELINE
 
@@ -22,10 +23,82 @@ int inband_irqs_disabled(void);
 #define hard_cond_local_irq_save()		hard_local_irq_save()
 #define hard_cond_local_irq_restore(__flags)	hard_local_irq_restore(__flags)
 
+#ifdef CONFIG_HARD_IRQSOFF_TRACER
+
+extern int hard_irqsoff_tracing;
+
+void __trace_hard_irqs_off(unsigned long ip, unsigned long parent_ip);
+void __trace_hard_irqs_on(void);
+void hard_irqsoff_trace_discard(void);
+u64 hard_irqsoff_last_overlap(u64 window_ns, unsigned long *ip);
+
+#define __hard_irqsoff_trace_section()					\
+	__trace_hard_irqs_off(_THIS_IP_,				\
+			(unsigned long)__builtin_return_address(0))
+
+#define __hard_irqsoff_trace_off()					\
+	do {								\
+		if (unlikely(hard_irqsoff_tracing))			\
+			__hard_irqsoff_trace_section();			\
+	} while (0)
+
+#define __hard_irqsoff_trace_on()					\
+	do {								\
+		if (unlikely(hard_irqsoff_tracing))			\
+			__trace_hard_irqs_on();				\
+	} while (0)
+
+#define hard_local_irq_save()						\
+	({								\
+		unsigned long __hflags = native_irq_save();		\
+		if (!native_irqs_disabled_flags(__hflags))		\
+			__hard_irqsoff_trace_off();			\
+		__hflags;						\
+	})
+
+#define hard_local_irq_restore(__flags)					\
+	do {								\
+		unsigned long __hflags = (__flags);			\
+		if (!native_irqs_disabled_flags(__hflags))		\
+			__hard_irqsoff_trace_on();			\
+		native_irq_restore(__hflags);				\
+	} while (0)
+
+#define hard_local_irq_enable()						\
+	do {								\
+		__hard_irqsoff_trace_on();				\
+		native_irq_enable();					\
+	} while (0)
+
+#define hard_local_irq_disable()					\
+	do {								\
+		bool __hwason = unlikely(hard_irqsoff_tracing) &&	\
+			!native_irqs_disabled();			\
+		native_irq_disable();					\
+		if (__hwason)						\
+			__hard_irqsoff_trace_section();			\
+	} while (0)
+
+/* Close the current section, irqs are about to be re-enabled by eret. */
+#define hard_irqsoff_trace_end()	__hard_irqsoff_trace_on()
+
+#else
+
+static inline void hard_irqsoff_trace_discard(void) { }
+#define hard_irqsoff_trace_end()	do { } while (0)
+
+static inline u64 hard_irqsoff_last_overlap(u64 window_ns, unsigned long *ip)
+{
+	return 0;
+}
+
 #define hard_local_irq_save()			native_irq_save()
 #define hard_local_irq_restore(__flags)		native_irq_restore(__flags)
 #define hard_local_irq_enable()			native_irq_enable()
 #define hard_local_irq_disable()		native_irq_disable()
+
+#endif	/* !CONFIG_HARD_IRQSOFF_TRACER */
+
 #define hard_local_save_flags()			native_save_flags()
 
 #define hard_irqs_disabled()			native_irqs_disabled()
@@ -64,6 +137,9 @@ void irq_pipeline_nmi_exit(void);
 						raw_local_irq_save(__flags); __flags; })
 #define hard_local_irq_restore(__flags)		raw_local_irq_restore(__flags)
 
+static inline void hard_irqsoff_trace_discard(void) { }
+#define hard_irqsoff_trace_end()		do { } while (0)
+
 #define hard_cond_local_irq_enable()		do { } while(0)
 #define hard_cond_local_irq_disable()		do { } while(0)
 #define hard_cond_local_irq_save()		0
@@ -9,4 +9,12 @@
 struct oob_poll_wait {
 };
 
+/*
+ * Placeholder for the out-of-band poll head drivers signal events
+ * to, which oob_poll() handlers hook waiters on.
+ */
+
+struct oob_poll_head {
+};
+
 #endif /* !_DOVETAIL_POLL_H */
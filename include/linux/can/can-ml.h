@@ -64,6 +64,9 @@ struct can_ml_priv {
 #ifdef CAN_J1939
 	struct j1939_priv *j1939_priv;
 #endif
+#ifdef CONFIG_CAN_RX_OFFLOAD_OOB
+	struct can_rx_offload *rx_offload;
+#endif
 };
 
 static inline struct can_ml_priv *can_get_ml_priv(struct net_device *dev)
@@ -11,6 +11,41 @@
 
 #include <linux/netdevice.h>
 #include <linux/can.h>
+#ifdef CONFIG_CAN_RX_OFFLOAD_OOB
+#include <linux/spinlock.h>
+#include <dovetail/poll.h>
+#endif
+
+struct can_rx_offload;
+
+#ifdef CONFIG_CAN_RX_OFFLOAD_OOB
+
+#define CAN_OOB_FRAME_FD	BIT(0)	/* @frame is a CAN FD frame */
+
+/* Frame record delivered to oob readers. */
+struct can_oob_frame {
+	u64 timestamp;		/* CLOCK_MONOTONIC (ns) at IRQ time */
+	u32 hw_timestamp;	/* raw controller timestamp */
+	u32 flags;
+	struct canfd_frame frame;
+};
+
+struct can_rx_offload_oob {
+	hard_spinlock_t lock;
+	struct can_oob_frame *ring;
+	unsigned int size;	/* power of two */
+	unsigned int head;
+	unsigned int tail;
+	bool active;
+	u64 rx_packets;
+	u64 rx_dropped;
+	struct oob_poll_head poll;
+	/* Submit a frame from the oob stage, may be NULL. */
+	int (*xmit)(struct can_rx_offload *offload,
+		    const struct canfd_frame *cf, u32 flags);
+};
+
+#endif
 
 struct can_rx_offload {
 	struct net_device *dev;
@@ -28,6 +63,10 @@ struct can_rx_offload {
 	struct napi_struct napi;
 
 	bool inc;
+
+#ifdef CONFIG_CAN_RX_OFFLOAD_OOB
+	struct can_rx_offload_oob oob;
+#endif
 };
 
 int can_rx_offload_add_timestamp(struct net_device *dev,
@@ -51,6 +90,40 @@ int can_rx_offload_queue_tail(struct can_rx_offload *offload,
 void can_rx_offload_del(struct can_rx_offload *offload);
 void can_rx_offload_enable(struct can_rx_offload *offload);
 
+#ifdef CONFIG_CAN_RX_OFFLOAD_OOB
+
+int can_rx_offload_add_oob(struct net_device *dev,
+			   struct can_rx_offload *offload);
+void can_rx_offload_del_oob(struct can_rx_offload *offload);
+struct can_rx_offload *can_rx_offload_oob_get(struct net_device *dev);
+int can_rx_offload_oob_enable(struct can_rx_offload *offload,
+			      unsigned int nr_frames);
+void can_rx_offload_oob_disable(struct can_rx_offload *offload);
+int can_rx_offload_oob_queue(struct can_rx_offload *offload,
+			     const struct canfd_frame *cf, u32 flags,
+			     u32 hw_timestamp);
+ssize_t can_rx_offload_oob_read(struct can_rx_offload *offload,
+				struct can_oob_frame *frames,
+				unsigned int count);
+__poll_t can_rx_offload_oob_poll(struct can_rx_offload *offload,
+				 struct oob_poll_wait *wait);
+int can_rx_offload_oob_xmit(struct can_rx_offload *offload,
+			    const struct canfd_frame *cf, u32 flags);
+
+static inline bool can_rx_offload_oob_active(struct can_rx_offload *offload)
+{
+	return READ_ONCE(offload->oob.active);
+}
+
+#else
+
+static inline bool can_rx_offload_oob_active(struct can_rx_offload *offload)
+{
+	return false;
+}
+
+#endif
+
 static inline void can_rx_offload_schedule(struct can_rx_offload *offload)
 {
 	napi_schedule(&offload->napi);
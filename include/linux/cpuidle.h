@@ -273,6 +273,16 @@ struct cpuidle_governor {
 
 extern int cpuidle_register_governor(struct cpuidle_governor *gov);
 extern s64 cpuidle_governor_latency_req(unsigned int cpu);
+#ifdef CONFIG_IRQ_PIPELINE
+extern void cpuidle_governor_oob_req(struct cpuidle_device *dev,
+				     s64 *latency_req, s64 *sleep_length_ns);
+#else
+static inline void cpuidle_governor_oob_req(struct cpuidle_device *dev,
+					    s64 *latency_req,
+					    s64 *sleep_length_ns)
+{
+}
+#endif
 
 #define __CPU_PM_CPU_IDLE_ENTER(low_level_idle_enter,			\
 				idx,					\
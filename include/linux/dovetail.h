@@ -9,6 +9,7 @@
 #ifdef CONFIG_DOVETAIL
 
 #include <linux/sched.h>
+#include <linux/sched/coredump.h>
 #include <linux/mm.h>
 #include <linux/thread_info.h>
 #include <linux/irqstage.h>
@@ -56,6 +57,21 @@ struct dovetail_altsched_context {
 
 void inband_task_init(struct task_struct *p);
 
+/*
+ * True if @mm belongs to a process running threads on the
+ * out-of-band stage, whose pages should neither be moved nor
+ * shared behind its back. Page migration and THP splits are refused
+ * for such pages, so that CMA allocations covering them fail with
+ * -EBUSY, and offlining the memory block they sit in keeps retrying
+ * until the process unmaps them, or the offlining task is signaled.
+ */
+static inline bool dovetailed_mm(struct mm_struct *mm)
+{
+	return test_bit(MMF_DOVETAILED, &mm->flags);
+}
+
+int dovetail_prefault_mm(void);
+
 int pipeline_syscall(unsigned int nr, struct pt_regs *regs);
 
 void __oob_trap_notify(unsigned int exception,
@@ -228,6 +244,20 @@ void uninstall_inband_fd(unsigned int fd, struct file *file,
 void replace_inband_fd(unsigned int fd, struct file *file,
 		       struct files_struct *files);
 
+struct oob_poll_head;
+struct oob_poll_wait;
+
+void oob_poll_head_init(struct oob_poll_head *head);
+
+void oob_poll_head_destroy(struct oob_poll_head *head);
+
+void oob_poll_watch(struct oob_poll_head *head,
+		    struct oob_poll_wait *wait);
+
+void oob_poll_signal(struct oob_poll_head *head, __poll_t events);
+
+bool oob_cpu_busy(int cpu);
+
 #else	/* !CONFIG_DOVETAIL */
 
 struct files_struct;
@@ -303,6 +333,37 @@ static inline
 void replace_inband_fd(unsigned int fd, struct file *file,
 		       struct files_struct *files) { }
 
+struct oob_poll_head;
+struct oob_poll_wait;
+
+static inline
+void oob_poll_head_init(struct oob_poll_head *head) { }
+
+static inline
+void oob_poll_head_destroy(struct oob_poll_head *head) { }
+
+static inline
+void oob_poll_watch(struct oob_poll_head *head,
+		    struct oob_poll_wait *wait) { }
+
+static inline
+void oob_poll_signal(struct oob_poll_head *head, __poll_t events) { }
+
+static inline bool oob_cpu_busy(int cpu)
+{
+	return false;
+}
+
+static inline bool dovetailed_mm(struct mm_struct *mm)
+{
+	return false;
+}
+
+static inline int dovetail_prefault_mm(void)
+{
+	return -ENOSYS;
+}
+
 #endif	/* !CONFIG_DOVETAIL */
 
 static __always_inline bool dovetailing(void)
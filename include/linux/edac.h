@@ -22,6 +22,7 @@
 #define EDAC_DEVICE_NAME_LEN	31
 
 struct device;
+struct edac_scrub;
 
 #define EDAC_OPSTATE_INVAL	-1
 #define EDAC_OPSTATE_POLL	0
@@ -305,7 +306,7 @@ enum scrub_type {
 #define SCRUB_FLAG_SW_PROG	BIT(SCRUB_SW_PROG)
 #define SCRUB_FLAG_SW_SRC	BIT(SCRUB_SW_SRC)
 #define SCRUB_FLAG_SW_PROG_SRC	BIT(SCRUB_SW_PROG_SRC)
-#define SCRUB_FLAG_SW_TUN	BIT(SCRUB_SW_SCRUB_TUNABLE)
+#define SCRUB_FLAG_SW_TUN	BIT(SCRUB_SW_TUNABLE)
 #define SCRUB_FLAG_HW_PROG	BIT(SCRUB_HW_PROG)
 #define SCRUB_FLAG_HW_SRC	BIT(SCRUB_HW_SRC)
 #define SCRUB_FLAG_HW_PROG_SRC	BIT(SCRUB_HW_PROG_SRC)
@@ -514,6 +515,9 @@ struct mem_ctl_info {
 	 */
 	int (*get_sdram_scrub_rate) (struct mem_ctl_info * mci);
 
+	/* software scrubber state, see edac_scrub_init() */
+	struct edac_scrub *scrub;
+
 
 	/* pointer to edac checking routine */
 	void (*edac_check) (struct mem_ctl_info * mci);
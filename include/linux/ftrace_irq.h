@@ -7,12 +7,22 @@ extern bool trace_hwlat_callback_enabled;
 extern void trace_hwlat_callback(bool enter);
 #endif
 
+#ifdef CONFIG_OOB_TIMERLAT_TRACER
+extern bool trace_oob_timerlat_callback_enabled;
+extern void trace_oob_timerlat_nmi(bool enter);
+extern void trace_oob_timerlat_replay(bool enter);
+#endif
+
 static inline void ftrace_nmi_enter(void)
 {
 #ifdef CONFIG_HWLAT_TRACER
 	if (trace_hwlat_callback_enabled)
 		trace_hwlat_callback(true);
 #endif
+#ifdef CONFIG_OOB_TIMERLAT_TRACER
+	if (trace_oob_timerlat_callback_enabled)
+		trace_oob_timerlat_nmi(true);
+#endif
 }
 
 static inline void ftrace_nmi_exit(void)
@@ -21,6 +31,30 @@ static inline void ftrace_nmi_exit(void)
 	if (trace_hwlat_callback_enabled)
 		trace_hwlat_callback(false);
 #endif
+#ifdef CONFIG_OOB_TIMERLAT_TRACER
+	if (trace_oob_timerlat_callback_enabled)
+		trace_oob_timerlat_nmi(false);
+#endif
+}
+
+/*
+ * Bracket the replay of the interrupts logged for the in-band stage,
+ * which delays in-band tasks woken up by out-of-band events.
+ */
+static inline void ftrace_inband_replay_enter(void)
+{
+#ifdef CONFIG_OOB_TIMERLAT_TRACER
+	if (trace_oob_timerlat_callback_enabled)
+		trace_oob_timerlat_replay(true);
+#endif
+}
+
+static inline void ftrace_inband_replay_exit(void)
+{
+#ifdef CONFIG_OOB_TIMERLAT_TRACER
+	if (trace_oob_timerlat_callback_enabled)
+		trace_oob_timerlat_replay(false);
+#endif
 }
 
 #endif /* _LINUX_FTRACE_IRQ_H */
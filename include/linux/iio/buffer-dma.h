@@ -11,17 +11,16 @@
 #include <linux/kref.h>
 #include <linux/spinlock.h>
 #include <linux/mutex.h>
+#include <linux/irq_work.h>
 #include <linux/iio/buffer_impl.h>
+#ifdef CONFIG_IIO_BUFFER_DMA_OOB
+#include <dovetail/poll.h>
+#endif
 
 struct iio_dma_buffer_queue;
 struct iio_dma_buffer_ops;
 struct device;
 
-struct iio_buffer_block {
-	u32 size;
-	u32 bytes_used;
-};
-
 /**
  * enum iio_block_state - State of a struct iio_dma_buffer_block
  * @IIO_BLOCK_STATE_DEQUEUED: Block is not queued
@@ -86,6 +85,76 @@ struct iio_dma_buffer_queue_fileio {
 	size_t block_size;
 };
 
+/**
+ * enum iio_ring_block_state - State of a block of the DMA block ring
+ * @IIO_RING_BLOCK_FREE: Block may be filled by the DMA controller
+ * @IIO_RING_BLOCK_DONE: Block holds fresh data, waiting to be dequeued
+ * @IIO_RING_BLOCK_USER: Block has been dequeued by the application
+ */
+enum iio_ring_block_state {
+	IIO_RING_BLOCK_FREE,
+	IIO_RING_BLOCK_DONE,
+	IIO_RING_BLOCK_USER,
+};
+
+/**
+ * struct iio_dma_buffer_ring_block - Block of the DMA block ring
+ * @timestamp: CLOCK_MONOTONIC time of completion in ns
+ * @seq: Completion sequence number
+ * @state: Current state of the block
+ */
+struct iio_dma_buffer_ring_block {
+	u64 timestamp;
+	u32 seq;
+	enum iio_ring_block_state state;
+};
+
+/**
+ * struct iio_dma_buffer_ring - Block ring mapped by the application
+ * @lock: Protects the ring state, may be taken from the oob stage
+ * @vaddr: Virtual address of the ring memory
+ * @phys_addr: Physical address of the ring memory
+ * @block_size: Size of each block in bytes
+ * @num_blocks: Number of blocks, 0 when no ring is allocated
+ * @blocks: Per-block state
+ * @done: FIFO of the ids of completed blocks, oldest first
+ * @done_head: Index of the oldest entry in @done
+ * @done_count: Number of entries in @done
+ * @hw_pos: Block the DMA controller is filling
+ * @seq: Number of blocks completed since the ring was started
+ * @overruns: Blocks overwritten since the last dequeue
+ * @running: Whether the DMA controller is filling the ring
+ * @mapped: Number of live mappings of the ring
+ * @wake_work: Relays oob completions to in-band pollers
+ * @poll: oob poll head signaled on completion
+ *
+ * The DMA controller fills the blocks in order, cyclically. A block
+ * which is still held by the application when the controller reaches it
+ * is overwritten, which is reported as an overrun. So is a completed
+ * block which was not dequeued yet, it is dropped from @done as soon as
+ * the controller moves on to it.
+ */
+struct iio_dma_buffer_ring {
+	hard_spinlock_t lock;
+	void *vaddr;
+	dma_addr_t phys_addr;
+	size_t block_size;
+	unsigned int num_blocks;
+	struct iio_dma_buffer_ring_block *blocks;
+	unsigned int *done;
+	unsigned int done_head;
+	unsigned int done_count;
+	unsigned int hw_pos;
+	u32 seq;
+	u32 overruns;
+	bool running;
+	atomic_t mapped;
+	struct irq_work wake_work;
+#ifdef CONFIG_IIO_BUFFER_DMA_OOB
+	struct oob_poll_head poll;
+#endif
+};
+
 /**
  * struct iio_dma_buffer_queue - DMA buffer base structure
  * @buffer: IIO buffer base structure
@@ -101,6 +170,7 @@ struct iio_dma_buffer_queue_fileio {
  * @outgoing: List of buffers on the outgoing queue
  * @active: Whether the buffer is currently active
  * @fileio: FileIO state
+ * @ring: Block ring state, used instead of @fileio once allocated
  */
 struct iio_dma_buffer_queue {
 	struct iio_buffer buffer;
@@ -115,17 +185,22 @@ struct iio_dma_buffer_queue {
 	bool active;
 
 	struct iio_dma_buffer_queue_fileio fileio;
+	struct iio_dma_buffer_ring ring;
 };
 
 /**
  * struct iio_dma_buffer_ops - DMA buffer callback operations
  * @submit: Called when a block is submitted to the DMA controller
  * @abort: Should abort all pending transfers
+ * @ring_start: Start filling the block ring cyclically, calling
+ *   iio_dma_buffer_ring_block_done() for each completed block. Stopped by
+ *   @abort. Block rings are not supported if NULL.
  */
 struct iio_dma_buffer_ops {
 	int (*submit)(struct iio_dma_buffer_queue *queue,
 		struct iio_dma_buffer_block *block);
 	void (*abort)(struct iio_dma_buffer_queue *queue);
+	int (*ring_start)(struct iio_dma_buffer_queue *queue);
 };
 
 void iio_dma_buffer_block_done(struct iio_dma_buffer_block *block);
@@ -143,6 +218,23 @@ int iio_dma_buffer_set_bytes_per_datum(struct iio_buffer *buffer, size_t bpd);
 int iio_dma_buffer_set_length(struct iio_buffer *buffer, unsigned int length);
 int iio_dma_buffer_request_update(struct iio_buffer *buffer);
 
+void iio_dma_buffer_ring_block_done(struct iio_dma_buffer_queue *queue);
+int iio_dma_buffer_alloc_blocks(struct iio_buffer *buffer,
+	struct iio_buffer_block_alloc_req *req);
+int iio_dma_buffer_free_blocks(struct iio_buffer *buffer);
+int iio_dma_buffer_query_block(struct iio_buffer *buffer,
+	struct iio_buffer_block *block);
+int iio_dma_buffer_enqueue_block(struct iio_buffer *buffer,
+	struct iio_buffer_block *block);
+int iio_dma_buffer_dequeue_block(struct iio_buffer *buffer,
+	struct iio_buffer_block *block);
+int iio_dma_buffer_mmap(struct iio_buffer *buffer,
+	struct vm_area_struct *vma);
+#ifdef CONFIG_IIO_BUFFER_DMA_OOB
+__poll_t iio_dma_buffer_oob_poll(struct iio_buffer *buffer,
+	struct oob_poll_wait *wait);
+#endif
+
 int iio_dma_buffer_init(struct iio_dma_buffer_queue *queue,
 	struct device *dma_dev, const struct iio_dma_buffer_ops *ops);
 void iio_dma_buffer_exit(struct iio_dma_buffer_queue *queue);
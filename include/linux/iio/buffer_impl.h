@@ -10,6 +10,8 @@
 
 struct iio_dev;
 struct iio_buffer;
+struct oob_poll_wait;
+struct vm_area_struct;
 
 /**
  * INDIO_BUFFER_FLAG_FIXED_WATERMARK - Watermark level of the buffer can not be
@@ -34,6 +36,16 @@ struct iio_buffer;
  *                      device stops sampling. Calles are balanced with @enable.
  * @release:		called when the last reference to the buffer is dropped,
  *			should free all resources allocated by the buffer.
+ * @alloc_blocks:	allocate the blocks of a block ring, which replaces
+ *			read() based access until freed.
+ * @free_blocks:	free the blocks allocated by @alloc_blocks.
+ * @query_block:	fill the descriptor of the block with the given id.
+ * @enqueue_block:	give a block back to the buffer. May be called from
+ *			the out-of-band stage.
+ * @dequeue_block:	fetch the oldest completed block, -EAGAIN if none.
+ *			May be called from the out-of-band stage.
+ * @mmap:		map the memory of the blocks.
+ * @oob_poll:		out-of-band poll handler for the block ring.
  * @modes:		Supported operating modes by this buffer type
  * @flags:		A bitmask combination of INDIO_BUFFER_FLAG_*
  *
@@ -60,6 +72,19 @@ struct iio_buffer_access_funcs {
 
 	void (*release)(struct iio_buffer *buffer);
 
+	int (*alloc_blocks)(struct iio_buffer *buffer,
+			    struct iio_buffer_block_alloc_req *req);
+	int (*free_blocks)(struct iio_buffer *buffer);
+	int (*query_block)(struct iio_buffer *buffer,
+			   struct iio_buffer_block *block);
+	int (*enqueue_block)(struct iio_buffer *buffer,
+			     struct iio_buffer_block *block);
+	int (*dequeue_block)(struct iio_buffer *buffer,
+			     struct iio_buffer_block *block);
+	int (*mmap)(struct iio_buffer *buffer, struct vm_area_struct *vma);
+	__poll_t (*oob_poll)(struct iio_buffer *buffer,
+			     struct oob_poll_wait *wait);
+
 	unsigned int modes;
 	unsigned int flags;
 };
@@ -161,6 +161,27 @@ void iio_trigger_poll_chained(struct iio_trigger *trig);
 
 irqreturn_t iio_trigger_generic_data_rdy_poll(int irq, void *private);
 
+#ifdef CONFIG_IIO_TRIGGER_OOB
+/**
+ * iio_trigger_poll_oob() - called on a trigger occurring out-of-band
+ * @trig:	trigger which occurred
+ *
+ * May be called from an IRQF_OOB handler. Consumers whose poll function
+ * was requested with IRQF_OOB are run immediately from the oob stage,
+ * the others are deferred to the in-band stage. The reenable() handler
+ * of @trig must be oob-safe. Behaves like iio_trigger_poll() when called
+ * in-band.
+ **/
+void iio_trigger_poll_oob(struct iio_trigger *trig);
+irqreturn_t iio_trigger_generic_data_rdy_poll_oob(int irq, void *private);
+#else
+static inline void iio_trigger_poll_oob(struct iio_trigger *trig)
+{
+	iio_trigger_poll(trig);
+}
+#define iio_trigger_generic_data_rdy_poll_oob iio_trigger_generic_data_rdy_poll
+#endif
+
 __printf(2, 3)
 struct iio_trigger *iio_trigger_alloc(struct device *parent, const char *fmt, ...);
 void iio_trigger_free(struct iio_trigger *trig);
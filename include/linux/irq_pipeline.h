@@ -14,8 +14,10 @@ struct irq_desc;
 
 #ifdef CONFIG_IRQ_PIPELINE
 
+#include <linux/atomic.h>
 #include <linux/compiler.h>
 #include <linux/irqdomain.h>
+#include <linux/llist.h>
 #include <linux/percpu.h>
 #include <linux/interrupt.h>
 #include <linux/irqstage.h>
@@ -61,6 +63,9 @@ void irq_pipeline_oops(void);
 bool irq_cpuidle_enter(struct cpuidle_device *dev,
 		       struct cpuidle_state *state);
 
+ktime_t irq_cpuidle_oob_deadline(struct cpuidle_device *dev,
+				 s64 *slack_ns);
+
 int run_oob_call(int (*fn)(void *arg), void *arg);
 
 extern bool irq_pipeline_active;
@@ -90,6 +95,44 @@ void sync_inband_irqs(void);
 
 extern struct irq_domain *synthetic_irq_domain;
 
+/*
+ * Work relayed from any stage to the in-band stage of a given CPU.
+ * @func runs from in-band interrupt context on the target CPU, then
+ * @complete if set. The work is released once @complete returned, the
+ * relay does not refer to it anymore from that point. Posting the
+ * work again from @func or @complete queues it anew right after
+ * @complete returned.
+ *
+ * Posting to a remote CPU rings its doorbell from the in-band stage
+ * of the posting CPU, so the work only reaches its target after that
+ * stage got to run. There is no bound on such delay when posting from
+ * a CPU busy running oob threads, e.g. an isolated oob CPU.
+ */
+struct irq_relay_work {
+	struct llist_node llnode;
+	atomic_t pending;
+	u64 queued_at;
+	void (*func)(struct irq_relay_work *work);
+	void (*complete)(struct irq_relay_work *work);
+};
+
+static inline
+void init_irq_relay_work(struct irq_relay_work *work,
+			 void (*func)(struct irq_relay_work *work),
+			 void (*complete)(struct irq_relay_work *work))
+{
+	atomic_set(&work->pending, 0);
+	work->func = func;
+	work->complete = complete;
+}
+
+bool irq_relay_queue_on(struct irq_relay_work *work, int cpu);
+
+static inline bool irq_relay_queue(struct irq_relay_work *work)
+{
+	return irq_relay_queue_on(work, raw_smp_processor_id());
+}
+
 #else /* !CONFIG_IRQ_PIPELINE */
 
 #include <linux/irqstage.h>
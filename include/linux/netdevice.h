@@ -4337,6 +4337,8 @@ static inline void netif_disable_oob_diversion(struct net_device *dev)
 
 int netif_xmit_oob(struct sk_buff *skb);
 
+int netif_set_oob_filter(struct net_device *dev, int fd);
+
 static inline bool netdev_is_oob_capable(struct net_device *dev)
 {
 	return !!(dev->oob_context.flags & IFF_OOB_CAPABLE);
@@ -39,6 +39,9 @@ enum pstore_type_id {
 	PSTORE_TYPE_PMSG	= 7,
 	PSTORE_TYPE_PPC_OPAL	= 8,
 
+	/* Out-of-band stage event log */
+	PSTORE_TYPE_OOB		= 9,
+
 	/* End of the list */
 	PSTORE_TYPE_MAX
 };
@@ -121,6 +121,9 @@ ssize_t persistent_ram_ecc_string(struct persistent_ram_zone *prz,
  * Ramoops platform data
  * @mem_size	memory size for ramoops
  * @mem_address	physical memory address to contain ramoops
+ * @oob_size	total size of the oob event logs, split evenly between
+ *		CPUs, see ramoops_oob_write()
+ * @oob_ecc_size	ECC bytes for the oob event log only (0: use @ecc_info)
  */
 
 #define RAMOOPS_FLAG_FTRACE_PER_CPU	BIT(0)
@@ -133,9 +136,20 @@ struct ramoops_platform_data {
 	unsigned long	console_size;
 	unsigned long	ftrace_size;
 	unsigned long	pmsg_size;
+	unsigned long	oob_size;
+	int		oob_ecc_size;
 	int		max_reason;
 	u32		flags;
 	struct persistent_ram_ecc_info ecc_info;
 };
 
+#if IS_REACHABLE(CONFIG_PSTORE_RAM)
+int ramoops_oob_write(const void *buf, size_t len);
+#else
+static inline int ramoops_oob_write(const void *buf, size_t len)
+{
+	return -ENODEV;
+}
+#endif
+
 #endif
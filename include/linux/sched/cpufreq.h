@@ -35,4 +35,10 @@ static inline unsigned long map_util_perf(unsigned long util)
 }
 #endif /* CONFIG_CPU_FREQ */
 
+#ifdef CONFIG_CPU_FREQ_GOV_STAGEUTIL
+void cpufreq_update_oob_util(int cpu, unsigned long util);
+#else
+static inline void cpufreq_update_oob_util(int cpu, unsigned long util) { }
+#endif
+
 #endif /* _LINUX_SCHED_CPUFREQ_H */
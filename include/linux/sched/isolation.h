@@ -48,6 +48,43 @@ static inline void housekeeping_affine(struct task_struct *t,
 static inline void housekeeping_init(void) { }
 #endif /* CONFIG_CPU_ISOLATION */
 
+/**
+ * struct oob_cpu_intrusions - in-band activity still hitting an oob CPU
+ * @irqs:	in-band IRQs which may be delivered to the CPU
+ * @kthreads:	kthreads which may run on the CPU
+ * @tick:	the in-band tick keeps running while busy (not nohz_full)
+ * @timers:	timers may still be migrated to the CPU
+ * @rcu:	RCU callbacks are invoked on the CPU
+ * @unbound_wq:	unbound work items may run on the CPU
+ */
+struct oob_cpu_intrusions {
+	unsigned int irqs;
+	unsigned int kthreads;
+	bool tick;
+	bool timers;
+	bool rcu;
+	bool unbound_wq;
+};
+
+#if defined(CONFIG_CPU_ISOLATION) && defined(CONFIG_DOVETAIL)
+extern const struct cpumask *oob_cpu_partition(void);
+extern int oob_cpu_partition_set(const struct cpumask *cpumask);
+extern void oob_cpu_intrusions(int cpu, struct oob_cpu_intrusions *oi);
+#else
+static inline const struct cpumask *oob_cpu_partition(void)
+{
+	return cpu_none_mask;
+}
+
+static inline int oob_cpu_partition_set(const struct cpumask *cpumask)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline
+void oob_cpu_intrusions(int cpu, struct oob_cpu_intrusions *oi) { }
+#endif
+
 static inline bool housekeeping_cpu(int cpu, enum hk_flags flags)
 {
 #ifdef CONFIG_CPU_ISOLATION
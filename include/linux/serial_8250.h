@@ -139,6 +139,10 @@ struct uart_8250_port {
 	/* Serial port overrun backoff */
 	struct delayed_work overrun_backoff;
 	u32 overrun_backoff_time_ms;
+
+#ifdef CONFIG_SERIAL_CORE_OOB
+	unsigned char		oob_saved_ier;	/* in-band IER while in oob mode */
+#endif
 };
 
 static inline struct uart_8250_port *up_to_u8250p(struct uart_port *up)
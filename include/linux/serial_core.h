@@ -18,6 +18,9 @@
 #include <linux/mutex.h>
 #include <linux/sysrq.h>
 #include <uapi/linux/serial_core.h>
+#ifdef CONFIG_SERIAL_CORE_OOB
+#include <dovetail/poll.h>
+#endif
 
 #ifdef CONFIG_SERIAL_CORE_CONSOLE
 #define uart_console(port) \
@@ -80,6 +83,18 @@ struct uart_ops {
 	void		(*poll_put_char)(struct uart_port *, unsigned char);
 	int		(*poll_get_char)(struct uart_port *);
 #endif
+#ifdef CONFIG_SERIAL_CORE_OOB
+	/*
+	 * Switch the port to/from out-of-band mode, i.e. service it
+	 * from an IRQF_OOB handler feeding uart_oob_rx_chars() and
+	 * draining uart_oob_tx_chars(). oob_start_tx/oob_stop_tx are
+	 * called with the oob state lock held, hard irqs off.
+	 */
+	int		(*oob_enable)(struct uart_port *);
+	void		(*oob_disable)(struct uart_port *);
+	void		(*oob_start_tx)(struct uart_port *);
+	void		(*oob_stop_tx)(struct uart_port *);
+#endif
 };
 
 #define NO_POLL_CHAR		0x00ff0000
@@ -256,6 +271,10 @@ struct uart_port {
 	struct gpio_desc	*rs485_term_gpio;	/* enable RS485 bus termination */
 	struct serial_iso7816   iso7816;
 	void			*private_data;		/* generic platform data pointer */
+#ifdef CONFIG_SERIAL_CORE_OOB
+	struct uart_oob_state	*oob_state;		/* oob rings (serial core use only) */
+	bool			oob_active;		/* oob mode enabled */
+#endif
 };
 
 static inline int serial_port_in(struct uart_port *up, int offset)
@@ -445,6 +464,38 @@ static inline bool uart_softcts_mode(struct uart_port *uport)
 	return ((uport->status & mask) == UPSTAT_CTS_ENABLE);
 }
 
+#ifdef CONFIG_SERIAL_CORE_OOB
+
+/*
+ * Out-of-band mode state. Both rings are UART_XMIT_SIZE long and
+ * guarded by @lock, which may be taken from the oob stage.
+ */
+struct uart_oob_state {
+	hard_spinlock_t		lock;
+	struct circ_buf		rx;
+	struct circ_buf		tx;
+	struct oob_poll_head	poll;
+};
+
+static inline bool uart_oob_active(struct uart_port *port)
+{
+	return port && READ_ONCE(port->oob_active);
+}
+
+void uart_oob_rx_chars(struct uart_port *port, const unsigned char *buf,
+		       unsigned int count);
+unsigned int uart_oob_tx_chars(struct uart_port *port, unsigned char *buf,
+			       unsigned int count);
+
+#else
+
+static inline bool uart_oob_active(struct uart_port *port)
+{
+	return false;
+}
+
+#endif
+
 /*
  * The following are helper functions for the low level drivers.
  */
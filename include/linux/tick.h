@@ -27,6 +27,7 @@ int tick_install_proxy(void (*setup_proxy)(struct clock_proxy_device *dev),
 		const struct cpumask *cpumask);
 void tick_uninstall_proxy(const struct cpumask *cpumask);
 void tick_notify_proxy(void);
+unsigned long tick_proxy_relayed_ticks(int cpu);
 #endif
 
 #else /* CONFIG_GENERIC_CLOCKEVENTS */
@@ -296,6 +296,54 @@ extern void ktime_get_snapshot(struct system_time_snapshot *systime_snapshot);
 /* NMI safe mono/boot/realtime timestamps */
 extern void ktime_get_fast_timestamps(struct ktime_timestamps *snap);
 
+#ifdef CONFIG_DOVETAIL
+
+/**
+ * struct ktime_oob_snapshot - timekeeping data readable from the oob stage
+ * @clock:		Clocksource the snapshot is based on
+ * @cycle_last:		@clock counter value at the last timekeeper update
+ * @mask:		Bitmask for two's complement subtraction of @clock values
+ * @mult:		NTP adjusted multiplier for cycles to ns conversion
+ * @shift:		Shift value for cycles to ns conversion
+ * @xtime_nsec:		Shifted fractional nanoseconds at @cycle_last
+ * @base_mono:		CLOCK_MONOTONIC time at @cycle_last
+ * @offsets:		Offsets from CLOCK_MONOTONIC, indexed by enum tk_offsets
+ * @clock_was_set_seq:	The sequence number of clock was set events
+ *
+ * The time for any clock at counter value @cycles is given by:
+ *
+ *	base_mono + offsets[offs] +
+ *	(((cycles - cycle_last) & mask) * mult + xtime_nsec) >> shift
+ */
+struct ktime_oob_snapshot {
+	struct clocksource	*clock;
+	u64			cycle_last;
+	u64			mask;
+	u32			mult;
+	u32			shift;
+	u64			xtime_nsec;
+	ktime_t			base_mono;
+	ktime_t			offsets[TK_OFFS_MAX];
+	unsigned int		clock_was_set_seq;
+};
+
+/* Lockless timekeeping accessors, safe from the oob stage */
+extern void ktime_get_oob_snapshot(struct ktime_oob_snapshot *snap);
+extern u64 ktime_get_mono_oob_ns(void);
+extern u64 ktime_get_oob_ns_with_offset(enum tk_offsets offs);
+
+static inline u64 ktime_get_real_oob_ns(void)
+{
+	return ktime_get_oob_ns_with_offset(TK_OFFS_REAL);
+}
+
+static inline u64 ktime_get_clocktai_oob_ns(void)
+{
+	return ktime_get_oob_ns_with_offset(TK_OFFS_TAI);
+}
+
+#endif /* CONFIG_DOVETAIL */
+
 /*
  * Persistent clock related interfaces
  */
@@ -229,6 +229,16 @@
  *	Called when the device receives a TIOCGICOUNT ioctl. Passed a kernel
  *	structure to complete. This method is optional and will only be called
  *	if provided (otherwise ENOTTY will be returned).
+ *
+ * ssize_t (*oob_read)(struct tty_struct *tty, char __user *buf, size_t count);
+ * ssize_t (*oob_write)(struct tty_struct *tty, const char __user *buf,
+ *			size_t count);
+ * __poll_t (*oob_poll)(struct tty_struct *tty, struct oob_poll_wait *wait);
+ *
+ *	Out-of-band I/O on the tty, called from the oob stage with hard
+ *	interrupts possibly enabled. These must never sleep nor take any
+ *	regular lock, and return -EAGAIN instead of blocking. Optional:
+ *	-EOPNOTSUPP is returned if not provided.
  */
 
 #include <linux/export.h>
@@ -288,6 +298,12 @@ struct tty_operations {
 	void (*poll_put_char)(struct tty_driver *driver, int line, char ch);
 #endif
 	int (*proc_show)(struct seq_file *, void *);
+	ssize_t (*oob_read)(struct tty_struct *tty, char __user *buf,
+			    size_t count);
+	ssize_t (*oob_write)(struct tty_struct *tty, const char __user *buf,
+			     size_t count);
+	__poll_t (*oob_poll)(struct tty_struct *tty,
+			     struct oob_poll_wait *wait);
 } __randomize_layout;
 
 struct tty_driver {
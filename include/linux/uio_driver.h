@@ -16,6 +16,10 @@
 #include <linux/device.h>
 #include <linux/fs.h>
 #include <linux/interrupt.h>
+#include <linux/irq_work.h>
+#ifdef CONFIG_UIO_OOB
+#include <dovetail/poll.h>
+#endif
 
 struct module;
 struct uio_map;
@@ -77,6 +81,12 @@ struct uio_device {
 	struct mutex		info_lock;
 	struct kobject          *map_dir;
 	struct kobject          *portio_dir;
+#ifdef CONFIG_UIO_OOB
+	hard_spinlock_t		oob_lock;
+	struct uio_info		*oob_info;
+	struct irq_work		wake_work;
+	struct oob_poll_head	oob_poll;
+#endif
 };
 
 /**
@@ -94,6 +104,11 @@ struct uio_device {
  * @open:		open operation for this uio device
  * @release:		release operation for this uio device
  * @irqcontrol:		disable/enable irqs when 0/1 is written to /dev/uioX
+ *
+ * With CONFIG_UIO_OOB, passing IRQF_OOB in @irq_flags has the interrupt
+ * handled from the out-of-band stage, in which case @handler and
+ * @irqcontrol must be oob-safe. Events may then be waited for and
+ * @irqcontrol be called by out-of-band threads too.
  */
 struct uio_info {
 	struct uio_device	*uio_dev;
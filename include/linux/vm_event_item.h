@@ -128,6 +128,10 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 #ifdef CONFIG_X86
 		DIRECT_MAP_LEVEL2_SPLIT,
 		DIRECT_MAP_LEVEL3_SPLIT,
+#endif
+#ifdef CONFIG_DOVETAIL
+		PGFAULT_OOB,
+		PGMIGRATE_FENCED,
 #endif
 		NR_VM_EVENT_ITEMS
 };
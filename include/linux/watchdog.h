@@ -13,6 +13,7 @@
 #include <linux/bitops.h>
 #include <linux/cdev.h>
 #include <linux/device.h>
+#include <linux/irq_work.h>
 #include <linux/kernel.h>
 #include <linux/notifier.h>
 #include <uapi/linux/watchdog.h>
@@ -34,6 +35,9 @@ struct watchdog_governor;
  * @get_timeleft:The routine that gets the time left before a reset (in seconds).
  * @restart:	The routine for restarting the machine.
  * @ioctl:	The routines that handles extra ioctl calls.
+ * @oob_ping:	The routine that sends a keepalive ping to the watchdog device
+ *		from the out-of-band stage. It must neither sleep nor grab
+ *		any in-band lock.
  *
  * The watchdog_ops structure contains a list of low-level operations
  * that control a watchdog device. It also contains the module that owns
@@ -53,6 +57,7 @@ struct watchdog_ops {
 	unsigned int (*get_timeleft)(struct watchdog_device *);
 	int (*restart)(struct watchdog_device *, unsigned long, void *);
 	long (*ioctl)(struct watchdog_device *, unsigned int, unsigned long);
+	int (*oob_ping)(struct watchdog_device *);
 };
 
 /** struct watchdog_device - The structure that defines a watchdog device
@@ -84,6 +89,9 @@ struct watchdog_ops {
  * @status:	Field that contains the devices internal status bits.
  * @deferred:	Entry in wtd_deferred_reg_list which is used to
  *		register early initialized watchdogs.
+ * @pretimeout_work:
+ *		Relays pretimeout events raised from the oob stage to the
+ *		in-band stage.
  *
  * The watchdog_device structure contains all information about a
  * watchdog timer device.
@@ -117,6 +125,9 @@ struct watchdog_device {
 #define WDOG_HW_RUNNING		3	/* True if HW watchdog running */
 #define WDOG_STOP_ON_UNREGISTER	4	/* Should be stopped on unregister */
 	struct list_head deferred;
+#ifdef CONFIG_WATCHDOG_OOB
+	struct irq_work pretimeout_work;
+#endif
 };
 
 #define WATCHDOG_NOWAYOUT		IS_BUILTIN(CONFIG_WATCHDOG_NOWAYOUT)
@@ -203,6 +214,19 @@ static inline void watchdog_notify_pretimeout(struct watchdog_device *wdd)
 }
 #endif
 
+/*
+ * Use the following function to report a pretimeout event from an
+ * interrupt handler which may run on the out-of-band stage (IRQF_OOB).
+ */
+#ifdef CONFIG_WATCHDOG_OOB
+void watchdog_notify_pretimeout_oob(struct watchdog_device *wdd);
+#else
+static inline void watchdog_notify_pretimeout_oob(struct watchdog_device *wdd)
+{
+	watchdog_notify_pretimeout(wdd);
+}
+#endif
+
 /* drivers/watchdog/watchdog_core.c */
 void watchdog_set_restart_priority(struct watchdog_device *wdd, int priority);
 extern int watchdog_init_timeout(struct watchdog_device *wdd,
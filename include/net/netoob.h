@@ -9,8 +9,11 @@
 /* Device is an out-of-band port */
 #define IFF_OOB_PORT		BIT(1)
 
+struct bpf_prog;
+
 struct oob_netdev_context {
 	int flags;
+	struct bpf_prog __rcu *filter;
 	struct oob_netdev_state dev_state;
 };
 
@@ -0,0 +1,102 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM dovetail
+
+#if !defined(_TRACE_DOVETAIL_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_DOVETAIL_H
+
+#include <linux/tracepoint.h>
+#include <linux/sched.h>
+
+/*
+ * These events may be hit from the out-of-band stage. BPF programs
+ * attached to them must have been loaded with BPF_F_OOB to run there.
+ */
+
+DECLARE_EVENT_CLASS(dovetail_stage_switch,
+
+	TP_PROTO(struct task_struct *p),
+
+	TP_ARGS(p),
+
+	TP_STRUCT__entry(
+		__array(	char,	comm,	TASK_COMM_LEN	)
+		__field(	pid_t,	pid			)
+	),
+
+	TP_fast_assign(
+		memcpy(__entry->comm, p->comm, TASK_COMM_LEN);
+		__entry->pid = p->pid;
+	),
+
+	TP_printk("comm=%s pid=%d", __entry->comm, __entry->pid)
+);
+
+/**
+ * dovetail_leave_inband - called when a task resumes on the oob stage
+ * @p: the task moving out-of-band
+ */
+DEFINE_EVENT(dovetail_stage_switch, dovetail_leave_inband,
+
+	TP_PROTO(struct task_struct *p),
+
+	TP_ARGS(p)
+);
+
+/**
+ * dovetail_resume_inband - called when a task resumes on the in-band stage
+ * @p: the task moving back in-band
+ */
+DEFINE_EVENT(dovetail_stage_switch, dovetail_resume_inband,
+
+	TP_PROTO(struct task_struct *p),
+
+	TP_ARGS(p)
+);
+
+/**
+ * oob_syscall_entry - called before an oob syscall is handed to the core
+ * @nr: syscall number as issued by the caller
+ */
+TRACE_EVENT(oob_syscall_entry,
+
+	TP_PROTO(unsigned int nr),
+
+	TP_ARGS(nr),
+
+	TP_STRUCT__entry(
+		__field(	unsigned int,	nr	)
+	),
+
+	TP_fast_assign(
+		__entry->nr = nr;
+	),
+
+	TP_printk("nr=%#x", __entry->nr)
+);
+
+/**
+ * oob_syscall_exit - called when the core is done with an oob syscall
+ * @ret: value returned to the caller
+ */
+TRACE_EVENT(oob_syscall_exit,
+
+	TP_PROTO(long ret),
+
+	TP_ARGS(ret),
+
+	TP_STRUCT__entry(
+		__field(	long,	ret	)
+	),
+
+	TP_fast_assign(
+		__entry->ret = ret;
+	),
+
+	TP_printk("ret=%ld", __entry->ret)
+);
+
+#endif /* _TRACE_DOVETAIL_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
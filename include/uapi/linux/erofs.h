@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+#ifndef _UAPI_LINUX_EROFS_H
+#define _UAPI_LINUX_EROFS_H
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+/*
+ * erofs-specific ioctl commands
+ */
+#define EROFS_IOCTL_MAGIC		0xe2
+
+/*
+ * Pin the whole (decompressed) contents of a regular file in the
+ * page cache, enabling out-of-band reads through this file
+ * descriptor.  The pin is released on last close.
+ */
+#define EROFS_IOC_OOB_PIN		_IO(EROFS_IOCTL_MAGIC, 1)
+
+/* Positional read from the out-of-band stage (oob_ioctl only). */
+#define EROFS_IOC_OOB_PREAD		_IOWR(EROFS_IOCTL_MAGIC, 2,	\
+						struct erofs_oob_pread)
+
+struct erofs_oob_pread {
+	__u64 offset;		/* file offset to read from */
+	__u64 buf;		/* user buffer address */
+	__u64 len;		/* in: buffer length, out: bytes read */
+};
+
+#endif /* _UAPI_LINUX_EROFS_H */
@@ -5,6 +5,51 @@
 #ifndef _UAPI_IIO_BUFFER_H_
 #define _UAPI_IIO_BUFFER_H_
 
+#include <linux/types.h>
+
+/* Flags for struct iio_buffer_block */
+#define IIO_BUFFER_BLOCK_FLAG_OVERRUN		(1 << 0)
+
+/**
+ * struct iio_buffer_block_alloc_req - Descriptor for allocating IIO DMA blocks
+ * @type:	Reserved, must be 0
+ * @size:	Size of each block in bytes
+ * @count:	Number of blocks to allocate
+ * @id:		Reserved, must be 0
+ */
+struct iio_buffer_block_alloc_req {
+	__u32 type;
+	__u32 size;
+	__u32 count;
+	__u32 id;
+};
+
+/**
+ * struct iio_buffer_block - Descriptor for a single IIO DMA block
+ * @id:		Block id, in the [0, count) range
+ * @size:	Size of the block in bytes
+ * @bytes_used:	Number of bytes holding valid data
+ * @flags:	Bitmask of IIO_BUFFER_BLOCK_FLAG_*
+ * @offset:	Offset of the block data in the buffer mapping
+ * @seq:	Completion sequence number, counting from 0 when the
+ *		buffer is enabled
+ * @timestamp:	CLOCK_MONOTONIC time of completion in nanoseconds
+ */
+struct iio_buffer_block {
+	__u32 id;
+	__u32 size;
+	__u32 bytes_used;
+	__u32 flags;
+	__u32 offset;
+	__u32 seq;
+	__u64 timestamp;
+};
+
 #define IIO_BUFFER_GET_FD_IOCTL			_IOWR('i', 0x91, int)
+#define IIO_BUFFER_BLOCK_ALLOC_IOCTL		_IOW('i', 0xa0, struct iio_buffer_block_alloc_req)
+#define IIO_BUFFER_BLOCK_FREE_IOCTL		_IO('i',  0xa1)
+#define IIO_BUFFER_BLOCK_QUERY_IOCTL		_IOWR('i', 0xa2, struct iio_buffer_block)
+#define IIO_BUFFER_BLOCK_ENQUEUE_IOCTL		_IOW('i', 0xa3, struct iio_buffer_block)
+#define IIO_BUFFER_BLOCK_DEQUEUE_IOCTL		_IOR('i', 0xa4, struct iio_buffer_block)
 
 #endif /* _UAPI_IIO_BUFFER_H_ */
@@ -12,6 +12,7 @@
 #define _UAPI_LINUX_SERIAL_H
 
 #include <linux/types.h>
+#include <linux/ioctl.h>
 
 #include <linux/tty_flags.h>
 
@@ -2,6 +2,7 @@
 #include <linux/btf.h>
 #include <linux/err.h>
 #include <linux/irq_work.h>
+#include <linux/irqstage.h>
 #include <linux/slab.h>
 #include <linux/filter.h>
 #include <linux/mm.h>
@@ -36,7 +37,13 @@ struct bpf_ringbuf {
 	u64 mask;
 	struct page **pages;
 	int nr_pages;
-	spinlock_t spinlock ____cacheline_aligned_in_smp;
+	/*
+	 * Producers may run on the out-of-band stage, which virtually
+	 * disabling irqs would not keep away. Reservation is short
+	 * enough to be done with hard irqs off.
+	 */
+	hard_spinlock_t spinlock ____cacheline_aligned_in_smp;
+	atomic_long_t dropped;
 	/* Consumer and producer counters are put into separate pages to allow
 	 * mapping consumer page as r/w, but restrict producer page to r/o.
 	 * This protects producer position from being modified by user-space
@@ -134,13 +141,14 @@ static struct bpf_ringbuf *bpf_ringbuf_alloc(size_t data_sz, int numa_node)
 	if (!rb)
 		return NULL;
 
-	spin_lock_init(&rb->spinlock);
+	raw_spin_lock_init(&rb->spinlock);
 	init_waitqueue_head(&rb->waitq);
 	init_irq_work(&rb->work, bpf_ringbuf_notify);
 
 	rb->mask = data_sz - 1;
 	rb->consumer_pos = 0;
 	rb->producer_pos = 0;
+	atomic_long_set(&rb->dropped, 0);
 
 	return rb;
 }
@@ -317,11 +325,19 @@ static void *__bpf_ringbuf_reserve(struct bpf_ringbuf *rb, u64 size)
 
 	cons_pos = smp_load_acquire(&rb->consumer_pos);
 
-	if (in_nmi()) {
-		if (!spin_trylock_irqsave(&rb->spinlock, flags))
+	/*
+	 * NMI and oob producers never wait for the lock, the record
+	 * is dropped instead: the holder might be the context they
+	 * preempted, and oob callers must not be delayed by in-band
+	 * ones.
+	 */
+	if (in_nmi() || running_oob()) {
+		if (!raw_spin_trylock_irqsave(&rb->spinlock, flags)) {
+			atomic_long_inc(&rb->dropped);
 			return NULL;
+		}
 	} else {
-		spin_lock_irqsave(&rb->spinlock, flags);
+		raw_spin_lock_irqsave(&rb->spinlock, flags);
 	}
 
 	prod_pos = rb->producer_pos;
@@ -331,7 +347,7 @@ static void *__bpf_ringbuf_reserve(struct bpf_ringbuf *rb, u64 size)
 	 * doesn't advance more than (ringbuf_size - 1) ahead
 	 */
 	if (new_prod_pos - cons_pos > rb->mask) {
-		spin_unlock_irqrestore(&rb->spinlock, flags);
+		raw_spin_unlock_irqrestore(&rb->spinlock, flags);
 		return NULL;
 	}
 
@@ -343,7 +359,7 @@ static void *__bpf_ringbuf_reserve(struct bpf_ringbuf *rb, u64 size)
 	/* pairs with consumer's smp_load_acquire() */
 	smp_store_release(&rb->producer_pos, new_prod_pos);
 
-	spin_unlock_irqrestore(&rb->spinlock, flags);
+	raw_spin_unlock_irqrestore(&rb->spinlock, flags);
 
 	return (void *)hdr + BPF_RINGBUF_HDR_SZ;
 }
@@ -464,6 +480,8 @@ BPF_CALL_2(bpf_ringbuf_query, struct bpf_map *, map, u64, flags)
 		return smp_load_acquire(&rb->consumer_pos);
 	case BPF_RB_PROD_POS:
 		return smp_load_acquire(&rb->producer_pos);
+	case BPF_RB_DROPPED:
+		return atomic_long_read(&rb->dropped);
 	default:
 		return 0;
 	}
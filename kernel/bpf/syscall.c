@@ -2092,9 +2092,22 @@ static int bpf_prog_load(union bpf_attr *attr, union bpf_attr __user *uattr)
 				 BPF_F_ANY_ALIGNMENT |
 				 BPF_F_TEST_STATE_FREQ |
 				 BPF_F_SLEEPABLE |
+				 BPF_F_OOB |
 				 BPF_F_TEST_RND_HI32))
 		return -EINVAL;
 
+	/*
+	 * Only raw tracepoints and oob receive filters may run on the
+	 * out-of-band stage.
+	 */
+	if ((attr->prog_flags & BPF_F_OOB) &&
+	    (!IS_ENABLED(CONFIG_IRQ_PIPELINE) ||
+	     (type != BPF_PROG_TYPE_RAW_TRACEPOINT &&
+	      type != BPF_PROG_TYPE_SCHED_CLS &&
+	      !(type == BPF_PROG_TYPE_TRACING &&
+		attr->expected_attach_type == BPF_TRACE_RAW_TP))))
+		return -EINVAL;
+
 	if (!IS_ENABLED(CONFIG_HAVE_EFFICIENT_UNALIGNED_ACCESS) &&
 	    (attr->prog_flags & BPF_F_ANY_ALIGNMENT) &&
 	    !bpf_capable())
@@ -2177,6 +2190,7 @@ static int bpf_prog_load(union bpf_attr *attr, union bpf_attr __user *uattr)
 	prog->aux->dst_prog = dst_prog;
 	prog->aux->offload_requested = !!attr->prog_ifindex;
 	prog->aux->sleepable = attr->prog_flags & BPF_F_SLEEPABLE;
+	prog->aux->oob = attr->prog_flags & BPF_F_OOB;
 
 	err = security_bpf_prog_alloc(prog->aux);
 	if (err)
@@ -7,10 +7,15 @@
 #include <linux/sched/signal.h>
 #include <linux/irq_pipeline.h>
 #include <linux/dovetail.h>
+#include <linux/ksm.h>
+#include <linux/mman.h>
 #include <asm/unistd.h>
 #include <asm/syscall.h>
 #include <uapi/asm-generic/dovetail.h>
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/dovetail.h>
+
 static bool dovetail_enabled;
 
 void __weak arch_inband_task_init(struct task_struct *p)
@@ -51,6 +56,53 @@ void dovetail_init_altsched(struct dovetail_altsched_context *p)
 }
 EXPORT_SYMBOL_GPL(dovetail_init_altsched);
 
+/**
+ * dovetail_prefault_mm - pin the address space of the current process
+ *
+ * Lock all current and future mappings in memory and populate their
+ * page tables, breaking COW and KSM sharing on the way, so that oob
+ * threads of a dovetailed process do not fault when touching memory
+ * for the first time. The same limits as mlockall() apply. Faults
+ * taken from the oob stage are still counted as pgfault_oob in
+ * /proc/vmstat.
+ *
+ * Returns 0 on success, -ENOSYS if CONFIG_MMU is off, another negative
+ * error code otherwise.
+ */
+int dovetail_prefault_mm(void)
+{
+	struct mm_struct *mm = current->mm;
+	struct vm_area_struct *vma;
+	int ret = 0;
+
+	check_inband_stage();
+
+	/* mlockall() is not available without a MMU. */
+	if (!IS_ENABLED(CONFIG_MMU))
+		return -ENOSYS;
+
+	if (!mm || (current->flags & PF_KTHREAD))
+		return -EINVAL;
+
+	if (mmap_write_lock_killable(mm))
+		return -EINTR;
+
+	for (vma = mm->mmap; vma; vma = vma->vm_next) {
+		ret = ksm_madvise(vma, vma->vm_start, vma->vm_end,
+				  MADV_UNMERGEABLE, &vma->vm_flags);
+		if (ret)
+			break;
+	}
+
+	mmap_write_unlock(mm);
+
+	if (ret)
+		return ret;
+
+	return do_mlockall(MCL_CURRENT | MCL_FUTURE);
+}
+EXPORT_SYMBOL_GPL(dovetail_prefault_mm);
+
 void dovetail_start_altsched(void)
 {
 	check_inband_stage();
@@ -100,6 +152,7 @@ void dovetail_call_mayday(struct pt_regs *regs)
 	call_mayday(ti, regs);
 	hard_local_irq_restore(flags);
 }
+EXPORT_SYMBOL_GPL(dovetail_call_mayday);
 
 void inband_retuser_notify(void)
 {
@@ -209,7 +262,9 @@ int pipeline_syscall(unsigned int nr, struct pt_regs *regs)
 	 */
 
 	if ((nr & __OOB_SYSCALL_BIT) && (local_flags & _TLF_OOB)) {
+		trace_oob_syscall_entry(nr);
 		handle_oob_syscall(regs);
+		trace_oob_syscall_exit(syscall_get_return_value(current, regs));
 		local_flags = READ_ONCE(ti_local_flags(ti));
 		if (local_flags & _TLF_OOB) {
 			if (test_ti_thread_flag(ti, TIF_MAYDAY))
@@ -259,6 +314,7 @@ noinstr void __oob_trap_notify(unsigned int exception,
 		hard_local_irq_restore(flags);
 	}
 }
+EXPORT_SYMBOL_GPL(__oob_trap_notify);
 
 void __weak handle_oob_trap_exit(unsigned int trapnr, struct pt_regs *regs)
 {
@@ -278,6 +334,7 @@ noinstr void __oob_trap_unwind(unsigned int exception, struct pt_regs *regs)
 	handle_oob_trap_exit(exception, regs);
 	instrumentation_end();
 }
+EXPORT_SYMBOL_GPL(__oob_trap_unwind);
 
 extern void rust_handle_inband_event(enum inband_event_type event, void *data);
 
@@ -419,6 +476,47 @@ void __weak replace_inband_fd(unsigned int fd, struct file *file,
 {
 }
 
+/*
+ * Out-of-band poll heads: drivers call oob_poll_watch() from their
+ * oob_poll() handler, and oob_poll_signal() from the oob stage when
+ * the watched condition changes. The companion core provides the
+ * actual wait logic, oob_poll() callers just get the current
+ * readiness bits otherwise.
+ */
+void __weak oob_poll_head_init(struct oob_poll_head *head)
+{
+}
+EXPORT_SYMBOL_GPL(oob_poll_head_init);
+
+void __weak oob_poll_head_destroy(struct oob_poll_head *head)
+{
+}
+EXPORT_SYMBOL_GPL(oob_poll_head_destroy);
+
+void __weak oob_poll_watch(struct oob_poll_head *head,
+			   struct oob_poll_wait *wait)
+{
+}
+EXPORT_SYMBOL_GPL(oob_poll_watch);
+
+void __weak oob_poll_signal(struct oob_poll_head *head, __poll_t events)
+{
+}
+EXPORT_SYMBOL_GPL(oob_poll_signal);
+
+/*
+ * Tells whether @cpu currently has runnable oob threads. In-band
+ * background activities contending with the oob stage for shared
+ * resources such as the memory bus may use this hint to back off.
+ * The companion core knows better, we have no oob activity to
+ * report otherwise.
+ */
+bool __weak oob_cpu_busy(int cpu)
+{
+	return false;
+}
+EXPORT_SYMBOL_GPL(oob_cpu_busy);
+
 int dovetail_start(void)
 {
 	check_inband_stage();
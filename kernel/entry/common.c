@@ -161,6 +161,7 @@ static __always_inline void __exit_to_user_mode(void)
 	instrumentation_begin();
 	trace_hardirqs_on_prepare();
 	lockdep_hardirqs_on_prepare(CALLER_ADDR0);
+	hard_irqsoff_trace_end();
 	instrumentation_end();
 
 	user_enter_irqoff();
@@ -23,7 +23,6 @@
 
 static void torture_event_handler(struct clock_event_device *dev)
 {
-	pr_info("tick test!!!");
 	/*
 	 * We are running on the oob stage, in NMI-like mode. Schedule
 	 * a tick on the proxy device to satisfy the corresponding
@@ -47,6 +46,46 @@ static void stop_tick_takeover_test(void)
 	tick_uninstall_proxy(cpu_online_mask);
 }
 
+/*
+ * Measure the rate of in-band ticks relayed by the proxy device over
+ * one second on every CPU running in full nohz mode. Such a CPU is
+ * expected to be as good as tickless for the in-band stage, at most a
+ * few timer events may be relayed while the in-band stage idles. The
+ * test fails if any of them still ticks at HZ/2 or more.
+ */
+static int test_tickless_proxy(void)
+{
+	unsigned long *count, delta;
+	int cpu, ret = 0;
+
+	if (!tick_nohz_full_enabled())
+		return 0;
+
+	count = kcalloc(nr_cpu_ids, sizeof(*count), GFP_KERNEL);
+	if (WARN_ON(!count))
+		return -ENOMEM;
+
+	for_each_online_cpu(cpu)
+		count[cpu] = tick_proxy_relayed_ticks(cpu);
+
+	msleep(1000);
+
+	for_each_online_cpu(cpu) {
+		if (!tick_nohz_full_cpu(cpu))
+			continue;
+		delta = tick_proxy_relayed_ticks(cpu) - count[cpu];
+		pr_alert("irq_pipeline" TORTURE_FLAG
+			 " CPU%d: %lu in-band ticks relayed in 1s%s\n",
+			 cpu, delta, delta >= HZ / 2 ? ", NOT tickless!" : "");
+		if (delta >= HZ / 2)
+			ret = -EINVAL;
+	}
+
+	kfree(count);
+
+	return ret;
+}
+
 struct stop_machine_p_data {
 	int origin_cpu;
 	cpumask_var_t disable_mask;
@@ -243,8 +282,10 @@ static int __init irqp_torture_init(void)
 		goto out;
 
 	ret = test_interstage_work_injection();
-	if (!ret)
+	if (!ret) {
 		msleep(1000);
+		ret = test_tickless_proxy();
+	}
 
 	stop_tick_takeover_test();
 out:
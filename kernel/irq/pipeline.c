@@ -12,7 +12,11 @@
 #include <linux/irq_work.h>
 #include <linux/jhash.h>
 #include <linux/debug_locks.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/timekeeping.h>
 #include <linux/dovetail.h>
+#include <linux/ftrace_irq.h>
 #include <dovetail/irq.h>
 #include <trace/events/irq.h>
 #include "internals.h"
@@ -1105,6 +1109,12 @@ struct irq_stage_data *handle_irq_pipelined_prepare(struct pt_regs *regs)
 		WARN_ON(on_pipeline_entry());
 	}
 
+	/*
+	 * Taking an IRQ means that hard irqs were on, any pending
+	 * hard irqs off section was closed behind our back.
+	 */
+	hard_irqsoff_trace_discard();
+
 	/*
 	 * Switch early on to the out-of-band stage if present,
 	 * anticipating a companion kernel is going to handle the
@@ -1276,6 +1286,7 @@ void sync_current_irq_stage(void) /* hard irqs off */
 		 */
 		stall_inband_nocheck();
 		trace_hardirqs_off();
+		ftrace_inband_replay_enter();
 	} else {
 		stall_oob();
 	}
@@ -1320,6 +1331,7 @@ void sync_current_irq_stage(void) /* hard irqs off */
 	}
 
 	if (stage == &inband_stage) {
+		ftrace_inband_replay_exit();
 		trace_hardirqs_on();
 		unstall_inband_nocheck();
 	} else {
@@ -1550,6 +1562,27 @@ bool __weak irq_cpuidle_control(struct cpuidle_device *dev,
 	return true;
 }
 
+/**
+ *	irq_cpuidle_oob_deadline - Tell when the oob stage needs the CPU
+ *	@dev: CPUIDLE device of the idling CPU
+ *	@slack_ns: set to the exit latency the oob stage may absorb
+ *
+ *	Called by the cpuidle governors before they pick an idle
+ *	state. A companion core overrides this routine in order to
+ *	return the expiry date of the next oob timer on the current CPU
+ *	(CLOCK_MONOTONIC), along with the exit latency it can tolerate
+ *	for that event, e.g. how early it programmed the timer hardware
+ *	to compensate for wake-up latencies. KTIME_MAX means that no
+ *	oob timer is pending.
+ */
+ktime_t __weak irq_cpuidle_oob_deadline(struct cpuidle_device *dev,
+					s64 *slack_ns)
+{
+	*slack_ns = S64_MAX;
+
+	return KTIME_MAX;
+}
+
 /**
  *	irq_cpuidle_enter - Prepare for entering the next idle state
  *	@dev: CPUIDLE device
@@ -1582,7 +1615,13 @@ bool irq_cpuidle_enter(struct cpuidle_device *dev,
 		return false;
 	}
 
-	return irq_cpuidle_control(dev, state);
+	if (!irq_cpuidle_control(dev, state))
+		return false;
+
+	/* Idling with hard irqs off does not count as latency. */
+	hard_irqsoff_trace_discard();
+
+	return true;
 }
 
 static unsigned int inband_work_sirq;
@@ -1618,6 +1657,215 @@ void irq_local_work_raise(void)
 	hard_local_irq_restore(flags);
 }
 
+/*
+ * The in-band relay: per-CPU lockless queues of irq_relay_work which
+ * any CPU may feed from any stage. The doorbell is rung only when a
+ * queue goes from empty to non-empty, so a burst of posts costs a
+ * single synthetic IRQ. Since there is no spare oob IPI to kick a
+ * remote CPU with, a remote doorbell is rung locally first, then
+ * forwarded by an in-band IPI once the local in-band stage runs,
+ * which may take arbitrarily long on a CPU running oob threads.
+ *
+ * The pending state of a work tells whether it is idle, queued or
+ * running. A work posted again while running records the CPU it was
+ * posted to, and is queued there once complete.
+ */
+#define IRQ_RELAY_IDLE		0
+#define IRQ_RELAY_QUEUED	1
+#define IRQ_RELAY_RUNNING	2
+#define IRQ_RELAY_REPOSTED	3	/* + target CPU */
+
+struct irq_relay_queue {
+	struct llist_head list;
+	atomic_t depth;
+	unsigned int max_batch;
+	unsigned long runs;
+	unsigned long batches;
+	u64 total_latency;
+	u64 max_latency;
+} ____cacheline_aligned_in_smp;
+
+static DEFINE_PER_CPU(struct irq_relay_queue, irq_relay_queues);
+
+static DEFINE_PER_CPU(struct cpumask, irq_relay_kicks);
+
+static DEFINE_PER_CPU(struct irq_work, irq_relay_kick_work);
+
+static unsigned int irq_relay_sirq;
+
+/*
+ * Run the works queued to @q, accounting for them in @acct. The stats
+ * are not shared, so they must belong to the current CPU.
+ */
+static void irq_relay_run(struct irq_relay_queue *q,
+			  struct irq_relay_queue *acct)
+{
+	struct irq_relay_work *work, *tmp;
+	struct llist_node *list;
+	unsigned int count = 0;
+	u64 now, latency;
+	int state;
+
+	list = llist_del_all(&q->list);
+	if (list == NULL)
+		return;
+
+	now = ktime_get_mono_fast_ns();
+	list = llist_reverse_order(list);
+
+	llist_for_each_entry_safe(work, tmp, list, llnode) {
+		latency = now - work->queued_at;
+		acct->total_latency += latency;
+		if (latency > acct->max_latency)
+			acct->max_latency = latency;
+		atomic_set(&work->pending, IRQ_RELAY_RUNNING);
+		work->func(work);
+		if (work->complete)
+			work->complete(work);
+		count++;
+		/* Release the work, unless it was posted again meanwhile. */
+		state = atomic_cmpxchg_release(&work->pending,
+					       IRQ_RELAY_RUNNING, IRQ_RELAY_IDLE);
+		if (state != IRQ_RELAY_RUNNING) {
+			atomic_set(&work->pending, IRQ_RELAY_IDLE);
+			irq_relay_queue_on(work, state - IRQ_RELAY_REPOSTED);
+		}
+	}
+
+	atomic_sub(count, &q->depth);
+	acct->runs += count;
+	acct->batches++;
+	if (count > acct->max_batch)
+		acct->max_batch = count;
+}
+
+static void irq_relay_kick(struct irq_work *work)
+{
+	struct irq_relay_queue *q = this_cpu_ptr(&irq_relay_queues);
+
+	irq_relay_run(q, q);
+}
+
+static irqreturn_t irq_relay_interrupt(int sirq, void *dev_id)
+{
+	struct irq_relay_queue *q = this_cpu_ptr(&irq_relay_queues);
+	struct cpumask *kicks = this_cpu_ptr(&irq_relay_kicks);
+	int cpu;
+
+	irq_relay_run(q, q);
+
+	for_each_cpu(cpu, kicks) {
+		if (!cpumask_test_and_clear_cpu(cpu, kicks))
+			continue;
+		/* Don't leave work stranded on a dead CPU. */
+		if (cpu_online(cpu))
+			irq_work_queue_on(&per_cpu(irq_relay_kick_work, cpu), cpu);
+		else
+			irq_relay_run(per_cpu_ptr(&irq_relay_queues, cpu), q);
+	}
+
+	return IRQ_HANDLED;
+}
+
+static struct irqaction inband_relay = {
+	.handler = irq_relay_interrupt,
+	.name = "in-band relay",
+	.flags = IRQF_NO_THREAD,
+};
+
+static void irq_relay_ring(int cpu)
+{
+	unsigned long flags;
+
+	flags = hard_local_irq_save();
+
+	if (cpu != raw_smp_processor_id())
+		cpumask_set_cpu(cpu, this_cpu_ptr(&irq_relay_kicks));
+
+	irq_post_inband(irq_relay_sirq);
+	if (running_inband() &&
+	    !hard_irqs_disabled_flags(flags) && !irqs_disabled())
+		sync_current_irq_stage();
+
+	hard_local_irq_restore(flags);
+}
+
+/**
+ *	irq_relay_queue_on - post a relay work to the in-band stage of a CPU
+ *	@work: the work to run
+ *	@cpu: the CPU to run it on
+ *
+ *	May be called from any stage, with hard irqs on or off. Works
+ *	are run in posting order per CPU. Returns false if @work was
+ *	pending already, in which case it runs once only. If @work is
+ *	running, it is queued again once its completion handler returned.
+ *
+ *	A remote @cpu is only notified once the in-band stage of the
+ *	posting CPU runs.
+ */
+bool irq_relay_queue_on(struct irq_relay_work *work, int cpu)
+{
+	struct irq_relay_queue *q = per_cpu_ptr(&irq_relay_queues, cpu);
+	int state;
+
+	for (;;) {
+		state = atomic_cmpxchg(&work->pending,
+				       IRQ_RELAY_IDLE, IRQ_RELAY_QUEUED);
+		if (state == IRQ_RELAY_IDLE)
+			break;
+		if (state != IRQ_RELAY_RUNNING)
+			return false;
+		if (atomic_cmpxchg(&work->pending, IRQ_RELAY_RUNNING,
+				   IRQ_RELAY_REPOSTED + cpu) == IRQ_RELAY_RUNNING)
+			return true;
+	}
+
+	work->queued_at = ktime_get_mono_fast_ns();
+	atomic_inc(&q->depth);
+
+	if (llist_add(&work->llnode, &q->list))
+		irq_relay_ring(cpu);
+
+	return true;
+}
+EXPORT_SYMBOL_GPL(irq_relay_queue_on);
+
+#ifdef CONFIG_DEBUG_FS
+
+static int irq_relay_stats_show(struct seq_file *m, void *v)
+{
+	struct irq_relay_queue *q;
+	unsigned long runs;
+	int cpu;
+
+	seq_puts(m, "CPU      DEPTH  MAXBATCH        RUNS     BATCHES"
+		 "   AVGLAT(ns)   MAXLAT(ns)\n");
+
+	for_each_online_cpu(cpu) {
+		q = per_cpu_ptr(&irq_relay_queues, cpu);
+		runs = READ_ONCE(q->runs);
+		seq_printf(m, "%3d %10d %9u %11lu %11lu %12llu %12llu\n",
+			   cpu, atomic_read(&q->depth),
+			   READ_ONCE(q->max_batch), runs,
+			   READ_ONCE(q->batches),
+			   runs ? div64_u64(READ_ONCE(q->total_latency), runs) : 0,
+			   READ_ONCE(q->max_latency));
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(irq_relay_stats);
+
+static int __init irq_relay_debugfs_init(void)
+{
+	debugfs_create_file("irq_relay", 0444, NULL, NULL,
+			    &irq_relay_stats_fops);
+	return 0;
+}
+late_initcall(irq_relay_debugfs_init);
+
+#endif /* CONFIG_DEBUG_FS */
+
 #ifdef CONFIG_DEBUG_IRQ_PIPELINE
 
 #ifdef CONFIG_LOCKDEP
@@ -1739,6 +1987,8 @@ void __init irq_pipeline_init_early(void)
  */
 void __init irq_pipeline_init(void)
 {
+	int cpu;
+
 	WARN_ON(!hard_irqs_disabled());
 
 	synthetic_irq_domain = irq_domain_add_nomap(NULL, ~0,
@@ -1747,6 +1997,12 @@ void __init irq_pipeline_init(void)
 	inband_work_sirq = irq_create_direct_mapping(synthetic_irq_domain);
 	setup_percpu_irq(inband_work_sirq, &inband_work);
 
+	for_each_possible_cpu(cpu)
+		per_cpu(irq_relay_kick_work, cpu) =
+			IRQ_WORK_INIT_HARD(irq_relay_kick);
+	irq_relay_sirq = irq_create_direct_mapping(synthetic_irq_domain);
+	setup_percpu_irq(irq_relay_sirq, &inband_relay);
+
 	/*
 	 * We are running on the boot CPU, hw interrupts are off, and
 	 * secondary CPUs are still lost in space. Now we may run
@@ -17,6 +17,8 @@
 #include <linux/kcov.h>
 #include <linux/scs.h>
 
+#include <trace/events/dovetail.h>
+
 #include <asm/switch_to.h>
 #include <asm/tlb.h>
 
@@ -9624,6 +9626,7 @@ int dovetail_leave_inband(void)
 	 */
 	if (likely(__schedule(false))) {
 		arch_dovetail_switch_finish(false);
+		trace_dovetail_leave_inband(p);
 		return 0;
 	}
 
@@ -9650,6 +9653,7 @@ void dovetail_resume_inband(void)
 
 	rq = finish_task_switch(p);
 	preempt_enable();
+	trace_dovetail_resume_inband(current);
 	oob_trampoline();
 }
 EXPORT_SYMBOL_GPL(dovetail_resume_inband);
@@ -0,0 +1,767 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * CPUFreq governor aware of the out-of-band execution stage.
+ *
+ * In-band only periods are scaled according to the utilization data
+ * provided by the scheduler, the way schedutil does. The companion
+ * core reports the utilization of the oob stage separately through
+ * cpufreq_update_oob_util(). As soon as any CPU of a policy shows oob
+ * activity, the frequency of the policy is locked: it may only go up
+ * from there, so that the oob stage never has its CPU slowed down
+ * under its feet. The lock is released once the oob stage has been
+ * quiet for oob_hold_us on all CPUs of the policy, which is when
+ * in-band scaling resumes. Since transitions may stall the CPU for a
+ * while, a pending transition to a lower frequency is dropped if oob
+ * activity shows up before the switch happens.
+ *
+ * The time spent at each frequency is accounted separately for oob
+ * activity windows and in-band only periods, see time_in_state.
+ */
+
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+
+#include "sched.h"
+
+#include <linux/dovetail.h>
+#include <linux/sched/cpufreq.h>
+
+/* Default time the oob stage must have been idle to release the lock. */
+#define STGOV_OOB_HOLD_US	10000
+
+enum stgov_stage {
+	STGOV_INBAND,
+	STGOV_OOB,
+	STGOV_NR_STAGES,
+};
+
+struct stgov_tunables {
+	struct gov_attr_set	attr_set;
+	unsigned int		rate_limit_us;
+	unsigned int		oob_freq_khz;
+	unsigned int		oob_hold_us;
+};
+
+struct stgov_policy {
+	struct cpufreq_policy	*policy;
+
+	struct stgov_tunables	*tunables;
+	struct list_head	tunables_hook;
+
+	raw_spinlock_t		update_lock;
+	u64			last_freq_update_time;
+	s64			freq_update_delay_ns;
+	unsigned int		next_freq;
+	bool			limits_changed;
+	bool			need_freq_update;
+
+	/* Set while an oob activity window is open. */
+	bool			oob_locked;
+	u64			oob_last_seen;
+
+	/* Per-stage time in state, indexed like policy->freq_table. */
+	unsigned int		state_num;
+	u64			*time_in_state[STGOV_NR_STAGES];
+	int			last_index;
+	u64			last_time;
+
+	/* The next fields are only needed if fast switch cannot be used: */
+	struct			irq_work irq_work;
+	struct			kthread_work work;
+	struct			mutex work_lock;
+	struct			kthread_worker worker;
+	struct task_struct	*thread;
+	bool			work_in_progress;
+};
+
+struct stgov_cpu {
+	struct update_util_data	update_util;
+	struct stgov_policy	*sg_policy;
+};
+
+/*
+ * Written from the oob stage by cpufreq_update_oob_util(), read
+ * locklessly by the governor.
+ */
+struct stgov_oob_util {
+	unsigned long		util;
+	u64			stamp;
+};
+
+static DEFINE_PER_CPU(struct stgov_cpu, stgov_cpu);
+
+static DEFINE_PER_CPU(struct stgov_oob_util, stgov_oob_util);
+
+/**
+ * cpufreq_update_oob_util - Report the oob utilization of a CPU.
+ * @cpu: CPU the utilization applies to.
+ * @util: oob utilization, in capacity units. Zero means idle.
+ *
+ * Meant to be called by the companion core from the oob stage, each
+ * time the utilization of @cpu changes significantly. This only
+ * updates per-CPU data, the governor picks it up at the next in-band
+ * frequency update.
+ */
+void cpufreq_update_oob_util(int cpu, unsigned long util)
+{
+	struct stgov_oob_util *ou = per_cpu_ptr(&stgov_oob_util, cpu);
+
+	if (util)
+		WRITE_ONCE(ou->stamp, ktime_get_mono_fast_ns());
+
+	WRITE_ONCE(ou->util, util);
+}
+EXPORT_SYMBOL_GPL(cpufreq_update_oob_util);
+
+/************************ Governor internals ***********************/
+
+static bool stgov_oob_active(struct stgov_policy *sg_policy, u64 now)
+{
+	u64 hold_ns = (u64)sg_policy->tunables->oob_hold_us * NSEC_PER_USEC;
+	struct stgov_oob_util *ou;
+	unsigned int cpu;
+	u64 stamp;
+
+	for_each_cpu(cpu, sg_policy->policy->cpus) {
+		ou = per_cpu_ptr(&stgov_oob_util, cpu);
+		if (READ_ONCE(ou->util) || oob_cpu_busy(cpu)) {
+			sg_policy->oob_last_seen = now;
+			return true;
+		}
+		stamp = READ_ONCE(ou->stamp);
+		if (stamp > sg_policy->oob_last_seen)
+			sg_policy->oob_last_seen = stamp;
+	}
+
+	return sg_policy->oob_locked &&
+		now - sg_policy->oob_last_seen < hold_ns;
+}
+
+static void stgov_account(struct stgov_policy *sg_policy, u64 now)
+{
+	int stage = sg_policy->oob_locked ? STGOV_OOB : STGOV_INBAND;
+
+	if (sg_policy->last_index >= 0 && now > sg_policy->last_time)
+		sg_policy->time_in_state[stage][sg_policy->last_index] +=
+			now - sg_policy->last_time;
+
+	sg_policy->last_time = now;
+}
+
+static void stgov_track_freq(struct stgov_policy *sg_policy)
+{
+	struct cpufreq_policy *policy = sg_policy->policy;
+
+	if (!sg_policy->state_num)
+		return;
+
+	sg_policy->last_index =
+		cpufreq_frequency_table_get_index(policy, READ_ONCE(policy->cur));
+}
+
+static bool stgov_should_update_freq(struct stgov_policy *sg_policy, u64 time)
+{
+	s64 delta_ns;
+
+	if (unlikely(sg_policy->limits_changed)) {
+		sg_policy->limits_changed = false;
+		sg_policy->need_freq_update = true;
+		return true;
+	}
+
+	delta_ns = time - sg_policy->last_freq_update_time;
+
+	return delta_ns >= sg_policy->freq_update_delay_ns;
+}
+
+/*
+ * Pick the frequency for the highest utilization/capacity ratio among
+ * the CPUs of the policy, counting in the oob utilization while the
+ * frequency is locked.
+ */
+static unsigned int stgov_next_freq(struct stgov_policy *sg_policy)
+{
+	struct cpufreq_policy *policy = sg_policy->policy;
+	unsigned long util = 0, max = 1, freq;
+	unsigned int j;
+
+	for_each_cpu(j, policy->cpus) {
+		unsigned long j_max = arch_scale_cpu_capacity(j), j_util;
+
+		j_util = effective_cpu_util(j, cpu_util_cfs(cpu_rq(j)), j_max,
+					    FREQUENCY_UTIL, NULL);
+		if (sg_policy->oob_locked)
+			j_util = min(j_util + READ_ONCE(per_cpu(stgov_oob_util, j).util),
+				     j_max);
+
+		if (j_util * max > j_max * util) {
+			util = j_util;
+			max = j_max;
+		}
+	}
+
+	freq = arch_scale_freq_invariant() ?
+		policy->cpuinfo.max_freq : policy->cur;
+	freq = map_util_freq(util, freq, max);
+
+	if (sg_policy->oob_locked)
+		freq = max_t(unsigned long, freq, sg_policy->tunables->oob_freq_khz ?:
+			     policy->max);
+
+	return cpufreq_driver_resolve_freq(policy, freq);
+}
+
+static void stgov_commit(struct stgov_policy *sg_policy, u64 time,
+			 unsigned int next_freq)
+{
+	if (sg_policy->need_freq_update)
+		sg_policy->need_freq_update = cpufreq_driver_test_flags(CPUFREQ_NEED_UPDATE_LIMITS);
+	else if (sg_policy->next_freq == next_freq)
+		return;
+
+	sg_policy->next_freq = next_freq;
+	sg_policy->last_freq_update_time = time;
+
+	if (sg_policy->policy->fast_switch_enabled) {
+		cpufreq_driver_fast_switch(sg_policy->policy, next_freq);
+	} else if (!sg_policy->work_in_progress) {
+		sg_policy->work_in_progress = true;
+		irq_work_queue(&sg_policy->irq_work);
+	}
+}
+
+static void stgov_update(struct update_util_data *hook, u64 time,
+			 unsigned int flags)
+{
+	struct stgov_cpu *sg_cpu = container_of(hook, struct stgov_cpu, update_util);
+	struct stgov_policy *sg_policy = sg_cpu->sg_policy;
+	unsigned int next_f;
+	bool oob_active;
+	u64 now;
+
+	/* See sugov_should_update_freq(). */
+	if (!cpufreq_this_cpu_can_update(sg_policy->policy))
+		return;
+
+	raw_spin_lock(&sg_policy->update_lock);
+
+	now = ktime_get_mono_fast_ns();
+	stgov_account(sg_policy, now);
+
+	oob_active = stgov_oob_active(sg_policy, now);
+	if (oob_active != sg_policy->oob_locked) {
+		sg_policy->oob_locked = oob_active;
+		sg_policy->limits_changed = true;
+	}
+
+	if (!stgov_should_update_freq(sg_policy, time))
+		goto out;
+
+	next_f = stgov_next_freq(sg_policy);
+
+	/* The frequency may only go up during an oob activity window. */
+	if (sg_policy->oob_locked && !sg_policy->need_freq_update &&
+	    next_f < sg_policy->next_freq)
+		goto out;
+
+	stgov_commit(sg_policy, time, next_f);
+out:
+	stgov_track_freq(sg_policy);
+	raw_spin_unlock(&sg_policy->update_lock);
+}
+
+static void stgov_work(struct kthread_work *work)
+{
+	struct stgov_policy *sg_policy = container_of(work, struct stgov_policy, work);
+	struct cpufreq_policy *policy = sg_policy->policy;
+	unsigned long flags;
+	unsigned int freq;
+	bool drop = false;
+	unsigned int cpu;
+
+	/* See sugov_work(). */
+	raw_spin_lock_irqsave(&sg_policy->update_lock, flags);
+	freq = sg_policy->next_freq;
+	sg_policy->work_in_progress = false;
+	raw_spin_unlock_irqrestore(&sg_policy->update_lock, flags);
+
+	/*
+	 * Do not slow the CPU down while the oob stage is getting busy,
+	 * the next update will lock the frequency instead.
+	 */
+	if (freq < READ_ONCE(policy->cur)) {
+		for_each_cpu(cpu, policy->cpus) {
+			if (READ_ONCE(per_cpu(stgov_oob_util, cpu).util) ||
+			    oob_cpu_busy(cpu)) {
+				drop = true;
+				break;
+			}
+		}
+	}
+
+	if (drop) {
+		raw_spin_lock_irqsave(&sg_policy->update_lock, flags);
+		sg_policy->limits_changed = true;
+		raw_spin_unlock_irqrestore(&sg_policy->update_lock, flags);
+		return;
+	}
+
+	mutex_lock(&sg_policy->work_lock);
+	__cpufreq_driver_target(policy, freq, CPUFREQ_RELATION_L);
+	mutex_unlock(&sg_policy->work_lock);
+}
+
+static void stgov_irq_work(struct irq_work *irq_work)
+{
+	struct stgov_policy *sg_policy;
+
+	sg_policy = container_of(irq_work, struct stgov_policy, irq_work);
+
+	kthread_queue_work(&sg_policy->worker, &sg_policy->work);
+}
+
+/************************** sysfs interface ************************/
+
+static struct stgov_tunables *global_tunables;
+static DEFINE_MUTEX(global_tunables_lock);
+
+static inline struct stgov_tunables *to_stgov_tunables(struct gov_attr_set *attr_set)
+{
+	return container_of(attr_set, struct stgov_tunables, attr_set);
+}
+
+static ssize_t rate_limit_us_show(struct gov_attr_set *attr_set, char *buf)
+{
+	struct stgov_tunables *tunables = to_stgov_tunables(attr_set);
+
+	return sprintf(buf, "%u\n", tunables->rate_limit_us);
+}
+
+static ssize_t
+rate_limit_us_store(struct gov_attr_set *attr_set, const char *buf, size_t count)
+{
+	struct stgov_tunables *tunables = to_stgov_tunables(attr_set);
+	struct stgov_policy *sg_policy;
+	unsigned int rate_limit_us;
+
+	if (kstrtouint(buf, 10, &rate_limit_us))
+		return -EINVAL;
+
+	tunables->rate_limit_us = rate_limit_us;
+
+	list_for_each_entry(sg_policy, &attr_set->policy_list, tunables_hook)
+		sg_policy->freq_update_delay_ns = rate_limit_us * NSEC_PER_USEC;
+
+	return count;
+}
+
+static ssize_t oob_freq_khz_show(struct gov_attr_set *attr_set, char *buf)
+{
+	struct stgov_tunables *tunables = to_stgov_tunables(attr_set);
+
+	return sprintf(buf, "%u\n", tunables->oob_freq_khz);
+}
+
+static ssize_t
+oob_freq_khz_store(struct gov_attr_set *attr_set, const char *buf, size_t count)
+{
+	struct stgov_tunables *tunables = to_stgov_tunables(attr_set);
+	struct stgov_policy *sg_policy;
+	unsigned int oob_freq_khz;
+
+	if (kstrtouint(buf, 10, &oob_freq_khz))
+		return -EINVAL;
+
+	WRITE_ONCE(tunables->oob_freq_khz, oob_freq_khz);
+
+	list_for_each_entry(sg_policy, &attr_set->policy_list, tunables_hook)
+		sg_policy->limits_changed = true;
+
+	return count;
+}
+
+static ssize_t oob_hold_us_show(struct gov_attr_set *attr_set, char *buf)
+{
+	struct stgov_tunables *tunables = to_stgov_tunables(attr_set);
+
+	return sprintf(buf, "%u\n", tunables->oob_hold_us);
+}
+
+static ssize_t
+oob_hold_us_store(struct gov_attr_set *attr_set, const char *buf, size_t count)
+{
+	struct stgov_tunables *tunables = to_stgov_tunables(attr_set);
+	unsigned int oob_hold_us;
+
+	if (kstrtouint(buf, 10, &oob_hold_us))
+		return -EINVAL;
+
+	WRITE_ONCE(tunables->oob_hold_us, oob_hold_us);
+
+	return count;
+}
+
+/*
+ * One line per frequency and policy: the first CPU of the policy, the
+ * frequency in kHz, then the time spent at that frequency during oob
+ * activity windows and in-band only periods, in microseconds.
+ */
+static ssize_t time_in_state_show(struct gov_attr_set *attr_set, char *buf)
+{
+	struct cpufreq_frequency_table *pos;
+	struct stgov_policy *sg_policy;
+	struct cpufreq_policy *policy;
+	unsigned long flags;
+	ssize_t len = 0;
+	int i;
+
+	list_for_each_entry(sg_policy, &attr_set->policy_list, tunables_hook) {
+		policy = sg_policy->policy;
+		if (!sg_policy->state_num)
+			continue;
+
+		raw_spin_lock_irqsave(&sg_policy->update_lock, flags);
+
+		stgov_account(sg_policy, ktime_get_mono_fast_ns());
+
+		cpufreq_for_each_valid_entry_idx(pos, policy->freq_table, i)
+			len += sysfs_emit_at(buf, len, "%u %u %llu %llu\n",
+				cpumask_first(policy->related_cpus),
+				pos->frequency,
+				div_u64(sg_policy->time_in_state[STGOV_OOB][i],
+					NSEC_PER_USEC),
+				div_u64(sg_policy->time_in_state[STGOV_INBAND][i],
+					NSEC_PER_USEC));
+
+		raw_spin_unlock_irqrestore(&sg_policy->update_lock, flags);
+	}
+
+	return len;
+}
+
+static struct governor_attr rate_limit_us = __ATTR_RW(rate_limit_us);
+static struct governor_attr oob_freq_khz = __ATTR_RW(oob_freq_khz);
+static struct governor_attr oob_hold_us = __ATTR_RW(oob_hold_us);
+static struct governor_attr time_in_state = __ATTR_RO(time_in_state);
+
+static struct attribute *stgov_attrs[] = {
+	&rate_limit_us.attr,
+	&oob_freq_khz.attr,
+	&oob_hold_us.attr,
+	&time_in_state.attr,
+	NULL
+};
+ATTRIBUTE_GROUPS(stgov);
+
+static struct kobj_type stgov_tunables_ktype = {
+	.default_groups = stgov_groups,
+	.sysfs_ops = &governor_sysfs_ops,
+};
+
+/********************** cpufreq governor interface *********************/
+
+static struct cpufreq_governor stageutil_gov;
+
+static struct stgov_policy *stgov_policy_alloc(struct cpufreq_policy *policy)
+{
+	struct cpufreq_frequency_table *pos;
+	struct stgov_policy *sg_policy;
+	unsigned int state_num = 0;
+	u64 *stats;
+
+	sg_policy = kzalloc(sizeof(*sg_policy), GFP_KERNEL);
+	if (!sg_policy)
+		return NULL;
+
+	/* Drivers with no frequency table get no time_in_state. */
+	if (policy->freq_table) {
+		cpufreq_for_each_entry(pos, policy->freq_table)
+			state_num++;
+
+		stats = kcalloc(state_num * STGOV_NR_STAGES, sizeof(*stats),
+				GFP_KERNEL);
+		if (!stats) {
+			kfree(sg_policy);
+			return NULL;
+		}
+
+		sg_policy->state_num = state_num;
+		sg_policy->time_in_state[STGOV_INBAND] = stats;
+		sg_policy->time_in_state[STGOV_OOB] = stats + state_num;
+	}
+
+	sg_policy->policy = policy;
+	sg_policy->last_index = -1;
+	raw_spin_lock_init(&sg_policy->update_lock);
+	return sg_policy;
+}
+
+static void stgov_policy_free(struct stgov_policy *sg_policy)
+{
+	kfree(sg_policy->time_in_state[STGOV_INBAND]);
+	kfree(sg_policy);
+}
+
+static int stgov_kthread_create(struct stgov_policy *sg_policy)
+{
+	struct task_struct *thread;
+	struct sched_attr attr = {
+		.size		= sizeof(struct sched_attr),
+		.sched_policy	= SCHED_DEADLINE,
+		.sched_flags	= SCHED_FLAG_SUGOV,
+		.sched_nice	= 0,
+		.sched_priority	= 0,
+		/* Same fake bandwidth as sugov threads. */
+		.sched_runtime	=  1000000,
+		.sched_deadline = 10000000,
+		.sched_period	= 10000000,
+	};
+	struct cpufreq_policy *policy = sg_policy->policy;
+	int ret;
+
+	/* kthread only required for slow path */
+	if (policy->fast_switch_enabled)
+		return 0;
+
+	kthread_init_work(&sg_policy->work, stgov_work);
+	kthread_init_worker(&sg_policy->worker);
+	thread = kthread_create(kthread_worker_fn, &sg_policy->worker,
+				"stgov:%d",
+				cpumask_first(policy->related_cpus));
+	if (IS_ERR(thread)) {
+		pr_err("failed to create stgov thread: %ld\n", PTR_ERR(thread));
+		return PTR_ERR(thread);
+	}
+
+	ret = sched_setattr_nocheck(thread, &attr);
+	if (ret) {
+		kthread_stop(thread);
+		pr_warn("%s: failed to set SCHED_DEADLINE\n", __func__);
+		return ret;
+	}
+
+	sg_policy->thread = thread;
+	kthread_bind_mask(thread, policy->related_cpus);
+	init_irq_work(&sg_policy->irq_work, stgov_irq_work);
+	mutex_init(&sg_policy->work_lock);
+
+	wake_up_process(thread);
+
+	return 0;
+}
+
+static void stgov_kthread_stop(struct stgov_policy *sg_policy)
+{
+	/* kthread only required for slow path */
+	if (sg_policy->policy->fast_switch_enabled)
+		return;
+
+	kthread_flush_worker(&sg_policy->worker);
+	kthread_stop(sg_policy->thread);
+	mutex_destroy(&sg_policy->work_lock);
+}
+
+static struct stgov_tunables *stgov_tunables_alloc(struct stgov_policy *sg_policy)
+{
+	struct stgov_tunables *tunables;
+
+	tunables = kzalloc(sizeof(*tunables), GFP_KERNEL);
+	if (tunables) {
+		gov_attr_set_init(&tunables->attr_set, &sg_policy->tunables_hook);
+		if (!have_governor_per_policy())
+			global_tunables = tunables;
+	}
+	return tunables;
+}
+
+static void stgov_tunables_free(struct stgov_tunables *tunables)
+{
+	if (!have_governor_per_policy())
+		global_tunables = NULL;
+
+	kfree(tunables);
+}
+
+static int stgov_init(struct cpufreq_policy *policy)
+{
+	struct stgov_policy *sg_policy;
+	struct stgov_tunables *tunables;
+	int ret = 0;
+
+	/* State should be equivalent to EXIT */
+	if (policy->governor_data)
+		return -EBUSY;
+
+	cpufreq_enable_fast_switch(policy);
+
+	sg_policy = stgov_policy_alloc(policy);
+	if (!sg_policy) {
+		ret = -ENOMEM;
+		goto disable_fast_switch;
+	}
+
+	ret = stgov_kthread_create(sg_policy);
+	if (ret)
+		goto free_sg_policy;
+
+	mutex_lock(&global_tunables_lock);
+
+	if (global_tunables) {
+		if (WARN_ON(have_governor_per_policy())) {
+			ret = -EINVAL;
+			goto stop_kthread;
+		}
+		policy->governor_data = sg_policy;
+		sg_policy->tunables = global_tunables;
+
+		gov_attr_set_get(&global_tunables->attr_set, &sg_policy->tunables_hook);
+		goto out;
+	}
+
+	tunables = stgov_tunables_alloc(sg_policy);
+	if (!tunables) {
+		ret = -ENOMEM;
+		goto stop_kthread;
+	}
+
+	tunables->rate_limit_us = cpufreq_policy_transition_delay_us(policy);
+	tunables->oob_hold_us = STGOV_OOB_HOLD_US;
+
+	policy->governor_data = sg_policy;
+	sg_policy->tunables = tunables;
+
+	ret = kobject_init_and_add(&tunables->attr_set.kobj, &stgov_tunables_ktype,
+				   get_governor_parent_kobj(policy), "%s",
+				   stageutil_gov.name);
+	if (ret)
+		goto fail;
+
+out:
+	mutex_unlock(&global_tunables_lock);
+	return 0;
+
+fail:
+	kobject_put(&tunables->attr_set.kobj);
+	policy->governor_data = NULL;
+	stgov_tunables_free(tunables);
+
+stop_kthread:
+	stgov_kthread_stop(sg_policy);
+	mutex_unlock(&global_tunables_lock);
+
+free_sg_policy:
+	stgov_policy_free(sg_policy);
+
+disable_fast_switch:
+	cpufreq_disable_fast_switch(policy);
+
+	pr_err("initialization failed (error %d)\n", ret);
+	return ret;
+}
+
+static void stgov_exit(struct cpufreq_policy *policy)
+{
+	struct stgov_policy *sg_policy = policy->governor_data;
+	struct stgov_tunables *tunables = sg_policy->tunables;
+	unsigned int count;
+
+	mutex_lock(&global_tunables_lock);
+
+	count = gov_attr_set_put(&tunables->attr_set, &sg_policy->tunables_hook);
+	policy->governor_data = NULL;
+	if (!count)
+		stgov_tunables_free(tunables);
+
+	mutex_unlock(&global_tunables_lock);
+
+	stgov_kthread_stop(sg_policy);
+	stgov_policy_free(sg_policy);
+	cpufreq_disable_fast_switch(policy);
+}
+
+static int stgov_start(struct cpufreq_policy *policy)
+{
+	struct stgov_policy *sg_policy = policy->governor_data;
+	unsigned long flags;
+	unsigned int cpu;
+
+	sg_policy->freq_update_delay_ns	= sg_policy->tunables->rate_limit_us * NSEC_PER_USEC;
+	sg_policy->last_freq_update_time	= 0;
+	sg_policy->next_freq			= 0;
+	sg_policy->work_in_progress		= false;
+	sg_policy->limits_changed		= false;
+	sg_policy->oob_locked			= false;
+	sg_policy->oob_last_seen		= 0;
+
+	sg_policy->need_freq_update = cpufreq_driver_test_flags(CPUFREQ_NEED_UPDATE_LIMITS);
+
+	/* Statistics carry over stop/start cycles, the time in between does not. */
+	raw_spin_lock_irqsave(&sg_policy->update_lock, flags);
+	sg_policy->last_time = ktime_get_mono_fast_ns();
+	stgov_track_freq(sg_policy);
+	raw_spin_unlock_irqrestore(&sg_policy->update_lock, flags);
+
+	for_each_cpu(cpu, policy->cpus) {
+		struct stgov_cpu *sg_cpu = &per_cpu(stgov_cpu, cpu);
+
+		memset(sg_cpu, 0, sizeof(*sg_cpu));
+		sg_cpu->sg_policy = sg_policy;
+		cpufreq_add_update_util_hook(cpu, &sg_cpu->update_util, stgov_update);
+	}
+
+	return 0;
+}
+
+static void stgov_stop(struct cpufreq_policy *policy)
+{
+	struct stgov_policy *sg_policy = policy->governor_data;
+	unsigned long flags;
+	unsigned int cpu;
+
+	for_each_cpu(cpu, policy->cpus)
+		cpufreq_remove_update_util_hook(cpu);
+
+	synchronize_rcu();
+
+	if (!policy->fast_switch_enabled) {
+		irq_work_sync(&sg_policy->irq_work);
+		kthread_cancel_work_sync(&sg_policy->work);
+	}
+
+	raw_spin_lock_irqsave(&sg_policy->update_lock, flags);
+	stgov_account(sg_policy, ktime_get_mono_fast_ns());
+	sg_policy->last_index = -1;
+	raw_spin_unlock_irqrestore(&sg_policy->update_lock, flags);
+}
+
+static void stgov_limits(struct cpufreq_policy *policy)
+{
+	struct stgov_policy *sg_policy = policy->governor_data;
+
+	if (!policy->fast_switch_enabled) {
+		mutex_lock(&sg_policy->work_lock);
+		cpufreq_policy_apply_limits(policy);
+		mutex_unlock(&sg_policy->work_lock);
+	}
+
+	sg_policy->limits_changed = true;
+}
+
+static struct cpufreq_governor stageutil_gov = {
+	.name			= "stageutil",
+	.owner			= THIS_MODULE,
+	.flags			= CPUFREQ_GOV_DYNAMIC_SWITCHING,
+	.init			= stgov_init,
+	.exit			= stgov_exit,
+	.start			= stgov_start,
+	.stop			= stgov_stop,
+	.limits			= stgov_limits,
+};
+
+#ifdef CONFIG_CPU_FREQ_DEFAULT_GOV_STAGEUTIL
+struct cpufreq_governor *cpufreq_default_governor(void)
+{
+	return &stageutil_gov;
+}
+#endif
+
+cpufreq_governor_init(stageutil_gov);
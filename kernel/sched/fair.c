@@ -2746,6 +2746,13 @@ static void task_numa_work(struct callback_head *work)
 	if (p->flags & PF_EXITING)
 		return;
 
+	/*
+	 * Hinting faults would hit oob threads, and the pages may not
+	 * migrate anyway.
+	 */
+	if (dovetailed_mm(mm))
+		return;
+
 	if (!mm->numa_next_scan) {
 		mm->numa_next_scan = now +
 			msecs_to_jiffies(sysctl_numa_balancing_scan_delay);
@@ -9,6 +9,10 @@
  */
 #include "sched.h"
 
+#include <linux/interrupt.h>
+#include <linux/irq.h>
+#include <linux/kthread.h>
+
 DEFINE_STATIC_KEY_FALSE(housekeeping_overridden);
 EXPORT_SYMBOL_GPL(housekeeping_overridden);
 static cpumask_var_t housekeeping_mask;
@@ -198,3 +202,253 @@ static int __init housekeeping_isolcpus_setup(char *str)
 	return housekeeping_setup(str, flags);
 }
 __setup("isolcpus=", housekeeping_isolcpus_setup);
+
+#ifdef CONFIG_DOVETAIL
+
+/*
+ * The oob CPU partition is the set of CPUs dedicated to out-of-band
+ * work. The oob_cpus= boot parameter defines it, implying nohz_full=
+ * and managed IRQ isolation for the same CPUs, so that the tick,
+ * timers, RCU callbacks, kthreads and unbound work items are kept off
+ * of them from the start. The partition may be changed at runtime
+ * from /sys/devices/system/cpu/oob, in which case only what can be
+ * offloaded on a live system follows: unbound workqueues, IRQ and
+ * kthread affinities, RCU callbacks. oob_cpu_intrusions() tells what
+ * is left over.
+ */
+static struct cpumask oob_cpus;
+static struct cpumask oob_rcu_offloaded;
+static bool oob_wq_offloaded;
+static DEFINE_MUTEX(oob_cpus_lock);
+
+const struct cpumask *oob_cpu_partition(void)
+{
+	return &oob_cpus;
+}
+EXPORT_SYMBOL_GPL(oob_cpu_partition);
+
+static void oob_cpus_move_irqs(const struct cpumask *inband,
+			       struct cpumask *scratch)
+{
+	struct irq_data *irqd;
+	unsigned int irq;
+
+	irq_lock_sparse();
+
+	for_each_active_irq(irq) {
+		irqd = irq_get_irq_data(irq);
+		if (!irqd || irq_is_oob(irq) || irqd_affinity_is_managed(irqd) ||
+		    !irq_can_set_affinity(irq))
+			continue;
+
+		if (cpumask_subset(irq_data_get_affinity_mask(irqd), inband))
+			continue;
+
+		if (!cpumask_and(scratch, irq_data_get_affinity_mask(irqd), inband))
+			cpumask_copy(scratch, inband);
+
+		if (irq_set_affinity(irq, scratch))
+			pr_warn("oob_cpus: cannot move IRQ%u\n", irq);
+	}
+
+	irq_unlock_sparse();
+}
+
+static int oob_cpus_move_kthreads(const struct cpumask *inband,
+				  struct cpumask *scratch)
+{
+	struct task_struct *g, *p, **tasks;
+	int nr = 0, n = 0, i;
+
+	rcu_read_lock();
+	for_each_process_thread(g, p)
+		if (p->flags & PF_KTHREAD)
+			nr++;
+	rcu_read_unlock();
+
+	tasks = kmalloc_array(nr, sizeof(*tasks), GFP_KERNEL);
+	if (!tasks)
+		return -ENOMEM;
+
+	/* Kthreads spawned in the meantime inherit from kthreadd. */
+	rcu_read_lock();
+	for_each_process_thread(g, p) {
+		if (n >= nr)
+			goto done;
+		if (!(p->flags & PF_KTHREAD) || (p->flags & PF_NO_SETAFFINITY) ||
+		    kthread_is_per_cpu(p) || p->nr_cpus_allowed == 1 ||
+		    cpumask_subset(p->cpus_ptr, inband))
+			continue;
+		get_task_struct(p);
+		tasks[n++] = p;
+	}
+done:
+	rcu_read_unlock();
+
+	for (i = 0; i < n; i++) {
+		p = tasks[i];
+		if (!cpumask_and(scratch, p->cpus_ptr, inband))
+			cpumask_copy(scratch, inband);
+		set_cpus_allowed_ptr(p, scratch);
+		put_task_struct(p);
+	}
+
+	kfree(tasks);
+
+	return 0;
+}
+
+/**
+ * oob_cpu_partition_set - change the oob CPU partition
+ * @cpumask: the CPUs to dedicate to out-of-band work
+ *
+ * Unbound workqueues, the default IRQ affinity and kthreadd are
+ * restricted to the CPUs outside of @cpumask. In-band IRQs and
+ * kthreads which may currently run on oob CPUs are moved away,
+ * except per-CPU and managed ones. RCU callbacks are offloaded from
+ * the oob CPUs if possible. CPUs leaving the partition become
+ * eligible for unbound work and in-band IRQs again, but nothing is
+ * moved back to them.
+ *
+ * Returns 0 on success, -EINVAL if no online CPU would be left for
+ * in-band work.
+ */
+int oob_cpu_partition_set(const struct cpumask *cpumask)
+{
+	cpumask_var_t inband, scratch;
+	int cpu, ret = -ENOMEM;
+
+	if (!alloc_cpumask_var(&inband, GFP_KERNEL))
+		return -ENOMEM;
+
+	if (!alloc_cpumask_var(&scratch, GFP_KERNEL))
+		goto free_inband;
+
+	mutex_lock(&oob_cpus_lock);
+
+	ret = -EINVAL;
+	cpumask_andnot(inband, cpu_possible_mask, cpumask);
+	if (!cpumask_subset(cpumask, cpu_possible_mask) ||
+	    !cpumask_intersects(inband, cpu_online_mask))
+		goto out;
+
+	/* CPUs leaving the partition may handle in-band IRQs again. */
+	cpumask_andnot(scratch, &oob_cpus, cpumask);
+	cpumask_or(irq_default_affinity, irq_default_affinity, scratch);
+	if (!cpumask_andnot(scratch, irq_default_affinity, cpumask))
+		cpumask_copy(scratch, inband);
+	cpumask_copy(irq_default_affinity, scratch);
+
+	cpumask_copy(&oob_cpus, cpumask);
+
+	if (!cpumask_andnot(scratch, housekeeping_cpumask(HK_FLAG_WQ), cpumask))
+		cpumask_copy(scratch, inband);
+	oob_wq_offloaded = !workqueue_set_unbound_cpumask(scratch);
+	if (!oob_wq_offloaded)
+		pr_warn("oob_cpus: cannot restrict unbound workqueues\n");
+
+	if (!cpumask_and(scratch, housekeeping_cpumask(HK_FLAG_KTHREAD), inband))
+		cpumask_copy(scratch, inband);
+	set_cpus_allowed_ptr(kthreadd_task, scratch);
+
+	oob_cpus_move_irqs(inband, scratch);
+	ret = oob_cpus_move_kthreads(inband, scratch);
+
+	for_each_cpu(cpu, cpumask) {
+		if (!cpumask_test_cpu(cpu, &oob_rcu_offloaded) &&
+		    !rcu_nocb_cpu_offload(cpu))
+			cpumask_set_cpu(cpu, &oob_rcu_offloaded);
+	}
+
+	pr_info("oob_cpus: partition set to %*pbl\n", cpumask_pr_args(cpumask));
+out:
+	mutex_unlock(&oob_cpus_lock);
+	free_cpumask_var(scratch);
+free_inband:
+	free_cpumask_var(inband);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(oob_cpu_partition_set);
+
+/**
+ * oob_cpu_intrusions - report the in-band activity left on an oob CPU
+ * @cpu: the CPU to check
+ * @oi: filled in with the intrusion report
+ */
+void oob_cpu_intrusions(int cpu, struct oob_cpu_intrusions *oi)
+{
+	struct task_struct *g, *p;
+	struct irq_data *irqd;
+	unsigned int irq;
+
+	memset(oi, 0, sizeof(*oi));
+
+	irq_lock_sparse();
+
+	for_each_active_irq(irq) {
+		irqd = irq_get_irq_data(irq);
+		if (!irqd || !irq_has_action(irq) || irq_is_oob(irq))
+			continue;
+		if (cpumask_test_cpu(cpu, irq_data_get_effective_affinity_mask(irqd)))
+			oi->irqs++;
+	}
+
+	irq_unlock_sparse();
+
+	rcu_read_lock();
+	for_each_process_thread(g, p)
+		if ((p->flags & PF_KTHREAD) && cpumask_test_cpu(cpu, p->cpus_ptr))
+			oi->kthreads++;
+	rcu_read_unlock();
+
+	mutex_lock(&oob_cpus_lock);
+	oi->rcu = !cpumask_test_cpu(cpu, &oob_rcu_offloaded);
+	oi->unbound_wq = !oob_wq_offloaded || !cpumask_test_cpu(cpu, &oob_cpus);
+	mutex_unlock(&oob_cpus_lock);
+
+	oi->tick = !tick_nohz_full_cpu(cpu);
+	oi->timers = housekeeping_cpu(cpu, HK_FLAG_TIMER);
+}
+EXPORT_SYMBOL_GPL(oob_cpu_intrusions);
+
+static int __init oob_cpus_setup(char *str)
+{
+	unsigned int flags;
+
+	flags = HK_FLAG_WQ | HK_FLAG_TIMER | HK_FLAG_RCU | HK_FLAG_MISC |
+		HK_FLAG_KTHREAD | HK_FLAG_MANAGED_IRQ;
+
+	/* Isolation goes as far as the kernel permits, and is reported. */
+	if (IS_ENABLED(CONFIG_NO_HZ_FULL))
+		flags |= HK_FLAG_TICK;
+
+	if (!housekeeping_setup(str, flags))
+		return 0;
+
+	cpumask_andnot(&oob_cpus, cpu_possible_mask, housekeeping_mask);
+
+	return 1;
+}
+__setup("oob_cpus=", oob_cpus_setup);
+
+/* Apply the boot-time partition to IRQs and kthreads set up since. */
+static int __init oob_cpus_init(void)
+{
+	cpumask_var_t boot_cpus;
+
+	if (cpumask_empty(&oob_cpus))
+		return 0;
+
+	if (!alloc_cpumask_var(&boot_cpus, GFP_KERNEL))
+		return -ENOMEM;
+
+	cpumask_copy(boot_cpus, &oob_cpus);
+	oob_cpu_partition_set(boot_cpus);
+	free_cpumask_var(boot_cpus);
+
+	return 0;
+}
+late_initcall(oob_cpus_init);
+
+#endif /* CONFIG_DOVETAIL */
@@ -16,6 +16,8 @@
 #include <linux/irq_pipeline.h>
 #include <linux/stop_machine.h>
 #include <linux/slab.h>
+#include <linux/tick.h>
+#include <linux/sched/isolation.h>
 #include "tick-internal.h"
 
 static unsigned int proxy_tick_irq;
@@ -24,6 +26,9 @@ static DEFINE_MUTEX(proxy_mutex);
 
 static DEFINE_PER_CPU(struct clock_proxy_device, proxy_tick_device);
 
+/* Number of ticks relayed to the in-band stage by tick_notify_proxy(). */
+static DEFINE_PER_CPU(unsigned long, proxy_relayed_ticks);
+
 static inline struct clock_event_device *
 get_real_tick_device(struct clock_event_device *proxy_dev)
 {
@@ -293,6 +298,45 @@ static int enable_oob_timer(void *arg) /* hard_irqs_disabled() */
 	return 0;
 }
 
+/*
+ * CPUs which are part of the nohz_full set do not need any in-band
+ * tick as long as they only run oob threads: RCU callbacks, unbound
+ * timers and workqueues, and the scheduler tick itself are offloaded
+ * to the housekeeping CPUs. The proxy device inherits the tick mode
+ * of the real device it overrides, so stopping the in-band tick is
+ * still up to the nohz core, which re-evaluates its dependencies on
+ * interrupt exit. Kick those CPUs, so that a tick restarted while
+ * switching to the proxy device is stopped again as soon as possible.
+ */
+#ifdef CONFIG_NO_HZ_FULL
+static void kick_nohz_full_proxies(const struct cpumask *cpumask)
+{
+	cpumask_var_t kicked;
+	int cpu;
+
+	if (!tick_nohz_full_enabled())
+		return;
+
+	if (!zalloc_cpumask_var(&kicked, GFP_KERNEL))
+		return;
+
+	for_each_cpu_and(cpu, cpumask, tick_nohz_full_mask) {
+		if (!cpu_online(cpu))
+			continue;
+		tick_nohz_full_kick_cpu(cpu);
+		cpumask_set_cpu(cpu, kicked);
+	}
+
+	if (!cpumask_empty(kicked))
+		pr_info("proxy tick: in-band tickless on CPUs %*pbl\n",
+			cpumask_pr_args(kicked));
+
+	free_cpumask_var(kicked);
+}
+#else
+static inline void kick_nohz_full_proxies(const struct cpumask *cpumask) { }
+#endif
+
 struct proxy_install_arg {
 	void (*setup_proxy)(struct clock_proxy_device *dev);
 	int result;
@@ -342,6 +386,11 @@ int tick_install_proxy(void (*setup_proxy)(struct clock_proxy_device *dev),
 	proxy_tick_irq = sirq;
 	barrier();
 
+	/* The oob CPU partition is expected to run oob timers. */
+	if (!cpumask_subset(oob_cpu_partition(), cpumask))
+		pr_warn("proxy tick: oob CPUs %*pbl not all covered\n",
+			cpumask_pr_args(oob_cpu_partition()));
+
 	/*
 	 * Install a proxy tick device on each CPU. As the proxy
 	 * device is picked, the previous (real) tick device is
@@ -403,6 +452,8 @@ int tick_install_proxy(void (*setup_proxy)(struct clock_proxy_device *dev),
 	 * receipt of out-of-band timer events.
 	 */
 	stop_machine(enable_oob_timer, NULL, cpumask);
+
+	kick_nohz_full_proxies(cpumask);
 out:
 	mutex_unlock(&proxy_mutex);
 
@@ -461,6 +512,19 @@ void tick_notify_proxy(void)
 	 * and not stalled). Note that we might be called from the
 	 * in-band stage in some cases (see proxy_irq_handler()).
 	 */
+	__this_cpu_inc(proxy_relayed_ticks);
 	irq_post_inband(proxy_tick_irq);
 }
 EXPORT_SYMBOL_GPL(tick_notify_proxy);
+
+/*
+ * Return the number of in-band ticks relayed by tick_notify_proxy()
+ * on @cpu so far. An oob-dedicated CPU running in full nohz mode
+ * should see this count remain still for as long as it is running
+ * oob threads only.
+ */
+unsigned long tick_proxy_relayed_ticks(int cpu)
+{
+	return READ_ONCE(per_cpu(proxy_relayed_ticks, cpu));
+}
+EXPORT_SYMBOL_GPL(tick_proxy_relayed_ticks);
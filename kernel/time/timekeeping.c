@@ -619,6 +619,136 @@ void ktime_get_fast_timestamps(struct ktime_timestamps *snapshot)
 	snapshot->boot = snapshot->mono + ktime_to_ns(data_race(tk->offs_boot));
 }
 
+#ifdef CONFIG_DOVETAIL
+
+/*
+ * Timekeeping snapshot for the oob stage, which cannot wait on
+ * tk_core.seq since the timekeeper may be updated by the in-band code
+ * it preempted. This extends the fast timekeeper with the clock
+ * offsets, so that oob readers get NTP/PTP disciplined wall clock
+ * readings without any stage switch.
+ */
+struct tk_oob {
+	seqcount_latch_t		seq;
+	struct ktime_oob_snapshot	base[2];
+};
+
+static struct tk_oob tk_oob ____cacheline_aligned = {
+	.seq     = SEQCNT_LATCH_ZERO(tk_oob.seq),
+	.base[0] = { .clock = &dummy_clock, .mask = CLOCKSOURCE_MASK(64), .mult = 1 },
+	.base[1] = { .clock = &dummy_clock, .mask = CLOCKSOURCE_MASK(64), .mult = 1 },
+};
+
+/*
+ * Same latch technique as update_fast_timekeeper(): an oob reader
+ * preempting the update always finds one consistent copy.
+ */
+static void update_oob_timekeeper(const struct tk_read_base *tkr,
+				  const struct timekeeper *tk)
+{
+	struct ktime_oob_snapshot *base = tk_oob.base;
+
+	raw_write_seqcount_latch(&tk_oob.seq);
+
+	base->clock = tkr->clock;
+	base->cycle_last = tkr->cycle_last;
+	base->mask = tkr->mask;
+	base->mult = tkr->mult;
+	base->shift = tkr->shift;
+	base->xtime_nsec = tkr->xtime_nsec;
+	base->base_mono = tkr->base;
+	base->offsets[TK_OFFS_REAL] = tk->offs_real;
+	base->offsets[TK_OFFS_BOOT] = tk->offs_boot;
+	base->offsets[TK_OFFS_TAI] = tk->offs_tai;
+	base->clock_was_set_seq = tk->clock_was_set_seq;
+
+	raw_write_seqcount_latch(&tk_oob.seq);
+
+	memcpy(base + 1, base, sizeof(*base));
+}
+
+static __always_inline u64 oob_snapshot_delta_ns(const struct ktime_oob_snapshot *snap)
+{
+	struct clocksource *clock = READ_ONCE(snap->clock);
+	u64 delta;
+
+	delta = clocksource_delta(clock->read(clock), snap->cycle_last, snap->mask);
+
+	return (delta * snap->mult + snap->xtime_nsec) >> snap->shift;
+}
+
+/**
+ * ktime_get_oob_snapshot - Copy the current oob timekeeping snapshot
+ * @snap:	Pointer to the snapshot storage
+ *
+ * Meant for companion cores which read the clocksource by their own
+ * means, e.g. from a memory-mapped counter.
+ */
+void ktime_get_oob_snapshot(struct ktime_oob_snapshot *snap)
+{
+	unsigned int seq;
+
+	do {
+		seq = raw_read_seqcount_latch(&tk_oob.seq);
+		*snap = tk_oob.base[seq & 0x01];
+	} while (read_seqcount_latch_retry(&tk_oob.seq, seq));
+}
+EXPORT_SYMBOL_GPL(ktime_get_oob_snapshot);
+
+/**
+ * ktime_get_mono_oob_ns - Lockless access to clock monotonic
+ *
+ * Safe from the oob stage, provided the clocksource read handler is.
+ * The same ordering caveats as for ktime_get_mono_fast_ns() apply
+ * across a timekeeper update.
+ */
+u64 ktime_get_mono_oob_ns(void)
+{
+	const struct ktime_oob_snapshot *snap;
+	unsigned int seq;
+	u64 now;
+
+	do {
+		seq = raw_read_seqcount_latch(&tk_oob.seq);
+		snap = tk_oob.base + (seq & 0x01);
+		now = ktime_to_ns(snap->base_mono) + oob_snapshot_delta_ns(snap);
+	} while (read_seqcount_latch_retry(&tk_oob.seq, seq));
+
+	return now;
+}
+EXPORT_SYMBOL_GPL(ktime_get_mono_oob_ns);
+
+/**
+ * ktime_get_oob_ns_with_offset - Lockless access to an offset clock
+ * @offs:	Offset from clock monotonic to the requested clock
+ *
+ * See ktime_get_mono_oob_ns().
+ */
+u64 ktime_get_oob_ns_with_offset(enum tk_offsets offs)
+{
+	const struct ktime_oob_snapshot *snap;
+	unsigned int seq;
+	u64 now;
+
+	do {
+		seq = raw_read_seqcount_latch(&tk_oob.seq);
+		snap = tk_oob.base + (seq & 0x01);
+		now = ktime_to_ns(ktime_add(snap->base_mono, snap->offsets[offs]));
+		now += oob_snapshot_delta_ns(snap);
+	} while (read_seqcount_latch_retry(&tk_oob.seq, seq));
+
+	return now;
+}
+EXPORT_SYMBOL_GPL(ktime_get_oob_ns_with_offset);
+
+#else
+
+static inline void update_oob_timekeeper(const struct tk_read_base *tkr,
+					 const struct timekeeper *tk)
+{ }
+
+#endif /* CONFIG_DOVETAIL */
+
 /**
  * halt_fast_timekeeper - Prevent fast timekeeper from accessing clocksource.
  * @tk: Timekeeper to snapshot.
@@ -639,6 +769,7 @@ static void halt_fast_timekeeper(const struct timekeeper *tk)
 	tkr_dummy.clock = &dummy_clock;
 	tkr_dummy.base_real = tkr->base + tk->offs_real;
 	update_fast_timekeeper(&tkr_dummy, &tk_fast_mono);
+	update_oob_timekeeper(&tkr_dummy, tk);
 
 	tkr = &tk->tkr_raw;
 	memcpy(&tkr_dummy, tkr, sizeof(tkr_dummy));
@@ -754,6 +885,8 @@ static void timekeeping_update(struct timekeeper *tk, unsigned int action)
 
 	if (action & TK_CLOCK_WAS_SET)
 		tk->clock_was_set_seq++;
+
+	update_oob_timekeeper(&tk->tkr_mono, tk);
 	/*
 	 * The mirroring of the data to the shadow-timekeeper needs
 	 * to happen last here to ensure we don't over-write the
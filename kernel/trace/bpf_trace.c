@@ -17,6 +17,7 @@
 #include <linux/error-injection.h>
 #include <linux/btf_ids.h>
 #include <linux/bpf_lsm.h>
+#include <linux/irqstage.h>
 
 #include <net/bpf_sk_storage.h>
 
@@ -1773,9 +1774,52 @@ void bpf_put_raw_tracepoint(struct bpf_raw_event_map *btp)
 	preempt_enable();
 }
 
+#ifdef CONFIG_IRQ_PIPELINE
+/*
+ * Only programs loaded with BPF_F_OOB may run from the oob stage,
+ * the verifier limited them to helpers and maps which do not depend
+ * on in-band serialization. RCU may not be watching there, enter it
+ * like the pipeline entry code does. Run-time stats are not
+ * collected, they rely on in-band interrupt masking.
+ */
+static void __bpf_trace_run_oob(struct bpf_prog *prog, u64 *args)
+{
+	bool rcu_entered = false;
+	unsigned long flags;
+
+	if (!prog->aux->oob)
+		return;
+
+	flags = hard_local_irq_save();
+
+	if (!rcu_is_watching()) {
+		rcu_nmi_enter();
+		rcu_entered = true;
+	}
+
+	rcu_read_lock();
+	(void) bpf_dispatcher_nop_func(args, prog->insnsi, prog->bpf_func);
+	rcu_read_unlock();
+
+	if (rcu_entered)
+		rcu_nmi_exit();
+
+	hard_local_irq_restore(flags);
+}
+#else
+static inline void __bpf_trace_run_oob(struct bpf_prog *prog, u64 *args)
+{
+}
+#endif
+
 static __always_inline
 void __bpf_trace_run(struct bpf_prog *prog, u64 *args)
 {
+	if (running_oob()) {
+		__bpf_trace_run_oob(prog, args);
+		return;
+	}
+
 	cant_sleep();
 	rcu_read_lock();
 	(void) BPF_PROG_RUN(prog, args);
@@ -339,6 +339,35 @@ FTRACE_ENTRY(hwlat, hwlat_entry,
 		 __entry->nmi_count)
 );
 
+FTRACE_ENTRY(oob_timerlat, oob_timerlat_entry,
+
+	TRACE_OOB_TIMERLAT,
+
+	F_STRUCT(
+		__field(	u64,			irq_latency	)
+		__field(	u64,			thread_latency	)
+		__field(	u64,			irqsoff		)
+		__field(	unsigned long,		irqsoff_ip	)
+		__field(	u64,			nmi		)
+		__field(	u64,			replay		)
+		__field(	u64,			other		)
+		__field(	unsigned int,		nmi_count	)
+		__field(	unsigned int,		replay_count	)
+		__field(	unsigned int,		seqnum		)
+	),
+
+	F_printk("cnt:%u\tirq:%llu\tthread:%llu\tirqsoff:%llu\tnmi:%llu\tnmi-count:%u\treplay:%llu\treplay-count:%u\tother:%llu\n",
+		 __entry->seqnum,
+		 __entry->irq_latency,
+		 __entry->thread_latency,
+		 __entry->irqsoff,
+		 __entry->nmi,
+		 __entry->nmi_count,
+		 __entry->replay,
+		 __entry->replay_count,
+		 __entry->other)
+);
+
 #define FUNC_REPEATS_GET_DELTA_TS(entry)				\
 	(((u64)(entry)->top_delta_ts << 32) | (entry)->bottom_delta_ts)	\
 
@@ -0,0 +1,437 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Hard irqs off latency tracer
+ *
+ * With interrupt pipelining, the in-band stage only disables
+ * interrupts virtually, which the irqsoff tracer accounts for. What
+ * bounds the response time of the oob stage is the code running
+ * with interrupts masked in the CPU, i.e. hard_local_irq_save() and
+ * friends, hard and hybrid spinlocks, firmware calls. This tracer
+ * measures those sections, keeping per-CPU the maximum, a log2
+ * histogram of the section lengths and the callsites which opened
+ * the longest sections.
+ *
+ * Measuring is turned on by writing 1 to hard_irqsoff/enable in
+ * tracefs. It costs two clock reads per section and involves no
+ * locking, so that it may be left enabled during soak tests.
+ */
+#include <linux/kallsyms.h>
+#include <linux/module.h>
+#include <linux/percpu.h>
+#include <linux/sched/clock.h>
+#include <linux/seq_file.h>
+#include <linux/sort.h>
+#include <linux/kprobes.h>
+
+#include "trace.h"
+
+/* Bucket n counts the sections which lasted [2^n, 2^(n+1)) ns. */
+#define HARD_IRQSOFF_BUCKETS	32
+
+/* Callsites remembered per CPU. */
+#define HARD_IRQSOFF_SITES	16
+
+/* Callsites reported by hard_irqsoff/callsites. */
+#define HARD_IRQSOFF_TOP	10
+
+struct hard_irqsoff_site {
+	unsigned long ip;
+	unsigned long parent_ip;
+	unsigned long count;
+	u64 max_ns;
+	u64 total_ns;
+};
+
+struct hard_irqsoff_cpu {
+	u64 start;
+	unsigned int epoch;
+	unsigned long ip;
+	unsigned long parent_ip;
+	int reset;
+	u64 last_start;
+	u64 last_end;
+	unsigned long last_ip;
+	u64 max_ns;
+	unsigned long max_ip;
+	unsigned long hist[HARD_IRQSOFF_BUCKETS];
+	struct hard_irqsoff_site sites[HARD_IRQSOFF_SITES];
+};
+
+static DEFINE_PER_CPU(struct hard_irqsoff_cpu, hard_irqsoff_cpu);
+
+int hard_irqsoff_tracing __read_mostly;
+EXPORT_SYMBOL_GPL(hard_irqsoff_tracing);
+
+/* Sections which straddle a disable/enable cycle are dropped. */
+static unsigned int hard_irqsoff_epoch;
+
+static DEFINE_MUTEX(hard_irqsoff_lock);
+
+/*
+ * Hard irqs are off on entry to the helpers below, which must not
+ * use anything which might mask them again, such as the generic
+ * this_cpu accessors.
+ */
+static notrace struct hard_irqsoff_cpu *this_hard_irqsoff_cpu(void)
+{
+	return per_cpu_ptr(&hard_irqsoff_cpu, raw_smp_processor_id());
+}
+
+void notrace __trace_hard_irqs_off(unsigned long ip, unsigned long parent_ip)
+{
+	struct hard_irqsoff_cpu *hc;
+
+	if (in_nmi())
+		return;
+
+	hc = this_hard_irqsoff_cpu();
+	if (hc->start)
+		return;
+
+	hc->ip = ip;
+	hc->parent_ip = parent_ip;
+	hc->epoch = READ_ONCE(hard_irqsoff_epoch);
+	hc->start = sched_clock();
+}
+EXPORT_SYMBOL_GPL(__trace_hard_irqs_off);
+NOKPROBE_SYMBOL(__trace_hard_irqs_off);
+
+static notrace void account_site(struct hard_irqsoff_cpu *hc, u64 delta)
+{
+	struct hard_irqsoff_site *site, *victim = NULL;
+	int n;
+
+	for (n = 0; n < HARD_IRQSOFF_SITES; n++) {
+		site = hc->sites + n;
+		if (site->ip == hc->ip)
+			goto found;
+		if (!victim || site->max_ns < victim->max_ns)
+			victim = site;
+	}
+
+	/* Evict the least offending site if we beat it. */
+	if (victim->ip && victim->max_ns >= delta)
+		return;
+
+	site = victim;
+	site->ip = hc->ip;
+	site->count = 0;
+	site->max_ns = 0;
+	site->total_ns = 0;
+found:
+	site->count++;
+	site->total_ns += delta;
+	if (delta > site->max_ns) {
+		site->max_ns = delta;
+		site->parent_ip = hc->parent_ip;
+	}
+}
+
+void notrace __trace_hard_irqs_on(void)
+{
+	struct hard_irqsoff_cpu *hc;
+	u64 now, delta;
+
+	if (in_nmi())
+		return;
+
+	hc = this_hard_irqsoff_cpu();
+	if (!hc->start)
+		return;
+
+	now = sched_clock();
+	delta = now - hc->start;
+	hc->last_start = hc->start;
+	hc->last_end = now;
+	hc->last_ip = hc->ip;
+	hc->start = 0;
+
+	if (unlikely(hc->epoch != READ_ONCE(hard_irqsoff_epoch)))
+		return;
+
+	if (unlikely(READ_ONCE(hc->reset))) {
+		hc->max_ns = 0;
+		hc->max_ip = 0;
+		memset(hc->hist, 0, sizeof(hc->hist));
+		memset(hc->sites, 0, sizeof(hc->sites));
+		WRITE_ONCE(hc->reset, 0);
+	}
+
+	if (delta > hc->max_ns) {
+		hc->max_ns = delta;
+		hc->max_ip = hc->ip;
+	}
+
+	hc->hist[clamp(fls64(delta) - 1, 0, HARD_IRQSOFF_BUCKETS - 1)]++;
+
+	account_site(hc, delta);
+}
+EXPORT_SYMBOL_GPL(__trace_hard_irqs_on);
+NOKPROBE_SYMBOL(__trace_hard_irqs_on);
+
+/*
+ * Drop the current section, e.g. because the CPU is about to idle
+ * with hard irqs off, or irqs were re-enabled behind our back.
+ */
+void notrace hard_irqsoff_trace_discard(void)
+{
+	this_hard_irqsoff_cpu()->start = 0;
+}
+NOKPROBE_SYMBOL(hard_irqsoff_trace_discard);
+
+/*
+ * Tell how much of the last @window_ns before now the local CPU
+ * spent in the latest section it closed, reporting its callsite
+ * into @ip. Called with hard irqs off, e.g. from an oob timer
+ * handler for attributing its own latency.
+ */
+u64 notrace hard_irqsoff_last_overlap(u64 window_ns, unsigned long *ip)
+{
+	struct hard_irqsoff_cpu *hc = this_hard_irqsoff_cpu();
+	u64 now = sched_clock(), since;
+
+	if (!READ_ONCE(hard_irqsoff_tracing) || !hc->last_end)
+		return 0;
+
+	since = now > window_ns ? now - window_ns : 0;
+	if (hc->last_end <= since)
+		return 0;
+
+	*ip = hc->last_ip;
+
+	return hc->last_end - max(hc->last_start, since);
+}
+EXPORT_SYMBOL_GPL(hard_irqsoff_last_overlap);
+
+static int hard_irqsoff_enable_show(struct seq_file *m, void *v)
+{
+	seq_printf(m, "%d\n", READ_ONCE(hard_irqsoff_tracing));
+
+	return 0;
+}
+
+static int hard_irqsoff_enable_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, hard_irqsoff_enable_show, NULL);
+}
+
+static ssize_t hard_irqsoff_enable_write(struct file *file,
+					 const char __user *ubuf,
+					 size_t count, loff_t *ppos)
+{
+	bool enable;
+	int ret;
+
+	ret = kstrtobool_from_user(ubuf, count, &enable);
+	if (ret)
+		return ret;
+
+	mutex_lock(&hard_irqsoff_lock);
+
+	if (enable && !hard_irqsoff_tracing) {
+		WRITE_ONCE(hard_irqsoff_epoch, hard_irqsoff_epoch + 1);
+		smp_wmb();
+	}
+
+	WRITE_ONCE(hard_irqsoff_tracing, enable);
+
+	mutex_unlock(&hard_irqsoff_lock);
+
+	return count;
+}
+
+static const struct file_operations hard_irqsoff_enable_fops = {
+	.open		= hard_irqsoff_enable_open,
+	.read		= seq_read,
+	.write		= hard_irqsoff_enable_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+/*
+ * Writing anything to the statistics files clears them. Each CPU
+ * does so by itself when it next closes a section, so that no lock
+ * is needed on the measuring side.
+ */
+static ssize_t hard_irqsoff_reset_write(struct file *file,
+					const char __user *ubuf,
+					size_t count, loff_t *ppos)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		WRITE_ONCE(per_cpu(hard_irqsoff_cpu, cpu).reset, 1);
+
+	return count;
+}
+
+static int hard_irqsoff_max_show(struct seq_file *m, void *v)
+{
+	struct hard_irqsoff_cpu *hc;
+	int cpu;
+
+	for_each_online_cpu(cpu) {
+		hc = per_cpu_ptr(&hard_irqsoff_cpu, cpu);
+		if (READ_ONCE(hc->reset))
+			continue;
+		seq_printf(m, "%d %llu %pS\n", cpu,
+			   div_u64(READ_ONCE(hc->max_ns), NSEC_PER_USEC),
+			   (void *)READ_ONCE(hc->max_ip));
+	}
+
+	return 0;
+}
+
+static int hard_irqsoff_max_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, hard_irqsoff_max_show, NULL);
+}
+
+static const struct file_operations hard_irqsoff_max_fops = {
+	.open		= hard_irqsoff_max_open,
+	.read		= seq_read,
+	.write		= hard_irqsoff_reset_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int hard_irqsoff_hist_show(struct seq_file *m, void *v)
+{
+	struct hard_irqsoff_cpu *hc;
+	unsigned long count;
+	int cpu, n;
+
+	seq_puts(m, "# ns");
+	for_each_online_cpu(cpu)
+		seq_printf(m, " CPU%d", cpu);
+	seq_putc(m, '\n');
+
+	for (n = 0; n < HARD_IRQSOFF_BUCKETS; n++) {
+		seq_printf(m, "%llu", n ? 1ULL << n : 0ULL);
+		for_each_online_cpu(cpu) {
+			hc = per_cpu_ptr(&hard_irqsoff_cpu, cpu);
+			count = READ_ONCE(hc->reset) ? 0 : READ_ONCE(hc->hist[n]);
+			seq_printf(m, " %lu", count);
+		}
+		seq_putc(m, '\n');
+	}
+
+	return 0;
+}
+
+static int hard_irqsoff_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, hard_irqsoff_hist_show, NULL);
+}
+
+static const struct file_operations hard_irqsoff_hist_fops = {
+	.open		= hard_irqsoff_hist_open,
+	.read		= seq_read,
+	.write		= hard_irqsoff_reset_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int cmp_site(const void *a, const void *b)
+{
+	const struct hard_irqsoff_site *sa = a, *sb = b;
+
+	if (sa->max_ns == sb->max_ns)
+		return 0;
+
+	return sa->max_ns < sb->max_ns ? 1 : -1;
+}
+
+/* Merge the per-CPU callsites, reporting the worst offenders. */
+static int hard_irqsoff_sites_show(struct seq_file *m, void *v)
+{
+	struct hard_irqsoff_site *sites, *site, *s;
+	struct hard_irqsoff_cpu *hc;
+	int cpu, n, i, nr = 0;
+
+	sites = kcalloc(num_online_cpus() * HARD_IRQSOFF_SITES,
+			sizeof(*sites), GFP_KERNEL);
+	if (!sites)
+		return -ENOMEM;
+
+	for_each_online_cpu(cpu) {
+		hc = per_cpu_ptr(&hard_irqsoff_cpu, cpu);
+		if (READ_ONCE(hc->reset))
+			continue;
+		for (n = 0; n < HARD_IRQSOFF_SITES; n++) {
+			site = hc->sites + n;
+			if (!READ_ONCE(site->ip))
+				continue;
+			for (i = 0, s = sites; i < nr; i++, s++)
+				if (s->ip == site->ip)
+					break;
+			if (i == nr) {
+				if (nr >= num_online_cpus() * HARD_IRQSOFF_SITES)
+					break;
+				s->ip = site->ip;
+				nr++;
+			}
+			s->count += READ_ONCE(site->count);
+			s->total_ns += READ_ONCE(site->total_ns);
+			if (READ_ONCE(site->max_ns) > s->max_ns) {
+				s->max_ns = site->max_ns;
+				s->parent_ip = site->parent_ip;
+			}
+		}
+	}
+
+	sort(sites, nr, sizeof(*sites), cmp_site, NULL);
+
+	seq_puts(m, "# max_us avg_us count callsite <- caller\n");
+
+	for (i = 0, s = sites; i < min(nr, HARD_IRQSOFF_TOP); i++, s++)
+		seq_printf(m, "%llu %llu %lu %pS <- %pS\n",
+			   div_u64(s->max_ns, NSEC_PER_USEC),
+			   div_u64(div64_ul(s->total_ns, s->count), NSEC_PER_USEC),
+			   s->count, (void *)s->ip, (void *)s->parent_ip);
+
+	kfree(sites);
+
+	return 0;
+}
+
+static int hard_irqsoff_sites_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, hard_irqsoff_sites_show, NULL);
+}
+
+static const struct file_operations hard_irqsoff_sites_fops = {
+	.open		= hard_irqsoff_sites_open,
+	.read		= seq_read,
+	.write		= hard_irqsoff_reset_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static __init int init_hard_irqsoff_tracer(void)
+{
+	struct dentry *dir;
+	int ret;
+
+	ret = tracing_init_dentry();
+	if (ret)
+		return 0;
+
+	dir = tracefs_create_dir("hard_irqsoff", NULL);
+	if (!dir) {
+		pr_warn("Could not create tracefs 'hard_irqsoff' directory\n");
+		return 0;
+	}
+
+	trace_create_file("enable", 0644, dir, NULL,
+			  &hard_irqsoff_enable_fops);
+	trace_create_file("max_us", 0644, dir, NULL,
+			  &hard_irqsoff_max_fops);
+	trace_create_file("histogram", 0644, dir, NULL,
+			  &hard_irqsoff_hist_fops);
+	trace_create_file("callsites", 0644, dir, NULL,
+			  &hard_irqsoff_sites_fops);
+
+	return 0;
+}
+fs_initcall(init_hard_irqsoff_tracer);
@@ -0,0 +1,661 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Out-of-band timer latency tracer
+ *
+ * A periodic timer is armed on the out-of-band stage of every CPU in
+ * tracing_cpumask. Each shot measures two latencies relative to the
+ * programmed expiry date: when the oob timer handler runs (irq), then
+ * when a SCHED_FIFO in-band thread woken up by this handler resumes
+ * (thread).
+ *
+ * The noise which explains these latencies is attributed to its
+ * source along with every sample: the hard irqs off section which
+ * delayed the timer interrupt if any (see trace_hardirqsoff.c), NMIs
+ * and the replay of in-band interrupts logged while the in-band stage
+ * was stalled. What remains of the irq latency is spent in the
+ * interrupt entry path, in firmware (SMI, SBI calls) or stalled by
+ * the hardware.
+ *
+ * The tracer takes over the tick device of every online CPU via the
+ * proxy tick mechanism, multiplexing the in-band timer events with
+ * its own shots. For this reason, it cannot run concurrently with a
+ * companion core.
+ */
+#include <linux/clockchips.h>
+#include <linux/cpumask.h>
+#include <linux/ftrace_irq.h>
+#include <linux/irq_pipeline.h>
+#include <linux/irq_work.h>
+#include <linux/kthread.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/tick.h>
+#include <linux/timekeeping.h>
+#include <linux/tracefs.h>
+#include <linux/uaccess.h>
+
+#include "trace.h"
+
+#define BANNER			"oob_timerlat: "
+#define DEFAULT_PERIOD		1000		/* 1ms */
+#define MIN_PERIOD		50		/* 50us */
+#define MAX_PERIOD		USEC_PER_SEC	/* 1s */
+
+/* Bucket n counts the samples which lasted [2^n, 2^(n+1)) ns. */
+#define OTL_BUCKETS		32
+
+#define OTL_NO_EXPIRY		U64_MAX
+
+struct otl_noise {
+	u64 start;
+	u64 last_start;
+	u64 last_end;
+	u64 total_ns;
+	unsigned int count;
+};
+
+/* What the oob timer handler passes on to the sampling thread. */
+struct otl_shot {
+	unsigned int seqnum;
+	u64 expected;
+	u64 irq_latency;
+	u64 irqsoff;
+	unsigned long irqsoff_ip;
+	u64 nmi;
+	u64 nmi_total;
+	unsigned int nmi_count;
+	u64 replay_total;
+	unsigned int replay_count;
+};
+
+struct otl_cpu {
+	struct clock_event_device *real_dev;
+	bool armed;
+	u64 next_expiry;
+	u64 inband_expiry;
+	unsigned int seqnum;
+	unsigned long overruns;
+	int pending;
+	struct otl_shot shot;
+	struct otl_noise nmi;
+	struct otl_noise replay;
+	struct irq_work work;
+	struct task_struct *thread;
+	int reset;
+	unsigned long irq_hist[OTL_BUCKETS];
+	unsigned long thread_hist[OTL_BUCKETS];
+};
+
+static DEFINE_PER_CPU(struct otl_cpu, otl_cpu);
+
+static struct trace_array *otl_trace;
+
+/* Sampling period in us. */
+static u64 otl_period = DEFAULT_PERIOD;
+
+/* CPUs which run the oob timer. */
+static struct cpumask otl_cpus;
+
+/* Serializes start/stop requests. */
+static DEFINE_MUTEX(otl_lock);
+
+static bool otl_running;
+
+/* Tells NMIs and the in-band log replay to call back for accounting. */
+bool trace_oob_timerlat_callback_enabled;
+
+static inline int otl_bucket(u64 delta)
+{
+	return clamp(fls64(delta) - 1, 0, OTL_BUCKETS - 1);
+}
+
+static inline u64 otl_overlap(u64 start, u64 end, u64 from, u64 to)
+{
+	start = max(start, from);
+	end = min(end, to);
+
+	return end > start ? end - start : 0;
+}
+
+/*
+ * The noise callbacks run with hard irqs off, on the local CPU
+ * only. ktime_get_mono_fast_ns() is NMI-safe, which sched_clock()
+ * is not always.
+ */
+static notrace void otl_noise_enter(struct otl_noise *n)
+{
+	n->start = ktime_get_mono_fast_ns();
+}
+
+static notrace void otl_noise_exit(struct otl_noise *n)
+{
+	u64 now;
+
+	if (!n->start)
+		return;
+
+	now = ktime_get_mono_fast_ns();
+	n->last_start = n->start;
+	n->last_end = now;
+	n->total_ns += now - n->start;
+	n->count++;
+	n->start = 0;
+}
+
+void notrace trace_oob_timerlat_nmi(bool enter)
+{
+	struct otl_noise *n = &raw_cpu_ptr(&otl_cpu)->nmi;
+
+	if (enter)
+		otl_noise_enter(n);
+	else
+		otl_noise_exit(n);
+}
+
+void notrace trace_oob_timerlat_replay(bool enter)
+{
+	struct otl_noise *n = &raw_cpu_ptr(&otl_cpu)->replay;
+
+	if (enter)
+		otl_noise_enter(n);
+	else
+		otl_noise_exit(n);
+}
+
+/*
+ * Program the real clock event device for the earliest of the next
+ * oob shot and in-band event. Hard irqs off.
+ */
+static void otl_program(struct otl_cpu *oc, struct clock_event_device *real_dev,
+			u64 now)
+{
+	u64 next = oc->inband_expiry, delta;
+	unsigned long clc;
+
+	if (oc->armed)
+		next = min(next, oc->next_expiry);
+
+	if (next == OTL_NO_EXPIRY)
+		return;
+
+	if (real_dev->features & CLOCK_EVT_FEAT_KTIME) {
+		real_dev->set_next_ktime(ns_to_ktime(next), real_dev);
+		return;
+	}
+
+	delta = next > now ? next - now : 0;
+	delta = clamp(delta, real_dev->min_delta_ns, real_dev->max_delta_ns);
+	clc = ((unsigned long long)delta * real_dev->mult) >> real_dev->shift;
+	real_dev->set_next_event(clc, real_dev);
+}
+
+static void otl_shot(struct otl_cpu *oc, u64 now)
+{
+	struct otl_shot *s = &oc->shot;
+	u64 latency = now - oc->next_expiry;
+
+	if (unlikely(READ_ONCE(oc->reset))) {
+		memset(oc->irq_hist, 0, sizeof(oc->irq_hist));
+		memset(oc->thread_hist, 0, sizeof(oc->thread_hist));
+		oc->overruns = 0;
+		WRITE_ONCE(oc->reset, 0);
+	}
+
+	oc->irq_hist[otl_bucket(latency)]++;
+	oc->seqnum++;
+
+	/* The thread did not consume the previous shot yet. */
+	if (READ_ONCE(oc->pending)) {
+		oc->overruns++;
+		return;
+	}
+
+	s->seqnum = oc->seqnum;
+	s->expected = oc->next_expiry;
+	s->irq_latency = latency;
+	s->irqsoff_ip = 0;
+	s->irqsoff = hard_irqsoff_last_overlap(latency, &s->irqsoff_ip);
+	s->nmi = otl_overlap(oc->nmi.last_start, oc->nmi.last_end,
+			     s->expected, now);
+	s->nmi_total = oc->nmi.total_ns;
+	s->nmi_count = oc->nmi.count;
+	s->replay_total = oc->replay.total_ns;
+	s->replay_count = oc->replay.count;
+	smp_wmb();
+	WRITE_ONCE(oc->pending, 1);
+
+	irq_work_queue(&oc->work);
+}
+
+/* Runs on the oob stage, in NMI-like mode. */
+static void otl_oob_event(struct clock_event_device *real_dev)
+{
+	struct otl_cpu *oc = raw_cpu_ptr(&otl_cpu);
+	u64 now = ktime_get_mono_fast_ns(), period;
+
+	if (oc->armed && now >= oc->next_expiry) {
+		otl_shot(oc, now);
+		period = READ_ONCE(otl_period) * NSEC_PER_USEC;
+		oc->next_expiry += period;
+		if (oc->next_expiry <= now)
+			oc->next_expiry = now + period;
+	}
+
+	if (now >= oc->inband_expiry) {
+		oc->inband_expiry = OTL_NO_EXPIRY;
+		tick_notify_proxy();
+	}
+
+	otl_program(oc, real_dev, ktime_get_mono_fast_ns());
+}
+
+static int otl_proxy_set_next_event(unsigned long delay,
+				    struct clock_event_device *proxy_dev)
+{
+	struct otl_cpu *oc = raw_cpu_ptr(&otl_cpu);
+	unsigned long flags;
+	u64 now;
+
+	flags = hard_local_irq_save();
+	now = ktime_get_mono_fast_ns();
+	oc->inband_expiry = now + clockevent_delta2ns(delay, proxy_dev);
+	otl_program(oc, oc->real_dev, now);
+	hard_local_irq_restore(flags);
+
+	return 0;
+}
+
+static int otl_proxy_set_state_oneshot_stopped(struct clock_event_device *proxy_dev)
+{
+	struct otl_cpu *oc = raw_cpu_ptr(&otl_cpu);
+	struct clock_event_device *real_dev = oc->real_dev;
+	unsigned long flags;
+	int ret = 0;
+
+	/* Keep the device running for the oob timer if armed. */
+	flags = hard_local_irq_save();
+	oc->inband_expiry = OTL_NO_EXPIRY;
+	if (!oc->armed)
+		ret = real_dev->set_state_oneshot_stopped(real_dev);
+	hard_local_irq_restore(flags);
+
+	return ret;
+}
+
+static void otl_setup_proxy(struct clock_proxy_device *dev)
+{
+	struct clock_event_device *proxy_dev = &dev->proxy_device;
+	struct otl_cpu *oc = raw_cpu_ptr(&otl_cpu);
+
+	oc->real_dev = dev->real_device;
+	dev->handle_oob_event = otl_oob_event;
+
+	/*
+	 * Have the in-band timing core issue one-shot requests via
+	 * ->set_next_event() only, so that we can multiplex them
+	 * with the oob timer shots.
+	 */
+	proxy_dev->features &= ~(CLOCK_EVT_FEAT_PERIODIC | CLOCK_EVT_FEAT_KTIME);
+	proxy_dev->set_next_ktime = NULL;
+	proxy_dev->set_next_event = otl_proxy_set_next_event;
+	if (proxy_dev->set_state_oneshot_stopped)
+		proxy_dev->set_state_oneshot_stopped =
+			otl_proxy_set_state_oneshot_stopped;
+}
+
+static void otl_arm(void *arg) /* irqs_disabled() */
+{
+	struct otl_cpu *oc = raw_cpu_ptr(&otl_cpu);
+	unsigned long flags;
+	u64 now;
+
+	flags = hard_local_irq_save();
+	now = ktime_get_mono_fast_ns();
+	oc->next_expiry = now + READ_ONCE(otl_period) * NSEC_PER_USEC;
+	oc->armed = true;
+	otl_program(oc, oc->real_dev, now);
+	hard_local_irq_restore(flags);
+}
+
+static void otl_disarm(void *arg) /* irqs_disabled() */
+{
+	struct otl_cpu *oc = raw_cpu_ptr(&otl_cpu);
+	unsigned long flags;
+
+	flags = hard_local_irq_save();
+	oc->armed = false;
+	hard_local_irq_restore(flags);
+}
+
+static void otl_wakeup(struct irq_work *work)
+{
+	struct otl_cpu *oc = container_of(work, struct otl_cpu, work);
+
+	wake_up_process(oc->thread);
+}
+
+static void otl_sample(struct otl_cpu *oc, struct otl_shot *s, u64 now)
+{
+	struct trace_array *tr = otl_trace;
+	struct trace_event_call *call = &event_oob_timerlat;
+	struct trace_buffer *buffer = tr->array_buffer.buffer;
+	struct oob_timerlat_entry *entry;
+	struct ring_buffer_event *event;
+	u64 latency = now - s->expected, irq_noise;
+
+	oc->thread_hist[otl_bucket(latency)]++;
+
+	if (latency < tracing_thresh)
+		return;
+
+	event = trace_buffer_lock_reserve(buffer, TRACE_OOB_TIMERLAT,
+					  sizeof(*entry), tracing_gen_ctx());
+	if (!event)
+		return;
+
+	entry = ring_buffer_event_data(event);
+	entry->seqnum		= s->seqnum;
+	entry->irq_latency	= s->irq_latency;
+	entry->thread_latency	= latency;
+	entry->irqsoff		= s->irqsoff;
+	entry->irqsoff_ip	= s->irqsoff_ip;
+	entry->nmi		= s->nmi + oc->nmi.total_ns - s->nmi_total;
+	entry->nmi_count	= oc->nmi.count - s->nmi_count + !!s->nmi;
+	entry->replay		= oc->replay.total_ns - s->replay_total;
+	entry->replay_count	= oc->replay.count - s->replay_count;
+	irq_noise		= s->irqsoff + s->nmi;
+	entry->other		= s->irq_latency > irq_noise ?
+				  s->irq_latency - irq_noise : 0;
+
+	if (!call_filter_check_discard(call, entry, buffer, event))
+		trace_buffer_unlock_commit_nostack(buffer, event);
+}
+
+static int otl_thread_fn(void *data)
+{
+	struct otl_cpu *oc = data;
+	struct otl_shot s;
+	u64 now;
+
+	while (!kthread_should_stop()) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (!READ_ONCE(oc->pending)) {
+			schedule();
+			continue;
+		}
+		__set_current_state(TASK_RUNNING);
+
+		now = ktime_get_mono_fast_ns();
+		smp_rmb();
+		s = oc->shot;
+		otl_sample(oc, &s, now);
+		WRITE_ONCE(oc->pending, 0);
+	}
+
+	return 0;
+}
+
+static void otl_stop_threads(void)
+{
+	struct otl_cpu *oc;
+	int cpu;
+
+	for_each_cpu(cpu, &otl_cpus) {
+		oc = per_cpu_ptr(&otl_cpu, cpu);
+		if (!oc->thread)
+			continue;
+		irq_work_sync(&oc->work);
+		kthread_stop(oc->thread);
+		oc->thread = NULL;
+	}
+}
+
+static int otl_start(struct trace_array *tr)
+{
+	struct task_struct *thread;
+	struct otl_cpu *oc;
+	int cpu, ret;
+
+	if (otl_running)
+		return 0;
+
+	get_online_cpus();
+	cpumask_and(&otl_cpus, cpu_online_mask, tr->tracing_cpumask);
+	put_online_cpus();
+
+	for_each_possible_cpu(cpu) {
+		oc = per_cpu_ptr(&otl_cpu, cpu);
+		oc->armed = false;
+		oc->inband_expiry = OTL_NO_EXPIRY;
+		oc->pending = 0;
+		oc->work = IRQ_WORK_INIT_HARD(otl_wakeup);
+	}
+
+	for_each_cpu(cpu, &otl_cpus) {
+		oc = per_cpu_ptr(&otl_cpu, cpu);
+		thread = kthread_create_on_cpu(otl_thread_fn, oc, cpu, "otlat/%u");
+		if (IS_ERR(thread)) {
+			pr_err(BANNER "could not start sampling thread\n");
+			ret = PTR_ERR(thread);
+			goto fail;
+		}
+		sched_set_fifo(thread);
+		oc->thread = thread;
+		wake_up_process(thread);
+	}
+
+	/*
+	 * The proxy is installed on all online CPUs, so that the
+	 * timer IRQ is handled the same way everywhere. CPUs which
+	 * are not sampled merely relay the in-band events.
+	 */
+	ret = tick_install_proxy(otl_setup_proxy, cpu_online_mask);
+	if (ret) {
+		pr_err(BANNER "cannot take over the tick device (%d)\n", ret);
+		goto fail;
+	}
+
+	WRITE_ONCE(trace_oob_timerlat_callback_enabled, true);
+	on_each_cpu_mask(&otl_cpus, otl_arm, NULL, true);
+	otl_running = true;
+
+	return 0;
+fail:
+	otl_stop_threads();
+
+	return ret;
+}
+
+static void otl_stop(void)
+{
+	if (!otl_running)
+		return;
+
+	on_each_cpu_mask(&otl_cpus, otl_disarm, NULL, true);
+	tick_uninstall_proxy(cpu_online_mask);
+	WRITE_ONCE(trace_oob_timerlat_callback_enabled, false);
+	otl_stop_threads();
+	otl_running = false;
+}
+
+static ssize_t otl_period_read(struct file *filp, char __user *ubuf,
+			       size_t cnt, loff_t *ppos)
+{
+	char buf[24];
+	int len;
+
+	len = snprintf(buf, sizeof(buf), "%llu\n", READ_ONCE(otl_period));
+
+	return simple_read_from_buffer(ubuf, cnt, ppos, buf, len);
+}
+
+static ssize_t otl_period_write(struct file *filp, const char __user *ubuf,
+				size_t cnt, loff_t *ppos)
+{
+	u64 val;
+	int err;
+
+	err = kstrtoull_from_user(ubuf, cnt, 10, &val);
+	if (err)
+		return err;
+
+	if (val < MIN_PERIOD || val > MAX_PERIOD)
+		return -EINVAL;
+
+	/* Applies from the next shot on. */
+	WRITE_ONCE(otl_period, val);
+
+	return cnt;
+}
+
+static const struct file_operations otl_period_fops = {
+	.open		= tracing_open_generic,
+	.read		= otl_period_read,
+	.write		= otl_period_write,
+};
+
+static int otl_hist_show(struct seq_file *m, void *v)
+{
+	struct otl_cpu *oc;
+	int cpu, n;
+
+	seq_puts(m, "# ns");
+	for_each_online_cpu(cpu)
+		seq_printf(m, " CPU%d-irq CPU%d-thread", cpu, cpu);
+	seq_putc(m, '\n');
+
+	for (n = 0; n < OTL_BUCKETS; n++) {
+		seq_printf(m, "%llu", n ? 1ULL << n : 0ULL);
+		for_each_online_cpu(cpu) {
+			oc = per_cpu_ptr(&otl_cpu, cpu);
+			if (READ_ONCE(oc->reset))
+				seq_puts(m, " 0 0");
+			else
+				seq_printf(m, " %lu %lu",
+					   READ_ONCE(oc->irq_hist[n]),
+					   READ_ONCE(oc->thread_hist[n]));
+		}
+		seq_putc(m, '\n');
+	}
+
+	seq_puts(m, "# overruns");
+	for_each_online_cpu(cpu) {
+		oc = per_cpu_ptr(&otl_cpu, cpu);
+		seq_printf(m, " %lu", READ_ONCE(oc->reset) ? 0 :
+			   READ_ONCE(oc->overruns));
+	}
+	seq_putc(m, '\n');
+
+	return 0;
+}
+
+static int otl_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, otl_hist_show, NULL);
+}
+
+/*
+ * Writing anything to the histogram clears it. Each CPU does so
+ * by itself upon the next shot.
+ */
+static ssize_t otl_hist_write(struct file *file, const char __user *ubuf,
+			      size_t count, loff_t *ppos)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		WRITE_ONCE(per_cpu(otl_cpu, cpu).reset, 1);
+
+	return count;
+}
+
+static const struct file_operations otl_hist_fops = {
+	.open		= otl_hist_open,
+	.read		= seq_read,
+	.write		= otl_hist_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+/* Resumes sampling after a pause, otl_tracer_init() does the start. */
+static void otl_tracer_start(struct trace_array *tr)
+{
+	mutex_lock(&otl_lock);
+	otl_start(tr);
+	mutex_unlock(&otl_lock);
+}
+
+static void otl_tracer_stop(struct trace_array *tr)
+{
+	mutex_lock(&otl_lock);
+	otl_stop();
+	mutex_unlock(&otl_lock);
+}
+
+static bool otl_busy;
+
+static int otl_tracer_init(struct trace_array *tr)
+{
+	int ret = 0;
+
+	/* Only allow one instance to enable this */
+	if (otl_busy)
+		return -EBUSY;
+
+	otl_trace = tr;
+
+	if (tracer_tracing_is_on(tr)) {
+		mutex_lock(&otl_lock);
+		ret = otl_start(tr);
+		mutex_unlock(&otl_lock);
+		if (ret)
+			return ret;
+	}
+
+	otl_busy = true;
+
+	return 0;
+}
+
+static void otl_tracer_reset(struct trace_array *tr)
+{
+	otl_tracer_stop(tr);
+	otl_busy = false;
+}
+
+static struct tracer oob_timerlat_tracer __read_mostly =
+{
+	.name		= "oob_timerlat",
+	.init		= otl_tracer_init,
+	.reset		= otl_tracer_reset,
+	.start		= otl_tracer_start,
+	.stop		= otl_tracer_stop,
+	.allow_instances = true,
+};
+
+__init static int init_oob_timerlat_tracer(void)
+{
+	struct dentry *dir;
+	int ret;
+
+	ret = register_tracer(&oob_timerlat_tracer);
+	if (ret)
+		return ret;
+
+	ret = tracing_init_dentry();
+	if (ret)
+		return 0;
+
+	dir = tracefs_create_dir("oob_timerlat", NULL);
+	if (!dir) {
+		pr_warn("Could not create tracefs 'oob_timerlat' directory\n");
+		return 0;
+	}
+
+	trace_create_file("period_us", 0644, dir, NULL, &otl_period_fops);
+	trace_create_file("histogram", 0644, dir, NULL, &otl_hist_fops);
+
+	return 0;
+}
+late_initcall(init_oob_timerlat_tracer);
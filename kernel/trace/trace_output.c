@@ -1239,6 +1239,73 @@ static struct trace_event trace_hwlat_event = {
 	.funcs		= &trace_hwlat_funcs,
 };
 
+/* TRACE_OOB_TIMERLAT */
+static enum print_line_t
+trace_oob_timerlat_print(struct trace_iterator *iter, int flags,
+			 struct trace_event *event)
+{
+	struct trace_entry *entry = iter->ent;
+	struct trace_seq *s = &iter->seq;
+	struct oob_timerlat_entry *field;
+
+	trace_assign_type(field, entry);
+
+	trace_seq_printf(s, "#%-5u irq/thread(ns): %6llu/%-6llu",
+			 field->seqnum,
+			 field->irq_latency,
+			 field->thread_latency);
+
+	/* Noise which delayed the oob timer interrupt. */
+	if (field->irqsoff)
+		trace_seq_printf(s, " hard-irqsoff:%llu %pS",
+				 field->irqsoff, (void *)field->irqsoff_ip);
+	if (field->other)
+		trace_seq_printf(s, " other:%llu", field->other);
+
+	/* Noise which further delayed the in-band thread. */
+	if (field->nmi_count)
+		trace_seq_printf(s, " nmi:%llu/%u",
+				 field->nmi, field->nmi_count);
+	if (field->replay_count)
+		trace_seq_printf(s, " replay:%llu/%u",
+				 field->replay, field->replay_count);
+
+	trace_seq_putc(s, '\n');
+
+	return trace_handle_return(s);
+}
+
+static enum print_line_t
+trace_oob_timerlat_raw(struct trace_iterator *iter, int flags,
+		       struct trace_event *event)
+{
+	struct oob_timerlat_entry *field;
+	struct trace_seq *s = &iter->seq;
+
+	trace_assign_type(field, iter->ent);
+
+	trace_seq_printf(s, "%llu %llu %llu %llu %llu %llu %u\n",
+			 field->irq_latency,
+			 field->thread_latency,
+			 field->irqsoff,
+			 field->nmi,
+			 field->replay,
+			 field->other,
+			 field->seqnum);
+
+	return trace_handle_return(s);
+}
+
+static struct trace_event_functions trace_oob_timerlat_funcs = {
+	.trace		= trace_oob_timerlat_print,
+	.raw		= trace_oob_timerlat_raw,
+};
+
+static struct trace_event trace_oob_timerlat_event = {
+	.type		= TRACE_OOB_TIMERLAT,
+	.funcs		= &trace_oob_timerlat_funcs,
+};
+
 /* TRACE_BPUTS */
 static enum print_line_t
 trace_bputs_print(struct trace_iterator *iter, int flags,
@@ -1449,6 +1516,7 @@ static struct trace_event *events[] __initdata = {
 	&trace_bprint_event,
 	&trace_print_event,
 	&trace_hwlat_event,
+	&trace_oob_timerlat_event,
 	&trace_raw_data_event,
 	&trace_func_repeats_event,
 	NULL
@@ -0,0 +1,310 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Microbenchmarks of the Dovetail stage transitions.
+ *
+ * Reading a benchmark file under <debugfs>/dovetail_bench runs
+ * @loops iterations of the corresponding transition from a kthread
+ * pinned to @cpu, then reports the cost distribution in get_cycles()
+ * units. tools/testing/selftests/dovetail drives this module.
+ */
+
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/kthread.h>
+#include <linux/completion.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/mutex.h>
+#include <linux/sort.h>
+#include <linux/vmalloc.h>
+#include <linux/log2.h>
+#include <linux/ptrace.h>
+#include <linux/irq_pipeline.h>
+#include <linux/dovetail.h>
+#include <asm/timex.h>
+
+#define BENCH_HIST_BUCKETS	32
+
+static u32 loops = 10000;
+static u32 bench_cpu;
+
+static DEFINE_MUTEX(bench_lock);
+
+static struct dentry *bench_dir;
+
+static bool bench_owns_stage;
+
+struct bench_run {
+	const struct dovetail_bench *bench;
+	struct completion done;
+	cycles_t *samples;
+	unsigned int count;
+	int ret;
+};
+
+struct dovetail_bench {
+	const char *name;
+	int (*prepare)(void);
+	void (*finish)(void);
+	cycles_t (*run)(void);
+};
+
+/*
+ * Round trip through the oob stage, which is the interrupt stage
+ * switch dovetail_leave_inband() and dovetail_resume_inband()
+ * perform for the current CPU.
+ */
+static int oob_nop(void *arg)
+{
+	return 0;
+}
+
+static cycles_t bench_stage_switch(void)
+{
+	cycles_t start = get_cycles();
+
+	run_oob_call(oob_nop, NULL);
+
+	return get_cycles() - start;
+}
+
+/*
+ * Trap notification and unwinding from the oob stage, as done on
+ * entry to and exit from a fault handler. The companion core is
+ * notified only if it enabled Dovetail, otherwise this measures the
+ * bare fast path.
+ */
+struct trap_sample {
+	struct pt_regs regs;
+	cycles_t cycles;
+};
+
+static int oob_trap(void *arg)
+{
+	struct trap_sample *s = arg;
+	cycles_t start = get_cycles();
+
+	oob_trap_notify(0, &s->regs);
+	oob_trap_unwind(0, &s->regs);
+	s->cycles = get_cycles() - start;
+
+	return 0;
+}
+
+static cycles_t bench_trap_notify(void)
+{
+	struct trap_sample s = { };
+
+	run_oob_call(oob_trap, &s);
+
+	return s.cycles;
+}
+
+/*
+ * Mayday posting and delivery. The bench kthread must be dovetailed
+ * for dovetail_send_mayday() to raise TIF_MAYDAY.
+ */
+static struct dovetail_altsched_context bench_altsched;
+
+static int prepare_mayday(void)
+{
+	dovetail_init_altsched(&bench_altsched);
+	dovetail_start_altsched();
+
+	return 0;
+}
+
+static void finish_mayday(void)
+{
+	dovetail_stop_altsched();
+}
+
+static cycles_t bench_mayday(void)
+{
+	struct pt_regs regs = { };
+	cycles_t start = get_cycles();
+
+	dovetail_send_mayday(current);
+	dovetail_call_mayday(&regs);
+
+	return get_cycles() - start;
+}
+
+static const struct dovetail_bench benches[] = {
+	{
+		.name = "stage_switch",
+		.run = bench_stage_switch,
+	},
+	{
+		.name = "trap_notify",
+		.run = bench_trap_notify,
+	},
+	{
+		.name = "mayday",
+		.prepare = prepare_mayday,
+		.finish = finish_mayday,
+		.run = bench_mayday,
+	},
+};
+
+static int bench_thread(void *arg)
+{
+	struct bench_run *r = arg;
+	const struct dovetail_bench *b = r->bench;
+	unsigned int n;
+
+	if (b->prepare) {
+		r->ret = b->prepare();
+		if (r->ret)
+			goto out;
+	}
+
+	for (n = 0; n < r->count; n++) {
+		r->samples[n] = b->run();
+		cond_resched();
+	}
+
+	if (b->finish)
+		b->finish();
+out:
+	/* Never return to module text which rmmod may have freed. */
+	complete_and_exit(&r->done, 0);
+}
+
+static int cmp_cycles(const void *a, const void *b)
+{
+	cycles_t x = *(const cycles_t *)a, y = *(const cycles_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static cycles_t percentile(struct bench_run *r, unsigned int permille)
+{
+	return r->samples[(u64)(r->count - 1) * permille / 1000];
+}
+
+static void report(struct seq_file *m, struct bench_run *r)
+{
+	unsigned int hist[BENCH_HIST_BUCKETS] = { 0 }, n, b;
+	u64 sum = 0;
+
+	sort(r->samples, r->count, sizeof(cycles_t), cmp_cycles, NULL);
+
+	for (n = 0; n < r->count; n++) {
+		sum += r->samples[n];
+		b = r->samples[n] ? ilog2(r->samples[n]) + 1 : 0;
+		hist[min_t(unsigned int, b, BENCH_HIST_BUCKETS - 1)]++;
+	}
+
+	seq_printf(m, "samples %u\n", r->count);
+	seq_printf(m, "min %llu\n", (u64)r->samples[0]);
+	seq_printf(m, "avg %llu\n", div_u64(sum, r->count));
+	seq_printf(m, "p50 %llu\n", (u64)percentile(r, 500));
+	seq_printf(m, "p90 %llu\n", (u64)percentile(r, 900));
+	seq_printf(m, "p99 %llu\n", (u64)percentile(r, 990));
+	seq_printf(m, "p999 %llu\n", (u64)percentile(r, 999));
+	seq_printf(m, "max %llu\n", (u64)r->samples[r->count - 1]);
+
+	/* Log2 buckets: "hist <lower bound> <count>". */
+	for (b = 0; b < BENCH_HIST_BUCKETS; b++)
+		if (hist[b])
+			seq_printf(m, "hist %llu %u\n",
+				   b ? 1ULL << (b - 1) : 0ULL, hist[b]);
+}
+
+static int bench_show(struct seq_file *m, void *v)
+{
+	struct bench_run r = {
+		.bench = m->private,
+	};
+	struct task_struct *t;
+	int ret;
+
+	mutex_lock(&bench_lock);
+
+	r.count = READ_ONCE(loops);
+	if (!r.count || bench_cpu >= nr_cpu_ids || !cpu_online(bench_cpu)) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	r.samples = vmalloc(array_size(r.count, sizeof(cycles_t)));
+	if (!r.samples) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	init_completion(&r.done);
+	t = kthread_create_on_cpu(bench_thread, &r, bench_cpu, "dovetail_bench/%u");
+	if (IS_ERR(t)) {
+		ret = PTR_ERR(t);
+		goto out_free;
+	}
+
+	wake_up_process(t);
+	wait_for_completion(&r.done);
+
+	ret = r.ret;
+	if (!ret)
+		report(m, &r);
+out_free:
+	vfree(r.samples);
+out:
+	mutex_unlock(&bench_lock);
+
+	return ret;
+}
+
+static int bench_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, bench_show, inode->i_private);
+}
+
+static const struct file_operations bench_fops = {
+	.owner		= THIS_MODULE,
+	.open		= bench_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init test_dovetail_init(void)
+{
+	int n, ret;
+
+	/*
+	 * Benchmarks escalate to the oob stage, borrow it unless a
+	 * companion core installed its own.
+	 */
+	if (!oob_stage_present()) {
+		ret = enable_oob_stage("dovetail-bench");
+		if (ret)
+			return ret;
+		bench_owns_stage = true;
+	}
+
+	bench_dir = debugfs_create_dir("dovetail_bench", NULL);
+	debugfs_create_u32("loops", 0644, bench_dir, &loops);
+	debugfs_create_u32("cpu", 0644, bench_dir, &bench_cpu);
+
+	for (n = 0; n < ARRAY_SIZE(benches); n++)
+		debugfs_create_file(benches[n].name, 0444, bench_dir,
+				    (void *)&benches[n], &bench_fops);
+
+	return 0;
+}
+module_init(test_dovetail_init);
+
+static void __exit test_dovetail_exit(void)
+{
+	debugfs_remove_recursive(bench_dir);
+
+	if (bench_owns_stage)
+		disable_oob_stage();
+}
+module_exit(test_dovetail_exit);
+
+MODULE_DESCRIPTION("Dovetail stage transition benchmarks");
+MODULE_LICENSE("GPL");
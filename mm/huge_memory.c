@@ -19,6 +19,7 @@
 #include <linux/mm_inline.h>
 #include <linux/swapops.h>
 #include <linux/dax.h>
+#include <linux/dovetail.h>
 #include <linux/khugepaged.h>
 #include <linux/freezer.h>
 #include <linux/pfn_t.h>
@@ -2651,6 +2652,49 @@ bool can_split_huge_page(struct page *page, int *pextra_pins)
 	return total_mapcount(page) == page_count(page) - extra_pins - 1;
 }
 
+#ifdef CONFIG_DOVETAIL
+
+static bool thp_dovetailed_one(struct page *page, struct vm_area_struct *vma,
+			       unsigned long address, void *arg)
+{
+	bool *dovetailed = arg;
+
+	if (!dovetailed_mm(vma->vm_mm))
+		return true;
+
+	*dovetailed = true;
+
+	return false;
+}
+
+/*
+ * Whether a process running oob threads maps @head. Freezing the
+ * page would replace its mappings with migration entries, which oob
+ * threads would fault on. The rmap lock must be held.
+ */
+static bool thp_mapped_dovetailed(struct page *head)
+{
+	bool dovetailed = false;
+	struct rmap_walk_control rwc = {
+		.rmap_one = thp_dovetailed_one,
+		.arg = &dovetailed,
+	};
+
+	if (page_mapped(head))
+		rmap_walk_locked(head, &rwc);
+
+	return dovetailed;
+}
+
+#else
+
+static inline bool thp_mapped_dovetailed(struct page *head)
+{
+	return false;
+}
+
+#endif
+
 /*
  * This function splits huge page into normal pages. @page can point to any
  * subpage of huge page to split. Split doesn't change the position of @page.
@@ -2734,6 +2778,16 @@ int split_huge_page_to_list(struct page *page, struct list_head *list)
 		goto out_unlock;
 	}
 
+	/*
+	 * Dovetail: leave the pages of dovetailed mms alone. Callers
+	 * which need the page gone, such as CMA allocations or memory
+	 * offlining, fail or retry on it.
+	 */
+	if (thp_mapped_dovetailed(head)) {
+		ret = -EBUSY;
+		goto out_unlock;
+	}
+
 	unmap_page(head);
 
 	/* block interrupt reentry in xa_lock and spinlock */
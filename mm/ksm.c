@@ -2283,7 +2283,8 @@ static struct rmap_item *scan_get_next_rmap_item(struct page **page)
 
 	mm = slot->mm;
 	mmap_read_lock(mm);
-	if (ksm_test_exit(mm))
+	/* Merged pages would COW upon write from an oob thread. */
+	if (ksm_test_exit(mm) || dovetailed_mm(mm))
 		vma = NULL;
 	else
 		vma = find_vma(mm, ksm_scan.address);
@@ -2449,6 +2450,9 @@ int ksm_madvise(struct vm_area_struct *vma, unsigned long start,
 		if (vma_is_dax(vma))
 			return 0;
 
+		if (dovetailed_mm(mm))
+			return 0;
+
 #ifdef VM_SAO
 		if (*vm_flags & VM_SAO)
 			return 0;
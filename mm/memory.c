@@ -831,8 +831,7 @@ copy_present_page(struct vm_area_struct *dst_vma, struct vm_area_struct *src_vma
 	 * it: make sure the child gets its own copy of the page.
 	 */
 	if (likely(!page_needs_cow_for_dma(src_vma, page) &&
-			(!dovetailing() || !test_bit(MMF_DOVETAILED,
-						&src_vma->vm_mm->flags))))
+		   !dovetailed_mm(src_vma->vm_mm)))
 		return 1;
 
 	new_page = *prealloc;
@@ -4639,6 +4638,11 @@ vm_fault_t handle_mm_fault(struct vm_area_struct *vma, unsigned long address,
 
 	count_vm_event(PGFAULT);
 	count_memcg_event_mm(vma->vm_mm, PGFAULT);
+#ifdef CONFIG_DOVETAIL
+	/* The oob stage should never fault, account for misses. */
+	if (test_thread_local_flags(_TLF_OOBTRAP))
+		count_vm_event(PGFAULT_OOB);
+#endif
 
 	/* do counter updates before entering really critical section. */
 	check_sync_rss_stat(current);
@@ -771,15 +771,11 @@ static int apply_mlockall_flags(int flags)
 	return 0;
 }
 
-SYSCALL_DEFINE1(mlockall, int, flags)
+int do_mlockall(int flags)
 {
 	unsigned long lock_limit;
 	int ret;
 
-	if (!flags || (flags & ~(MCL_CURRENT | MCL_FUTURE | MCL_ONFAULT)) ||
-	    flags == MCL_ONFAULT)
-		return -EINVAL;
-
 	if (!can_do_mlock())
 		return -EPERM;
 
@@ -800,6 +796,15 @@ SYSCALL_DEFINE1(mlockall, int, flags)
 	return ret;
 }
 
+SYSCALL_DEFINE1(mlockall, int, flags)
+{
+	if (!flags || (flags & ~(MCL_CURRENT | MCL_FUTURE | MCL_ONFAULT)) ||
+	    flags == MCL_ONFAULT)
+		return -EINVAL;
+
+	return do_mlockall(flags);
+}
+
 SYSCALL_DEFINE0(munlockall)
 {
 	int ret;
@@ -1419,6 +1419,19 @@ static bool try_to_unmap_one(struct page *page, struct vm_area_struct *vma,
 	    is_zone_device_page(page) && !is_device_private_page(page))
 		return true;
 
+	/*
+	 * Dovetail: an oob thread touching a page under migration
+	 * would fault on the migration entry and be demoted to the
+	 * in-band stage. Keep the page mapped, which causes the
+	 * migration to fail. THP splits are refused earlier by
+	 * split_huge_page_to_list(), which expects the page to be
+	 * fully unmapped once frozen.
+	 */
+	if ((flags & TTU_MIGRATION) && dovetailed_mm(mm)) {
+		count_vm_event(PGMIGRATE_FENCED);
+		return false;
+	}
+
 	if (flags & TTU_SPLIT_HUGE_PMD) {
 		split_huge_pmd_address(vma, address,
 				flags & TTU_SPLIT_FREEZE, page);
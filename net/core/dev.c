@@ -4913,14 +4913,54 @@ __weak int netif_xmit_oob(struct sk_buff *skb)
 	return NET_XMIT_DROP;
 }
 
+/*
+ * Run the oob filter of @dev on @skb from the in-band receive path,
+ * before the frame reaches the in-band stack. The verdict follows the
+ * TC direct-action convention: TC_ACT_OK hands the frame over to the
+ * oob stack, TC_ACT_SHOT drops it, anything else steers it to the
+ * in-band stack. Frames go oob if no filter is attached.
+ */
+static int netif_run_oob_filter(struct net_device *dev, struct sk_buff *skb)
+{
+	struct bpf_prog *prog;
+	int ret = TC_ACT_OK;
+	int mac_len;
+
+	check_inband_stage();
+
+	rcu_read_lock();
+
+	prog = rcu_dereference(dev->oob_context.filter);
+	if (prog) {
+		mac_len = skb->data - skb_mac_header(skb);
+		__skb_push(skb, mac_len);
+		bpf_compute_data_pointers(skb);
+		ret = bpf_dispatcher_nop_func(skb, prog->insnsi, prog->bpf_func);
+		__skb_pull(skb, mac_len);
+	}
+
+	rcu_read_unlock();
+
+	return ret;
+}
+
 static bool netif_receive_oob(struct sk_buff *skb)
 {
 	struct net_device *dev = skb->dev;
 
-	if (dev && netif_oob_diversion(dev))
-		return netif_oob_deliver(skb);
+	if (!dev || !netif_oob_diversion(dev))
+		return false;
 
-	return false;
+	switch (netif_run_oob_filter(dev, skb)) {
+	case TC_ACT_OK:
+		return netif_oob_deliver(skb);
+	case TC_ACT_SHOT:
+		/* Frames from the oob pool are recycled to it. */
+		kfree_skb(skb);
+		return true;
+	default:
+		return false;
+	}
 }
 
 static bool netif_receive_oob_list(struct list_head *head)
@@ -4935,13 +4975,68 @@ static bool netif_receive_oob_list(struct list_head *head)
 	if (!dev || !netif_oob_diversion(dev))
 		return false;
 
-	/* Callee dequeues every skb it consumes. */
-	list_for_each_entry_safe(skb, next, head, list)
-		netif_oob_deliver(skb);
+	/*
+	 * Callee dequeues every skb it consumes, frames steered
+	 * in-band are left in the list.
+	 */
+	list_for_each_entry_safe(skb, next, head, list) {
+		switch (netif_run_oob_filter(dev, skb)) {
+		case TC_ACT_OK:
+			netif_oob_deliver(skb);
+			break;
+		case TC_ACT_SHOT:
+			skb_list_del_init(skb);
+			kfree_skb(skb);
+			break;
+		}
+	}
 
 	return list_empty(head);
 }
 
+/**
+ *	netif_set_oob_filter - attach a BPF filter to the oob diversion point
+ *	@dev: device
+ *	@fd: file descriptor of a BPF_PROG_TYPE_SCHED_CLS program loaded
+ *	     with BPF_F_OOB, or a negative value to detach the current one
+ *
+ *	The filter classifies every frame received on @dev while oob
+ *	diversion is enabled, see netif_run_oob_filter(). Only JITed
+ *	programs are accepted, so that the oob receive path does not
+ *	depend on the interpreter. Caller must hold the RTNL.
+ */
+int netif_set_oob_filter(struct net_device *dev, int fd)
+{
+	struct bpf_prog *prog = NULL, *old;
+
+	ASSERT_RTNL();
+
+	if (fd >= 0) {
+		prog = bpf_prog_get_type(fd, BPF_PROG_TYPE_SCHED_CLS);
+		if (IS_ERR(prog))
+			return PTR_ERR(prog);
+		if (!prog->aux->oob || !prog->jited) {
+			bpf_prog_put(prog);
+			return -EINVAL;
+		}
+	}
+
+	old = rcu_replace_pointer(dev->oob_context.filter, prog,
+				  lockdep_rtnl_is_held());
+	if (old) {
+		synchronize_rcu();
+		bpf_prog_put(old);
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(netif_set_oob_filter);
+
+static void netif_uninstall_oob_filter(struct net_device *dev)
+{
+	netif_set_oob_filter(dev, -1);
+}
+
 __weak void netif_oob_run(struct net_device *dev)
 { }
 
@@ -4974,6 +5069,9 @@ static inline void napi_complete_oob(struct napi_struct *n)
 static inline void skb_inband_xmit_backlog(void)
 { }
 
+static inline void netif_uninstall_oob_filter(struct net_device *dev)
+{ }
+
 #endif
 
 static int netif_rx_internal(struct sk_buff *skb)
@@ -11143,6 +11241,7 @@ void unregister_netdevice_many(struct list_head *head)
 		dev_shutdown(dev);
 
 		dev_xdp_uninstall(dev);
+		netif_uninstall_oob_filter(dev);
 
 		/* Notify protocols, that we are about to destroy
 		 * this device. They should clean all the things.
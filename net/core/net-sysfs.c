@@ -5,6 +5,7 @@
  * Copyright (c) 2003 Stephen Hemminger <shemminger@osdl.org>
  */
 
+#include <linux/bpf.h>
 #include <linux/capability.h>
 #include <linux/kernel.h>
 #include <linux/netdevice.h>
@@ -412,6 +413,52 @@ static ssize_t oob_pool_show(struct device *dev,
 }
 static DEVICE_ATTR_RO(oob_pool);
 
+static ssize_t oob_filter_store(struct device *dev,
+				struct device_attribute *attr,
+				const char *buf, size_t len)
+{
+	struct net_device *netdev = to_net_dev(dev);
+	struct net *net = dev_net(netdev);
+	int fd, ret;
+
+	if (!ns_capable(net->user_ns, CAP_NET_ADMIN))
+		return -EPERM;
+
+	/* A BPF program fd, or -1 to detach. */
+	ret = kstrtoint(buf, 0, &fd);
+	if (ret)
+		return ret;
+
+	if (!rtnl_trylock())
+		return restart_syscall();
+
+	if (dev_isalive(netdev)) {
+		ret = netif_set_oob_filter(netdev, fd);
+		if (ret == 0)
+			ret = len;
+	}
+	rtnl_unlock();
+
+	return ret;
+}
+
+static ssize_t oob_filter_show(struct device *dev,
+			struct device_attribute *attr, char *buf)
+{
+	struct net_device *netdev = to_net_dev(dev);
+	struct bpf_prog *prog;
+	u32 id = 0;
+
+	rcu_read_lock();
+	prog = rcu_dereference(netdev->oob_context.filter);
+	if (prog)
+		id = prog->aux->id;
+	rcu_read_unlock();
+
+	return sprintf(buf, "%u\n", id);
+}
+static DEVICE_ATTR_RW(oob_filter);
+
 #endif
 
 static int change_gro_flush_timeout(struct net_device *dev, unsigned long val)
@@ -661,6 +708,7 @@ static struct attribute *net_class_attrs[] __ro_after_init = {
 #ifdef CONFIG_NET_OOB
 	&dev_attr_oob_port.attr,
 	&dev_attr_oob_pool.attr,
+	&dev_attr_oob_filter.attr,
 #endif
 	NULL,
 };
@@ -1094,6 +1094,15 @@ enum bpf_link_type {
  */
 #define BPF_F_SLEEPABLE		(1U << 4)
 
+/* If BPF_F_OOB is used in BPF_PROG_LOAD command, the verifier will
+ * restrict map and helper usage to those which are safe to use from the
+ * out-of-band interrupt stage (Dovetail). Only such programs run from
+ * tracepoints hit on the out-of-band stage, others are skipped there.
+ * BPF_PROG_TYPE_SCHED_CLS programs need it to be attached as the oob
+ * receive filter of a network device.
+ */
+#define BPF_F_OOB		(1U << 5)
+
 /* When BPF ldimm64's insn[0].src_reg != 0 then this can have
  * the following extensions:
  *
@@ -4137,6 +4146,9 @@ union bpf_attr {
  *		* **BPF_RB_RING_SIZE**: The size of ring buffer.
  *		* **BPF_RB_CONS_POS**: Consumer position (can wrap around).
  *		* **BPF_RB_PROD_POS**: Producer(s) position (can wrap around).
+ *		* **BPF_RB_DROPPED**: Number of records dropped because
+ *		  an NMI or out-of-band producer found the ring buffer
+ *		  busy.
  *
  *		Data returned is just a momentary snapshot of actual values
  *		and could be inaccurate, so this facility should be used to
@@ -5041,6 +5053,7 @@ enum {
 	BPF_RB_RING_SIZE = 1,
 	BPF_RB_CONS_POS = 2,
 	BPF_RB_PROD_POS = 3,
+	BPF_RB_DROPPED = 4,
 };
 
 /* BPF ring buffer constants */
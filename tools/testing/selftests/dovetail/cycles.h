@@ -0,0 +1,113 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Cycle counter access and distribution reporting for the Dovetail
+ * benchmarks. Distributions are printed as TAP diagnostics, using
+ * the same keys as the test_dovetail module.
+ */
+#ifndef _DOVETAIL_CYCLES_H
+#define _DOVETAIL_CYCLES_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__riscv)
+static inline uint64_t read_cycles(void)
+{
+	uint64_t c;
+
+	asm volatile("rdcycle %0" : "=r" (c));
+	return c;
+}
+#elif defined(__aarch64__)
+static inline uint64_t read_cycles(void)
+{
+	uint64_t c;
+
+	asm volatile("isb; mrs %0, cntvct_el0" : "=r" (c) :: "memory");
+	return c;
+}
+#elif defined(__x86_64__) || defined(__i386__)
+static inline uint64_t read_cycles(void)
+{
+	uint32_t lo, hi;
+
+	asm volatile("lfence; rdtsc" : "=a" (lo), "=d" (hi) :: "memory");
+	return ((uint64_t)hi << 32) | lo;
+}
+#else
+/* No user-readable counter, fall back to nanoseconds. */
+static inline uint64_t read_cycles(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+#endif
+
+#define HIST_BUCKETS	32
+
+struct cycle_stats {
+	uint64_t min, avg, p50, p90, p99, p999, max;
+};
+
+static int cmp_cycles(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static inline uint64_t percentile(const uint64_t *s, unsigned int n,
+				  unsigned int permille)
+{
+	return s[(uint64_t)(n - 1) * permille / 1000];
+}
+
+/* Sorts @samples, prints the distribution, returns the summary. */
+static inline struct cycle_stats report_cycles(const char *name,
+					       uint64_t *samples,
+					       unsigned int n)
+{
+	unsigned int hist[HIST_BUCKETS] = { 0 }, i, b;
+	struct cycle_stats st;
+	uint64_t sum = 0;
+
+	qsort(samples, n, sizeof(*samples), cmp_cycles);
+
+	for (i = 0; i < n; i++) {
+		sum += samples[i];
+		b = samples[i] ? 64 - __builtin_clzll(samples[i]) : 0;
+		hist[b < HIST_BUCKETS ? b : HIST_BUCKETS - 1]++;
+	}
+
+	st.min = samples[0];
+	st.avg = sum / n;
+	st.p50 = percentile(samples, n, 500);
+	st.p90 = percentile(samples, n, 900);
+	st.p99 = percentile(samples, n, 990);
+	st.p999 = percentile(samples, n, 999);
+	st.max = samples[n - 1];
+
+	printf("# %s:\n", name);
+	printf("#   samples %u\n", n);
+	printf("#   min %llu\n", (unsigned long long)st.min);
+	printf("#   avg %llu\n", (unsigned long long)st.avg);
+	printf("#   p50 %llu\n", (unsigned long long)st.p50);
+	printf("#   p90 %llu\n", (unsigned long long)st.p90);
+	printf("#   p99 %llu\n", (unsigned long long)st.p99);
+	printf("#   p999 %llu\n", (unsigned long long)st.p999);
+	printf("#   max %llu\n", (unsigned long long)st.max);
+
+	/* Log2 buckets: "hist <lower bound> <count>". */
+	for (b = 0; b < HIST_BUCKETS; b++)
+		if (hist[b])
+			printf("#   hist %llu %u\n",
+			       b ? 1ULL << (b - 1) : 0ULL, hist[b]);
+
+	return st;
+}
+
+#endif /* _DOVETAIL_CYCLES_H */
@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Cost of an oob syscall propagated through __pipeline_syscall().
+ *
+ * A syscall carrying __OOB_SYSCALL_BIT issued by a regular thread is
+ * handed over to the companion core first, then flows down to the
+ * in-band dispatcher if the core does not handle it. This measures
+ * that round trip against the same in-band syscall issued natively.
+ *
+ * Usage: oob_syscall_bench [-n loops] [-t max_p99_overhead_cycles]
+ *
+ * With -t, the test fails if the p99 overhead of the pipelined
+ * syscall over the native one exceeds the given number of cycles.
+ * The pipelined part is skipped on kernels without Dovetail.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+
+#include "../kselftest.h"
+#include "cycles.h"
+
+/* From include/uapi/asm-generic/dovetail.h */
+#ifndef __OOB_SYSCALL_BIT
+#define __OOB_SYSCALL_BIT	0x10000000
+#endif
+
+#define DEFAULT_LOOPS	100000
+
+static bool config_has_dovetail(FILE *fp)
+{
+	char line[256];
+
+	while (fgets(line, sizeof(line), fp))
+		if (!strcmp(line, "CONFIG_DOVETAIL=y\n"))
+			return true;
+
+	return false;
+}
+
+/*
+ * The test_dovetail module tells for sure, otherwise look for
+ * CONFIG_DOVETAIL in the kernel configuration.
+ */
+static bool dovetail_present(void)
+{
+	char path[PATH_MAX];
+	struct utsname u;
+	bool ret = false;
+	FILE *fp;
+
+	if (!access("/sys/kernel/debug/dovetail_bench", F_OK))
+		return true;
+
+	fp = popen("zcat /proc/config.gz 2>/dev/null", "r");
+	if (fp) {
+		ret = config_has_dovetail(fp);
+		pclose(fp);
+		if (ret)
+			return true;
+	}
+
+	if (uname(&u))
+		return false;
+
+	snprintf(path, sizeof(path), "/boot/config-%s", u.release);
+	fp = fopen(path, "r");
+	if (fp) {
+		ret = config_has_dovetail(fp);
+		fclose(fp);
+	}
+
+	return ret;
+}
+
+static void bench(uint64_t *samples, unsigned int loops, long nr)
+{
+	uint64_t start;
+	unsigned int n;
+
+	for (n = 0; n < loops; n++) {
+		start = read_cycles();
+		syscall(nr);
+		samples[n] = read_cycles() - start;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int loops = DEFAULT_LOOPS;
+	struct cycle_stats native, oob;
+	long long max_overhead = -1;
+	uint64_t *samples;
+	cpu_set_t cpus;
+	long ret;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:t:")) != -1) {
+		switch (opt) {
+		case 'n':
+			loops = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			max_overhead = strtoll(optarg, NULL, 0);
+			break;
+		default:
+			fprintf(stderr,
+				"usage: %s [-n loops] [-t max_p99_overhead]\n",
+				argv[0]);
+			return KSFT_FAIL;
+		}
+	}
+
+	if (!loops)
+		ksft_exit_fail_msg("loop count must be positive\n");
+
+	ksft_print_header();
+	ksft_set_plan(2);
+
+	/* Stay on one CPU, the counters may not be synchronized. */
+	CPU_ZERO(&cpus);
+	CPU_SET(sched_getcpu(), &cpus);
+	if (sched_setaffinity(0, sizeof(cpus), &cpus))
+		ksft_exit_fail_msg("sched_setaffinity: %s\n", strerror(errno));
+
+	samples = calloc(loops, sizeof(*samples));
+	if (!samples)
+		ksft_exit_fail_msg("out of memory\n");
+
+	bench(samples, loops, __NR_getppid);
+	native = report_cycles("native getppid", samples, loops);
+	ksft_test_result_pass("native syscall\n");
+
+	if (!dovetail_present()) {
+		ksft_test_result_skip("kernel without Dovetail\n");
+		goto out;
+	}
+
+	/*
+	 * Whatever the companion core makes of it, the syscall goes
+	 * through the pipeline entry, which is what we time.
+	 */
+	ret = syscall(__OOB_SYSCALL_BIT | __NR_getppid);
+	printf("# pipelined getppid returned %ld\n", ret);
+
+	bench(samples, loops, __OOB_SYSCALL_BIT | __NR_getppid);
+	oob = report_cycles("pipelined getppid", samples, loops);
+
+	printf("# p99 overhead %lld\n", (long long)(oob.p99 - native.p99));
+
+	if (max_overhead >= 0 &&
+	    (long long)(oob.p99 - native.p99) > max_overhead)
+		ksft_test_result_fail("pipelined syscall p99 overhead above %lld\n",
+				      max_overhead);
+	else
+		ksft_test_result_pass("pipelined syscall\n");
+out:
+	free(samples);
+
+	if (ksft_get_fail_cnt())
+		ksft_exit_fail();
+
+	ksft_exit_pass();
+}
@@ -0,0 +1,68 @@
+#!/bin/sh
+# SPDX-License-Identifier: GPL-2.0
+#
+# Run the stage transition benchmarks of the test_dovetail module:
+# oob stage switch, oob trap notification and mayday delivery.
+#
+# Environment:
+#   LOOPS         iterations per benchmark (default 100000)
+#   BENCH_CPU     CPU to run the benchmarks on (default 0)
+#   MAX_P99_<B>   fail benchmark <B> (e.g. MAX_P99_STAGE_SWITCH) if its
+#                 p99 cost in get_cycles() units exceeds this value
+
+ksft_skip=4
+
+LOOPS=${LOOPS:-100000}
+BENCH_CPU=${BENCH_CPU:-0}
+
+DEBUGFS=$(grep -w debugfs /proc/mounts | awk '{ print $2 }' | head -n 1)
+DIR=$DEBUGFS/dovetail_bench
+
+if [ "$(id -u)" -ne 0 ]; then
+	echo "SKIP: must be run as root"
+	exit $ksft_skip
+fi
+
+if [ -z "$DEBUGFS" ]; then
+	echo "SKIP: debugfs is not mounted"
+	exit $ksft_skip
+fi
+
+loaded=0
+if [ ! -d "$DIR" ]; then
+	if ! modprobe -q test_dovetail; then
+		echo "SKIP: test_dovetail module not available"
+		exit $ksft_skip
+	fi
+	loaded=1
+fi
+
+echo "$LOOPS" > "$DIR/loops"
+echo "$BENCH_CPU" > "$DIR/cpu"
+
+ret=0
+for bench in stage_switch trap_notify mayday; do
+	out=$(cat "$DIR/$bench")
+	if [ $? -ne 0 ]; then
+		echo "FAIL: $bench"
+		ret=1
+		continue
+	fi
+
+	echo "$bench:"
+	echo "$out" | sed 's/^/  /'
+
+	var=MAX_P99_$(echo "$bench" | tr '[:lower:]' '[:upper:]')
+	eval max=\$$var
+	p99=$(echo "$out" | awk '$1 == "p99" { print $2 }')
+	if [ -n "$max" ] && [ "$p99" -gt "$max" ]; then
+		echo "FAIL: $bench p99 $p99 above $max"
+		ret=1
+	else
+		echo "PASS: $bench"
+	fi
+done
+
+[ $loaded -eq 1 ] && rmmod test_dovetail
+
+exit $ret